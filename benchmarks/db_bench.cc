@@ -12,15 +12,21 @@
 
 #include <sys/types.h>
 
+#include <algorithm>
 #include <atomic>
+#include <cmath>
 #include <cstdio>
 #include <cstdlib>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include "leveldb/cache.h"
 #include "leveldb/comparator.h"
 #include "leveldb/db.h"
 #include "leveldb/env.h"
 #include "leveldb/filter_policy.h"
+#include "leveldb/rate_limiter.h"
 #include "leveldb/write_batch.h"
 #include "port/port.h"
 #include "util/crc32c.h"
@@ -29,7 +35,6 @@
 #include "util/random.h"
 #include "util/testutil.h"
 #include "leveldb/Remix.h"
-#include "leveldb/RemixIterator.h"
 
 // Comma-separated list of operations to run in the specified order
 //   Actual benchmarks:
@@ -42,11 +47,16 @@
 //      deleterandom  -- delete N keys in random order
 //      readseq       -- read N times sequentially
 //      readreverse   -- read N times in reverse order
+//      readreverse_Remix -- readreverse through the view of "create view"
 //      readrandom    -- read N times in random order
+//      multireadrandom -- readrandom with MultiGet() batches of 100 keys
 //      readmissing   -- read N missing keys in random order
 //      readhot       -- read N times in random order from 1% section of DB
 //      seekrandom    -- N random seeks
 //      seekordered   -- N ordered seeks
+//      seeknext_Leveldb -- seek to a key drawn from --seek_distribution and
+//                          read the next entries, once per --scan_lengths
+//      seeknext_Remix   -- seeknext_Leveldb through the view of "create view"
 //      open          -- cost of opening a DB
 //      crc32c        -- repeated crc32c of 4K of data
 //   Meta operations:
@@ -95,6 +105,7 @@ static const char* FLAGS_benchmarks =
     //"create view,"
     //"readseq_Remix,"    // 按正向顺序读
     // "readreverse,"  // 按逆向顺序读
+    //"readreverse_Remix,"
     // "compact,"    
     // "readrandom,"
     // "readseq_Leveldb,"
@@ -128,6 +139,21 @@ static double FLAGS_compression_ratio = 0.5;
 // 打印操作时间的直方图
 static bool FLAGS_histogram = false;
 
+// If true, report every benchmark as one JSON object per line
+static bool FLAGS_json = false;
+
+// Comma-separated numbers of entries read after each seek by the seeknext
+// benchmarks; each length is run and reported separately.
+static const char* FLAGS_scan_lengths = "1,10,100,1000,10000";
+
+// Distribution of the seek keys of the seeknext benchmarks: "uniform", or
+// "zipfian" with skew FLAGS_zipf_theta, where the lowest keys are hottest.
+static const char* FLAGS_seek_distribution = "uniform";
+static double FLAGS_zipf_theta = 0.99;
+
+// If true, serve DB iterators from the REMIX view (Options::use_remix)
+static bool FLAGS_use_remix = false;
+
 // Count the number of string comparisons performed
 // 统计执行的字符串比较次数
 static bool FLAGS_comparisons = false;
@@ -136,6 +162,30 @@ static bool FLAGS_comparisons = false;
 // (initialized to default value by "main")
 static int FLAGS_write_buffer_size = 0;
 
+// Number of full write buffers that may wait for a flush.
+// Negative means use default settings.
+static int FLAGS_max_immutable_memtables = -1;
+
+// Number of compactions that may run at the same time.
+// Negative means use default settings.
+static int FLAGS_max_background_compactions = -1;
+
+// Number of threads that may share one compaction.
+// Negative means use default settings.
+static int FLAGS_max_subcompactions = -1;
+
+// Bytes per second that flushes and compactions may write.
+// Zero means no limit.
+static int FLAGS_rate_limit = 0;
+
+// If true, --rate_limit is an upper bound and the rate follows the
+// pending compaction bytes.
+static bool FLAGS_rate_limit_auto_tune = false;
+
+// Values of at least this many bytes are kept in blob files.
+// Zero keeps all values in the tables.
+static int FLAGS_blob_value_threshold = 0;
+
 // Number of bytes written to each file.
 // (initialized to default value by "main")
 static int FLAGS_max_file_size = 0;
@@ -168,6 +218,12 @@ static bool FLAGS_use_existing_db = false;
 // If true, reuse existing log/MANIFEST files when re-opening a database.
 static bool FLAGS_reuse_logs = false;
 
+// If true, the writers of a write group insert into the memtable in parallel
+static bool FLAGS_concurrent_memtable_write = false;
+
+// If true, a write group is inserted while the next one writes the log
+static bool FLAGS_pipelined_write = false;
+
 // If true, use compression.
 static bool FLAGS_compression = true;
 
@@ -208,6 +264,43 @@ class CountComparator : public Comparator {
   const Comparator* const wrapped_;
 };
 
+// Generates integers in [0, n) with a Zipfian distribution of skew
+// "theta", 0 being the most frequent (Gray et al., "Quickly Generating
+// Billion-Record Synthetic Databases", SIGMOD 1994).
+class ZipfianGenerator {
+ public:
+  ZipfianGenerator(int n, double theta)
+      : n_(n), theta_(theta), alpha_(1.0 / (1.0 - theta)) {
+    const double zeta2 = Zeta(2);
+    zetan_ = Zeta(n);
+    eta_ = (1 - std::pow(2.0 / n, 1 - theta)) / (1 - zeta2 / zetan_);
+  }
+
+  int Next(Random* rnd) const {
+    const double u = (rnd->Next() - 1) / 2147483646.0;
+    const double uz = u * zetan_;
+    if (uz < 1.0) return 0;
+    if (uz < 1.0 + std::pow(0.5, theta_)) return std::min(1, n_ - 1);
+    const int k = static_cast<int>(n_ * std::pow(eta_ * u - eta_ + 1, alpha_));
+    return std::min(k, n_ - 1);
+  }
+
+ private:
+  double Zeta(int n) const {
+    double sum = 0;
+    for (int i = 1; i <= n; i++) {
+      sum += 1.0 / std::pow(i, theta_);
+    }
+    return sum;
+  }
+
+  const int n_;
+  const double theta_;
+  const double alpha_;
+  double zetan_;
+  double eta_;
+};
+
 // Helper for quickly generating random data.
 class RandomGenerator {
  private:
@@ -295,7 +388,9 @@ class Stats {
   int64_t bytes_;
   double last_op_finish_;
   Histogram hist_;
+  bool histogram_;  // Whether op timings are recorded
   std::string message_;
+  std::vector<std::pair<std::string, std::string>> fields_;
 
  public:
   Stats() { Start(); }
@@ -303,15 +398,18 @@ class Stats {
   void Start() {
     next_report_ = 100;
     hist_.Clear();
+    histogram_ = FLAGS_histogram;
     done_ = 0;
     bytes_ = 0;
     seconds_ = 0;
     message_.clear();
+    fields_.clear();
     start_ = finish_ = last_op_finish_ = g_env->NowMicros();
   }
 
   void Merge(const Stats& other) {
     hist_.Merge(other.hist_);
+    histogram_ = histogram_ || other.histogram_;
     done_ += other.done_;
     bytes_ += other.bytes_;
     seconds_ += other.seconds_;
@@ -320,6 +418,15 @@ class Stats {
 
     // Just keep the messages from one thread
     if (message_.empty()) message_ = other.message_;
+    if (fields_.empty()) fields_ = other.fields_;
+  }
+
+  // Record op timings for latency percentiles even without --histogram
+  void EnableHistogram() { histogram_ = true; }
+
+  // Attach a parameter of the run to the report
+  void AddField(const std::string& key, const std::string& value) {
+    fields_.emplace_back(key, value);
   }
 
   void Stop() {
@@ -331,7 +438,7 @@ class Stats {
 
   // 什么意思，完成一次操作？？？
   void FinishedSingleOp() {
-    if (FLAGS_histogram) {
+    if (histogram_) {
       double now = g_env->NowMicros();
       double micros = now - last_op_finish_;  // 微秒数
       hist_.Add(micros);
@@ -384,6 +491,21 @@ class Stats {
     }
     AppendWithSpace(&extra, message_);
 
+    if (FLAGS_json) {
+      ReportJson(name);
+      return;
+    }
+    if (histogram_ && !FLAGS_histogram) {
+      char latency[100];
+      std::snprintf(latency, sizeof(latency), "p50 %.1f p99 %.1f p999 %.1f",
+                    hist_.Percentile(50), hist_.Percentile(99),
+                    hist_.Percentile(99.9));
+      AppendWithSpace(&extra, latency);
+    }
+    for (const auto& field : fields_) {
+      AppendWithSpace(&extra, field.first + "=" + field.second);
+    }
+
     std::fprintf(stdout, "%-12s : %11.3f micros/op;%s%s\n",
                  name.ToString().c_str(), seconds_ * 1e6 / done_,
                  (extra.empty() ? "" : " "), extra.c_str());
@@ -394,6 +516,59 @@ class Stats {
     //冲洗流中的信息，该函数通常用于处理磁盘文件。 fflush()会强迫将缓冲区内的数据写回参数stream 指定的文件中。
     std::fflush(stdout);
   }
+
+ private:
+  static void AppendJsonString(std::string* dst, const std::string& s) {
+    dst->push_back('"');
+    for (char c : s) {
+      if (c == '"' || c == '\\') {
+        dst->push_back('\\');
+        dst->push_back(c);
+      } else if (static_cast<unsigned char>(c) >= 0x20) {
+        dst->push_back(c);
+      }
+    }
+    dst->push_back('"');
+  }
+
+  static void AppendJsonNumber(std::string* dst, const char* key,
+                               double value) {
+    char buf[100];
+    std::snprintf(buf, sizeof(buf), ", \"%s\": %.3f", key, value);
+    dst->append(buf);
+  }
+
+  // Print one line that tools can parse: the name, throughput, latency
+  // percentiles in microseconds per op and the fields of the run.
+  void ReportJson(const Slice& name) {
+    std::string json = "{\"benchmark\": ";
+    AppendJsonString(&json, name.ToString());
+    AppendJsonNumber(&json, "ops", done_);
+    AppendJsonNumber(&json, "micros_per_op", seconds_ * 1e6 / done_);
+    if (bytes_ > 0) {
+      AppendJsonNumber(&json, "mb_per_sec",
+                       (bytes_ / 1048576.0) / ((finish_ - start_) * 1e-6));
+    }
+    if (histogram_) {
+      AppendJsonNumber(&json, "p50", hist_.Percentile(50));
+      AppendJsonNumber(&json, "p99", hist_.Percentile(99));
+      AppendJsonNumber(&json, "p999", hist_.Percentile(99.9));
+      AppendJsonNumber(&json, "max", hist_.Percentile(100));
+    }
+    for (const auto& field : fields_) {
+      json.append(", ");
+      AppendJsonString(&json, field.first);
+      json.append(": ");
+      AppendJsonString(&json, field.second);
+    }
+    if (!message_.empty()) {
+      json.append(", \"message\": ");
+      AppendJsonString(&json, message_);
+    }
+    json.append("}\n");
+    std::fputs(json.c_str(), stdout);
+    std::fflush(stdout);
+  }
 };
 
 // State shared by all concurrent executions of the same benchmark.
@@ -435,6 +610,7 @@ class Benchmark {
  private:
   Cache* cache_;
   const FilterPolicy* filter_policy_;
+  RateLimiter* rate_limiter_;
   DB* db_;
   int num_;
   int value_size_;
@@ -445,6 +621,10 @@ class Benchmark {
   CountComparator count_comparator_;
   int total_thread_count_;
   Remix *sorted_view_;
+  int scan_length_;  // Entries read per seek by the seeknext benchmarks
+  ZipfianGenerator* zipf_;  // Seek keys of seeknext, or nullptr if uniform
+  int l0_files_;  // Shape of the DB when a seeknext benchmark started
+  int sorted_runs_;
 
   void PrintHeader() {
     const int kKeySize = 16 + FLAGS_key_prefix;
@@ -462,10 +642,7 @@ class Benchmark {
         stdout, "FileSize:   %.1f MB (estimated)\n",
         (((kKeySize + FLAGS_value_size * FLAGS_compression_ratio) * num_) /
          1048576.0));
-    std::fprintf(
-        stdout, "Keys num per seg:   %d \n",
-        ((FLAGS_key_num_perseg) /
-         1048576.0));
+    std::fprintf(stdout, "Keys num per seg:   %d\n", FLAGS_key_num_perseg);
     PrintWarnings();
     std::fprintf(stdout, "------------------------------------------------\n");
   }
@@ -534,6 +711,10 @@ class Benchmark {
         filter_policy_(FLAGS_bloom_bits >= 0
                            ? NewBloomFilterPolicy(FLAGS_bloom_bits)
                            : nullptr),
+        rate_limiter_(FLAGS_rate_limit > 0
+                          ? NewRateLimiter(FLAGS_rate_limit,
+                                           FLAGS_rate_limit_auto_tune)
+                          : nullptr),
         db_(nullptr),
         num_(FLAGS_num),
         value_size_(FLAGS_value_size),
@@ -542,7 +723,11 @@ class Benchmark {
         heap_counter_(0),
         count_comparator_(BytewiseComparator()),
         total_thread_count_(0) ,
-        sorted_view_(nullptr){
+        sorted_view_(nullptr),
+        scan_length_(0),
+        zipf_(nullptr),
+        l0_files_(0),
+        sorted_runs_(0) {
     std::vector<std::string> files;
     g_env->GetChildren(FLAGS_db, &files);
     for (size_t i = 0; i < files.size(); i++) {
@@ -556,9 +741,12 @@ class Benchmark {
   }
 
   ~Benchmark() {
+    delete zipf_;
+    delete sorted_view_;
     delete db_;
     delete cache_;
     delete filter_policy_;
+    delete rate_limiter_;
   }
 
   void Run() {
@@ -632,14 +820,23 @@ class Benchmark {
         method = &Benchmark::CreateView;
       } else if (name == Slice("readreverse")) {
         method = &Benchmark::ReadReverse;
+      } else if (name == Slice("readreverse_Remix")) {
+        method = &Benchmark::ReadReverseRemix;
       } else if (name == Slice("readrandom")) {
         method = &Benchmark::ReadRandom;
+      } else if (name == Slice("multireadrandom")) {
+        entries_per_batch_ = 100;
+        method = &Benchmark::MultiReadRandom;
       } else if (name == Slice("readmissing")) {
         method = &Benchmark::ReadMissing;
       } else if (name == Slice("seekrandom")) {
         method = &Benchmark::SeekRandom;
       } else if (name == Slice("seekordered")) {
         method = &Benchmark::SeekOrdered;
+      } else if (name == Slice("seeknext_Leveldb")) {
+        method = &Benchmark::SeekNextLeveldb;
+      } else if (name == Slice("seeknext_Remix")) {
+        method = &Benchmark::SeekNextRemix;
       } else if (name == Slice("readhot")) {
         method = &Benchmark::ReadHot;
       } else if (name == Slice("readrandomsmall")) {
@@ -679,6 +876,8 @@ class Benchmark {
                        name.ToString().c_str());
           method = nullptr;
         } else {
+          delete sorted_view_;
+          sorted_view_ = nullptr;
           delete db_;
           db_ = nullptr;
           DestroyDB(FLAGS_db, Options());
@@ -686,7 +885,19 @@ class Benchmark {
         }
       }
 
-      if (method != nullptr) {
+      if (method == &Benchmark::SeekNextLeveldb ||
+          method == &Benchmark::SeekNextRemix) {
+        if (method == &Benchmark::SeekNextRemix && sorted_view_ == nullptr) {
+          std::fprintf(stderr, "%s needs a preceding \"create view\"\n",
+                       name.ToString().c_str());
+          std::exit(1);
+        }
+        PrepareSeekNext();
+        for (const int length : ParseScanLengths()) {
+          scan_length_ = length;
+          RunBenchmark(num_threads, name, method);
+        }
+      } else if (method != nullptr) {
         RunBenchmark(num_threads, name, method);
       }
     }
@@ -767,6 +978,7 @@ class Benchmark {
     for (int i = 1; i < n; i++) {
       arg[0].thread->stats.Merge(arg[i].thread->stats);
     }
+    arg[0].thread->stats.AddField("threads", std::to_string(n));
     arg[0].thread->stats.Report(name);
     if (FLAGS_comparisons) {
       fprintf(stdout, "Comparisons: %zu\n", count_comparator_.comparisons());
@@ -856,6 +1068,15 @@ class Benchmark {
     //options.block_cache = cache_;
     options.block_cache = nullptr;
     options.write_buffer_size = FLAGS_write_buffer_size;
+    if (FLAGS_max_immutable_memtables >= 0) {
+      options.max_immutable_memtables = FLAGS_max_immutable_memtables;
+    }
+    if (FLAGS_max_background_compactions >= 0) {
+      options.max_background_compactions = FLAGS_max_background_compactions;
+    }
+    if (FLAGS_max_subcompactions >= 0) {
+      options.max_subcompactions = FLAGS_max_subcompactions;
+    }
     options.max_file_size = FLAGS_max_file_size;
     options.block_size = FLAGS_block_size;
     if (FLAGS_comparisons) {
@@ -863,7 +1084,13 @@ class Benchmark {
     }
     options.max_open_files = FLAGS_open_files;
     options.filter_policy = filter_policy_;
+    options.rate_limiter = rate_limiter_;
+    options.blob_value_threshold = FLAGS_blob_value_threshold;
     options.reuse_logs = FLAGS_reuse_logs;
+    options.allow_concurrent_memtable_write = FLAGS_concurrent_memtable_write;
+    options.enable_pipelined_write = FLAGS_pipelined_write;
+    options.use_remix = FLAGS_use_remix;
+    options.remix_segment_size = FLAGS_key_num_perseg;
     options.compression =
         FLAGS_compression ? kSnappyCompression : kNoCompression;
     Status s = DB::Open(options, FLAGS_db, &db_);
@@ -875,6 +1102,8 @@ class Benchmark {
 
   void OpenBench(ThreadState* thread) {
     for (int i = 0; i < num_; i++) {
+      delete sorted_view_;
+      sorted_view_ = nullptr;
       delete db_;
       Open();
       thread->stats.FinishedSingleOp();
@@ -942,6 +1171,11 @@ class Benchmark {
     void CreateView(ThreadState* thread) {
     if(sorted_view_ != NULL) delete sorted_view_;
     sorted_view_ = new Remix(db_,FLAGS_key_num_perseg);
+    if (!sorted_view_->status().ok()) {
+      std::fprintf(stderr, "create view error: %s\n",
+                   sorted_view_->status().ToString().c_str());
+      std::exit(1);
+    }
     thread->stats.FinishedSingleOp();
   }
   void _50sn_Leveldb(ThreadState* thread) {
@@ -953,7 +1187,6 @@ class Benchmark {
     key.Set(thread->rand.Uniform(FLAGS_num));
     //cout << key.slice().ToString() << endl;
     for(iter->Seek(key.slice()); iter->Valid()&&i < 50; i++,iter->Next()){
-      if(i == 0) cout << iter->key().ToString() << endl;
       bytes += iter->key().size() + iter->value().size();
       thread->stats.FinishedSingleOp();
     }
@@ -969,7 +1202,6 @@ class Benchmark {
     key.Set(thread->rand.Uniform(FLAGS_num));
     //key.Set(thread->rand.Uniform(FLAGS_num/4) + FLAGS_num-FLAGS_num/4);
     for (iter->Seek(key.slice()); iter->Valid()&&i < 50; i++, iter->Next()) {
-      if(i == 0) cout << iter->key().ToString() << endl;
       bytes += iter->key().size() + iter->value().size();
       thread->stats.FinishedSingleOp();
     }
@@ -1012,6 +1244,18 @@ class Benchmark {
     delete iter;
     thread->stats.AddBytes(bytes);
   }
+  void ReadReverseRemix(ThreadState* thread) {
+    Iterator* iter = sorted_view_->NewIterator();
+    int i = 0;
+    int64_t bytes = 0;
+    for (iter->SeekToLast(); i < reads_ && iter->Valid(); iter->Prev()) {
+      bytes += iter->key().size() + iter->value().size();
+      thread->stats.FinishedSingleOp();
+      ++i;
+    }
+    delete iter;
+    thread->stats.AddBytes(bytes);
+  }
 
   void ReadRandom(ThreadState* thread) {
     ReadOptions options;
@@ -1030,6 +1274,32 @@ class Benchmark {
     std::snprintf(msg, sizeof(msg), "(%d of %d found)", found, num_);
     thread->stats.AddMessage(msg);
   }
+  void MultiReadRandom(ThreadState* thread) {
+    ReadOptions options;
+    std::vector<std::string> key_strings(entries_per_batch_);
+    std::vector<Slice> keys(entries_per_batch_);
+    std::vector<std::string> values;
+    int found = 0;
+    KeyBuffer key;
+    for (int i = 0; i < reads_; i += entries_per_batch_) {
+      for (int j = 0; j < entries_per_batch_; j++) {
+        key.Set(thread->rand.Uniform(FLAGS_num));
+        key_strings[j] = key.slice().ToString();
+        keys[j] = key_strings[j];
+      }
+      std::vector<Status> statuses = db_->MultiGet(options, keys, &values);
+      for (int j = 0; j < entries_per_batch_; j++) {
+        if (statuses[j].ok()) {
+          found++;
+        }
+        thread->stats.FinishedSingleOp();
+      }
+    }
+    char msg[100];
+    std::snprintf(msg, sizeof(msg), "(%d of %d found)", found, num_);
+    thread->stats.AddMessage(msg);
+  }
+
   // 以随机顺序读取 N 个丢失的键
   void ReadMissing(ThreadState* thread) {
     ReadOptions options;
@@ -1094,6 +1364,86 @@ class Benchmark {
     thread->stats.AddMessage(msg);
   }
 
+  std::vector<int> ParseScanLengths() const {
+    std::vector<int> lengths;
+    const char* p = FLAGS_scan_lengths;
+    while (*p != '\0') {
+      const int length = std::atoi(p);
+      if (length > 0) lengths.push_back(length);
+      p = strchr(p, ',');
+      if (p == nullptr) break;
+      p++;
+    }
+    return lengths;
+  }
+
+  // Set up the seek keys and record the shape of the DB, outside of the
+  // timed runs.
+  void PrepareSeekNext() {
+    delete zipf_;
+    zipf_ = nullptr;
+    if (Slice(FLAGS_seek_distribution) == Slice("zipfian")) {
+      zipf_ = new ZipfianGenerator(FLAGS_num, FLAGS_zipf_theta);
+    }
+    l0_files_ = 0;
+    sorted_runs_ = 0;
+    for (int level = 0; level < 7; level++) {
+      std::string files;
+      if (!db_->GetProperty("leveldb.num-files-at-level" +
+                                std::to_string(level),
+                            &files)) {
+        break;
+      }
+      const int n = std::atoi(files.c_str());
+      if (level == 0) {
+        l0_files_ = n;
+        sorted_runs_ += n;
+      } else if (n > 0) {
+        sorted_runs_++;
+      }
+    }
+  }
+
+  void SeekNextLeveldb(ThreadState* thread) { DoSeekNext(thread, false); }
+
+  void SeekNextRemix(ThreadState* thread) { DoSeekNext(thread, true); }
+
+  // Each op creates an iterator, seeks and reads scan_length_ entries.  The
+  // number of ops is chosen so that about reads_ entries are read.
+  void DoSeekNext(ThreadState* thread, bool remix) {
+    thread->stats.EnableHistogram();
+    const int ops = std::max(1, reads_ / scan_length_);
+    int64_t bytes = 0;
+    int64_t entries = 0;
+    KeyBuffer key;
+    for (int i = 0; i < ops; i++) {
+      Iterator* iter = remix ? sorted_view_->NewIterator()
+                             : db_->NewIterator(ReadOptions());
+      key.Set(zipf_ != nullptr ? zipf_->Next(&thread->rand)
+                               : thread->rand.Uniform(FLAGS_num));
+      int n = 0;
+      for (iter->Seek(key.slice()); iter->Valid() && n < scan_length_;
+           iter->Next()) {
+        bytes += iter->key().size() + iter->value().size();
+        n++;
+      }
+      entries += n;
+      delete iter;
+      thread->stats.FinishedSingleOp();
+    }
+    thread->stats.AddBytes(bytes);
+    if (thread->tid == 0) {
+      char buf[100];
+      std::snprintf(buf, sizeof(buf), "%.1f",
+                    static_cast<double>(entries) / ops);
+      thread->stats.AddField("scan_length", std::to_string(scan_length_));
+      thread->stats.AddField("entries_per_op", buf);
+      thread->stats.AddField("distribution", FLAGS_seek_distribution);
+      thread->stats.AddField("l0_files", std::to_string(l0_files_));
+      thread->stats.AddField("sorted_runs", std::to_string(sorted_runs_));
+    }
+  }
+
   void DoDelete(ThreadState* thread, bool seq) {
     RandomGenerator gen;
     WriteBatch batch;
@@ -1212,12 +1562,31 @@ int main(int argc, char** argv) {
     } else if (sscanf(argv[i], "--comparisons=%d%c", &n, &junk) == 1 &&
                (n == 0 || n == 1)) {
       FLAGS_comparisons = n;
+    } else if (sscanf(argv[i], "--json=%d%c", &n, &junk) == 1 &&
+               (n == 0 || n == 1)) {
+      FLAGS_json = n;
+    } else if (sscanf(argv[i], "--use_remix=%d%c", &n, &junk) == 1 &&
+               (n == 0 || n == 1)) {
+      FLAGS_use_remix = n;
+    } else if (strncmp(argv[i], "--scan_lengths=", 15) == 0) {
+      FLAGS_scan_lengths = argv[i] + 15;
+    } else if (strncmp(argv[i], "--seek_distribution=", 20) == 0) {
+      FLAGS_seek_distribution = argv[i] + 20;
+    } else if (sscanf(argv[i], "--zipf_theta=%lf%c", &d, &junk) == 1) {
+      FLAGS_zipf_theta = d;
     } else if (sscanf(argv[i], "--use_existing_db=%d%c", &n, &junk) == 1 &&
                (n == 0 || n == 1)) {
       FLAGS_use_existing_db = n;
     } else if (sscanf(argv[i], "--reuse_logs=%d%c", &n, &junk) == 1 &&
                (n == 0 || n == 1)) {
       FLAGS_reuse_logs = n;
+    } else if (sscanf(argv[i], "--concurrent_memtable_write=%d%c", &n,
+                      &junk) == 1 &&
+               (n == 0 || n == 1)) {
+      FLAGS_concurrent_memtable_write = n;
+    } else if (sscanf(argv[i], "--pipelined_write=%d%c", &n, &junk) == 1 &&
+               (n == 0 || n == 1)) {
+      FLAGS_pipelined_write = n;
     } else if (sscanf(argv[i], "--compression=%d%c", &n, &junk) == 1 &&
                (n == 0 || n == 1)) {
       FLAGS_compression = n;
@@ -1231,6 +1600,22 @@ int main(int argc, char** argv) {
       FLAGS_value_size = n;
     } else if (sscanf(argv[i], "--write_buffer_size=%d%c", &n, &junk) == 1) {
       FLAGS_write_buffer_size = n;
+    } else if (sscanf(argv[i], "--max_immutable_memtables=%d%c", &n, &junk) ==
+               1) {
+      FLAGS_max_immutable_memtables = n;
+    } else if (sscanf(argv[i], "--max_background_compactions=%d%c", &n,
+                      &junk) == 1) {
+      FLAGS_max_background_compactions = n;
+    } else if (sscanf(argv[i], "--max_subcompactions=%d%c", &n, &junk) == 1) {
+      FLAGS_max_subcompactions = n;
+    } else if (sscanf(argv[i], "--rate_limit=%d%c", &n, &junk) == 1) {
+      FLAGS_rate_limit = n;
+    } else if (sscanf(argv[i], "--rate_limit_auto_tune=%d%c", &n, &junk) == 1 &&
+               (n == 0 || n == 1)) {
+      FLAGS_rate_limit_auto_tune = n;
+    } else if (sscanf(argv[i], "--blob_value_threshold=%d%c", &n, &junk) ==
+               1) {
+      FLAGS_blob_value_threshold = n;
     } else if (sscanf(argv[i], "--max_file_size=%d%c", &n, &junk) == 1) {
       FLAGS_max_file_size = n;
     } else if (sscanf(argv[i], "--block_size=%d%c", &n, &junk) == 1) {
@@ -0,0 +1,216 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "db/blob_file.h"
+
+#include "db/dbformat.h"
+#include "db/filename.h"
+#include "db/table_cache.h"
+#include "leveldb/env.h"
+#include "leveldb/iterator.h"
+#include "leveldb/rate_limiter.h"
+#include "util/coding.h"
+#include "util/crc32c.h"
+
+namespace leveldb {
+
+static const size_t kBlobHeaderSize = 4;
+
+void BlobIndex::EncodeTo(std::string* dst) const {
+  PutVarint64(dst, file_number);
+  PutVarint64(dst, offset);
+  PutVarint64(dst, size);
+}
+
+bool BlobIndex::DecodeFrom(Slice input) {
+  return GetVarint64(&input, &file_number) && GetVarint64(&input, &offset) &&
+         GetVarint64(&input, &size) && input.empty();
+}
+
+Status ReadBlob(RandomAccessFile* file, const BlobIndex& index,
+                bool verify_checksum, std::string* value) {
+  const size_t n = static_cast<size_t>(index.size) + kBlobHeaderSize;
+  char* buf = new char[n];
+  Slice contents;
+  Status s = file->Read(index.offset, n, &contents, buf);
+  if (s.ok() && contents.size() != n) {
+    s = Status::Corruption("truncated blob read");
+  }
+  if (s.ok()) {
+    const char* data = contents.data();  // Pointer to where Read put the data
+    if (verify_checksum) {
+      const uint32_t crc = crc32c::Unmask(DecodeFixed32(data));
+      const uint32_t actual =
+          crc32c::Value(data + kBlobHeaderSize, index.size);
+      if (actual != crc) {
+        s = Status::Corruption("blob checksum mismatch");
+      }
+    }
+    if (s.ok()) {
+      value->assign(data + kBlobHeaderSize, index.size);
+    }
+  }
+  delete[] buf;
+  return s;
+}
+
+namespace {
+
+class BlobResolvingIterator : public Iterator {
+ public:
+  BlobResolvingIterator(Iterator* iter, TableCache* table_cache,
+                        const ReadOptions& options)
+      : iter_(iter),
+        table_cache_(table_cache),
+        options_(options),
+        key_resolved_(false),
+        value_resolved_(false) {}
+
+  BlobResolvingIterator(const BlobResolvingIterator&) = delete;
+  BlobResolvingIterator& operator=(const BlobResolvingIterator&) = delete;
+
+  ~BlobResolvingIterator() override { delete iter_; }
+
+  bool Valid() const override { return iter_->Valid(); }
+  void SeekToFirst() override {
+    iter_->SeekToFirst();
+    Reset();
+  }
+  void SeekToLast() override {
+    iter_->SeekToLast();
+    Reset();
+  }
+  void Seek(const Slice& target) override {
+    iter_->Seek(target);
+    Reset();
+  }
+  void Next() override {
+    iter_->Next();
+    Reset();
+  }
+  void Prev() override {
+    iter_->Prev();
+    Reset();
+  }
+
+  Slice key() const override {
+    const Slice k = iter_->key();
+    if (!IsBlobIndex(k)) {
+      return k;
+    }
+    if (!key_resolved_) {
+      key_.assign(k.data(), k.size());
+      key_[key_.size() - 8] = static_cast<char>(kTypeValue);
+      key_resolved_ = true;
+    }
+    return key_;
+  }
+
+  Slice value() const override {
+    if (!IsBlobIndex(iter_->key())) {
+      return iter_->value();
+    }
+    if (!value_resolved_) {
+      Status s = table_cache_->GetBlob(options_, iter_->value(), &value_);
+      if (!s.ok()) {
+        value_.clear();
+        if (status_.ok()) {
+          status_ = s;
+        }
+      }
+      value_resolved_ = true;
+    }
+    return value_;
+  }
+
+  Status status() const override {
+    return status_.ok() ? iter_->status() : status_;
+  }
+
+ private:
+  static bool IsBlobIndex(const Slice& ikey) {
+    return ikey.size() >= 8 && ExtractValueType(ikey) == kTypeBlobIndex;
+  }
+
+  void Reset() {
+    key_resolved_ = false;
+    value_resolved_ = false;
+  }
+
+  Iterator* const iter_;
+  TableCache* const table_cache_;
+  const ReadOptions options_;
+  mutable std::string key_;
+  mutable std::string value_;
+  mutable bool key_resolved_;
+  mutable bool value_resolved_;
+  mutable Status status_;
+};
+
+}  // namespace
+
+Iterator* NewBlobResolvingIterator(Iterator* iter, TableCache* table_cache,
+                                   const ReadOptions& options) {
+  return new BlobResolvingIterator(iter, table_cache, options);
+}
+
+BlobFileBuilder::BlobFileBuilder(const Options& options,
+                                 const std::string& dbname,
+                                 uint64_t file_number)
+    : options_(options),
+      fname_(BlobFileName(dbname, file_number)),
+      file_number_(file_number),
+      file_(nullptr),
+      offset_(0) {}
+
+BlobFileBuilder::~BlobFileBuilder() { delete file_; }
+
+Status BlobFileBuilder::Add(const Slice& value, std::string* index) {
+  if (!status_.ok()) {
+    return status_;
+  }
+  if (file_ == nullptr) {
+    status_ = options_.env->NewWritableFile(fname_, &file_);
+    if (!status_.ok()) {
+      return status_;
+    }
+  }
+  if (options_.rate_limiter != nullptr) {
+    options_.rate_limiter->Request(value.size() + kBlobHeaderSize);
+  }
+
+  char header[kBlobHeaderSize];
+  EncodeFixed32(header,
+                crc32c::Mask(crc32c::Value(value.data(), value.size())));
+  status_ = file_->Append(Slice(header, kBlobHeaderSize));
+  if (status_.ok()) {
+    status_ = file_->Append(value);
+  }
+  if (status_.ok()) {
+    BlobIndex blob;
+    blob.file_number = file_number_;
+    blob.offset = offset_;
+    blob.size = value.size();
+    index->clear();
+    blob.EncodeTo(index);
+    offset_ += kBlobHeaderSize + value.size();
+  }
+  return status_;
+}
+
+Status BlobFileBuilder::Finish() {
+  if (file_ != nullptr) {
+    if (status_.ok()) {
+      status_ = file_->Sync();
+    }
+    if (status_.ok()) {
+      status_ = file_->Close();
+    }
+    delete file_;
+    file_ = nullptr;
+  }
+  return status_;
+}
+
+}  // namespace leveldb
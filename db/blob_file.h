@@ -0,0 +1,104 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+//
+// Values of at least Options::blob_value_threshold bytes are moved out of
+// the table files into append-only blob files when memtables are flushed
+// or tables are compacted, so that compactions copy a small BlobIndex
+// instead of the value.  A blob file is a sequence of records
+//
+//    checksum: fixed32   (masked crc32c of value)
+//    value:    char[size]
+//
+// and the table entry of type kTypeBlobIndex that refers to a record holds
+//
+//    file_number: varint64
+//    offset:      varint64   (of the record)
+//    size:        varint64   (of the value)
+//
+// Every table file lists the blob files it refers to (see FileMetaData),
+// and a blob file is deleted once no live table file refers to it.
+// Compactions move the values still referenced in the oldest blob files
+// into new ones, so that the space of dead values is reclaimed.
+
+#ifndef STORAGE_LEVELDB_DB_BLOB_FILE_H_
+#define STORAGE_LEVELDB_DB_BLOB_FILE_H_
+
+#include <cstdint>
+#include <string>
+
+#include "leveldb/options.h"
+#include "leveldb/slice.h"
+#include "leveldb/status.h"
+
+namespace leveldb {
+
+class Iterator;
+class RandomAccessFile;
+class TableCache;
+class WritableFile;
+
+struct BlobIndex {
+  BlobIndex() : file_number(0), offset(0), size(0) {}
+
+  void EncodeTo(std::string* dst) const;
+  bool DecodeFrom(Slice input);
+
+  uint64_t file_number;
+  uint64_t offset;
+  uint64_t size;
+};
+
+// Read the value of the record that "index" refers to from "file" into
+// *value, checking its checksum if "verify_checksum" is set.
+Status ReadBlob(RandomAccessFile* file, const BlobIndex& index,
+                bool verify_checksum, std::string* value);
+
+// Return an iterator over the internal entries of "iter" in which every
+// entry of type kTypeBlobIndex appears as a kTypeValue entry holding the
+// value it refers to, read through "table_cache" when value() is called.
+// Takes ownership of "iter".
+Iterator* NewBlobResolvingIterator(Iterator* iter, TableCache* table_cache,
+                                   const ReadOptions& options);
+
+// Appends values to a new blob file, which is only created once the first
+// value is added.
+class BlobFileBuilder {
+ public:
+  BlobFileBuilder(const Options& options, const std::string& dbname,
+                  uint64_t file_number);
+
+  BlobFileBuilder(const BlobFileBuilder&) = delete;
+  BlobFileBuilder& operator=(const BlobFileBuilder&) = delete;
+
+  // Closes the file if Finish() has not been called.
+  ~BlobFileBuilder();
+
+  // Append "value" to the file and store the encoding of its BlobIndex in
+  // *index.
+  // REQUIRES: Finish() has not been called
+  Status Add(const Slice& value, std::string* index);
+
+  // Sync and close the file, if any value was added.
+  Status Finish();
+
+  uint64_t file_number() const { return file_number_; }
+
+  // Returns true iff no value was added.
+  bool empty() const { return offset_ == 0; }
+
+  // Number of bytes written to the file.
+  uint64_t FileSize() const { return offset_; }
+
+ private:
+  const Options& options_;
+  const std::string fname_;
+  const uint64_t file_number_;
+  WritableFile* file_;
+  uint64_t offset_;
+  Status status_;
+};
+
+}  // namespace leveldb
+
+#endif  // STORAGE_LEVELDB_DB_BLOB_FILE_H_
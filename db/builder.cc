@@ -4,6 +4,9 @@
 
 #include "db/builder.h"
 
+#include <algorithm>
+
+#include "db/blob_file.h"
 #include "db/dbformat.h"
 #include "db/filename.h"
 #include "db/table_cache.h"
@@ -15,7 +18,8 @@
 namespace leveldb {
 
 Status BuildTable(const std::string& dbname, Env* env, const Options& options,
-                  TableCache* table_cache, Iterator* iter, FileMetaData* meta) {
+                  TableCache* table_cache, Iterator* iter, FileMetaData* meta,
+                  BlobFileBuilder* blobs) {
   Status s;
   meta->file_size = 0;
   iter->SeekToFirst();
@@ -29,24 +33,66 @@ Status BuildTable(const std::string& dbname, Env* env, const Options& options,
     }
 
     TableBuilder* builder = new TableBuilder(options, file);
-    meta->smallest.DecodeFrom(iter->key());
-    Slice key;
+    meta->smallest_sequence = kMaxSequenceNumber;
+    meta->largest_sequence = 0;
+    std::string key;
+    std::string blob_key, blob_index;
     for (; iter->Valid(); iter->Next()) {
-      key = iter->key();
-      builder->Add(key, iter->value());
+      key.assign(iter->key().data(), iter->key().size());
+      Slice value = iter->value();
+      ParsedInternalKey ikey;
+      const bool parsed = ParseInternalKey(key, &ikey);
+      if (blobs != nullptr && parsed && ikey.type == kTypeValue &&
+          value.size() >= options.blob_value_threshold) {
+        s = blobs->Add(value, &blob_index);
+        if (!s.ok()) {
+          break;
+        }
+        ikey.type = kTypeBlobIndex;
+        blob_key.clear();
+        AppendInternalKey(&blob_key, ikey);
+        key.swap(blob_key);
+        value = blob_index;
+      }
+      if (builder->NumEntries() == 0) {
+        meta->smallest.DecodeFrom(key);
+      }
+      builder->Add(key, value);
+      if (parsed) {
+        meta->smallest_sequence =
+            std::min(meta->smallest_sequence, ikey.sequence);
+        meta->largest_sequence =
+            std::max(meta->largest_sequence, ikey.sequence);
+      } else {
+        // Keep the widest bounds
+        meta->smallest_sequence = 0;
+        meta->largest_sequence = kMaxSequenceNumber;
+      }
     }
     if (!key.empty()) {
       meta->largest.DecodeFrom(key);
     }
 
     // Finish and check for builder errors
-    s = builder->Finish();
+    if (s.ok()) {
+      s = builder->Finish();
+    } else {
+      builder->Abandon();
+    }
     if (s.ok()) {
       meta->file_size = builder->FileSize();
       assert(meta->file_size > 0);
     }
     delete builder;
 
+    // The blob file must be durable before the table that refers to it
+    if (s.ok() && blobs != nullptr && !blobs->empty()) {
+      s = blobs->Finish();
+      if (s.ok()) {
+        meta->blob_files.push_back(blobs->file_number());
+      }
+    }
+
     // Finish and check for file errors
     if (s.ok()) {
       s = file->Sync();
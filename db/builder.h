@@ -12,6 +12,7 @@ namespace leveldb {
 struct Options;
 struct FileMetaData;
 
+class BlobFileBuilder;
 class Env;
 class Iterator;
 class TableCache;
@@ -22,8 +23,13 @@ class VersionEdit;
 // *meta will be filled with metadata about the generated table.
 // If no data is present in *iter, meta->file_size will be set to
 // zero, and no Table file will be produced.
+//
+// If "blobs" is non-null, values of at least options.blob_value_threshold
+// bytes are written to *blobs instead of the table, which the caller must
+// not use afterwards except to check whether it is empty().
 Status BuildTable(const std::string& dbname, Env* env, const Options& options,
-                  TableCache* table_cache, Iterator* iter, FileMetaData* meta);
+                  TableCache* table_cache, Iterator* iter, FileMetaData* meta,
+                  BlobFileBuilder* blobs = nullptr);
 
 }  // namespace leveldb
 
@@ -9,10 +9,12 @@
 #include <atomic>
 #include <cstdint>
 #include <cstdio>
+#include <deque>
 #include <set>
 #include <string>
 #include <vector>
 
+#include "db/blob_file.h"
 #include "db/builder.h"
 #include "db/db_iter.h"
 #include "db/dbformat.h"
@@ -20,11 +22,14 @@
 #include "db/log_reader.h"
 #include "db/log_writer.h"
 #include "db/memtable.h"
+#include "db/range_tombstone.h"
+#include "db/remix_view.h"
 #include "db/table_cache.h"
 #include "db/version_set.h"
 #include "db/write_batch_internal.h"
 #include "leveldb/db.h"
 #include "leveldb/env.h"
+#include "leveldb/rate_limiter.h"
 #include "leveldb/status.h"
 #include "leveldb/table.h"
 #include "leveldb/table_builder.h"
@@ -40,15 +45,34 @@ namespace leveldb {
 
 const int kNumNonTableCacheFiles = 10;
 
+// A utility routine: write "data" to the named file and Sync() it.
+Status WriteStringToFileSync(Env* env, const Slice& data,
+                             const std::string& fname);
+
 // Information kept for every waiting writer
 struct DBImpl::Writer {
   explicit Writer(port::Mutex* mu)
-      : batch(nullptr), sync(false), done(false), cv(mu) {}
+      : batch(nullptr),
+        sync(false),
+        done(false),
+        exclusive(false),
+        leader(nullptr),
+        last_sequence(0),
+        cv(mu) {}
 
   Status status;
   WriteBatch* batch; // 缓冲区对象
   bool sync; // 是否同步
   bool done; // 是否完成
+  // Set if the writer must reach the front of writers_ itself instead of
+  // being completed as part of another writer's group
+  bool exclusive;
+  // Set once the batch is logged, if this writer should insert the batch
+  // into mem_ itself and then notify the leader of its group
+  Writer* leader;
+  // Last sequence number of the group, while a pipelined group led by
+  // this writer waits to be inserted
+  SequenceNumber last_sequence;
   port::CondVar cv; // 用于多线程操作的条件变量
 };
 
@@ -58,34 +82,69 @@ struct DBImpl::CompactionState {
     uint64_t number;
     uint64_t file_size;
     InternalKey smallest, largest;
+    SequenceNumber smallest_sequence, largest_sequence;
+    std::set<uint64_t> blob_files;
   };
 
   Output* current_output() { return &outputs[outputs.size() - 1]; }
 
   explicit CompactionState(Compaction* c)
       : compaction(c),
+        start(nullptr),
+        end(nullptr),
         smallest_snapshot(0),
+        range_tombstones(nullptr),
+        blob_gc_before(0),
         outfile(nullptr),
         builder(nullptr),
+        blobs(nullptr),
         total_bytes(0) {}
 
   Compaction* const compaction;
 
+  // A subcompaction only merges the user keys in (*start, *end]; null
+  // means that the range is unbounded on that side.
+  const std::string* start;
+  const std::string* end;
+  Compaction::Cursor cursor;
+
   // Sequence numbers < smallest_snapshot are not significant since we
   // will never have to service a snapshot below smallest_snapshot.
   // Therefore if we have seen a sequence number S <= smallest_snapshot,
   // we can drop all entries for the same key with sequence numbers < S.
   SequenceNumber smallest_snapshot;
 
+  // The range tombstones that every snapshot sees.  The entries they
+  // delete are dropped.
+  const RangeTombstoneSet* range_tombstones;
+
+  // Values in blob files numbered below blob_gc_before are moved to a new
+  // blob file, or back into the table if they are no longer large.
+  uint64_t blob_gc_before;
+
   std::vector<Output> outputs;
 
   // State kept for output being generated
   WritableFile* outfile;
   TableBuilder* builder;
 
+  // Blob file written by this key range, if any, and the numbers of all
+  // blob files written, which are kept in pending_outputs_
+  BlobFileBuilder* blobs;
+  std::vector<uint64_t> blob_numbers;
+
   uint64_t total_bytes;
 };
 
+// One key range of a compaction that is merged on a thread of its own
+struct DBImpl::Subcompaction {
+  DBImpl* db;
+  CompactionState* compact;
+  Iterator* input;
+  Status status;
+  bool done;  // Protected by db->mutex_
+};
+
 // Fix user-supplied options to be reasonable
 template <class T, class V>
 static void ClipToRange(T* ptr, V minvalue, V maxvalue) {
@@ -101,8 +160,13 @@ Options SanitizeOptions(const std::string& dbname,
   result.filter_policy = (src.filter_policy != nullptr) ? ipolicy : nullptr;
   ClipToRange(&result.max_open_files, 64 + kNumNonTableCacheFiles, 50000);
   ClipToRange(&result.write_buffer_size, 64 << 10, 1 << 30);
+  ClipToRange(&result.max_immutable_memtables, 1, 64);
+  ClipToRange(&result.max_background_compactions, 1, config::kNumLevels / 2);
+  ClipToRange(&result.max_subcompactions, 1, 64);
   ClipToRange(&result.max_file_size, 1 << 20, 1 << 30);
   ClipToRange(&result.block_size, 1 << 10, 4 << 20);
+  ClipToRange(&result.remix_segment_size, 1, 1 << 16);
+  ClipToRange(&result.remix_build_threads, 1, 256);
   if (result.info_log == nullptr) {
     // Open a log file in the same directory as the db
     src.env->CreateDir(dbname);  // In case it does not exist
@@ -133,7 +197,8 @@ static int TableCacheSize(const Options& sanitized_options) {
 DBImpl::DBImpl(const Options& raw_options, const std::string& dbname)
     : env_(raw_options.env),
       internal_comparator_(raw_options.comparator), // 初始化比较器
-      internal_filter_policy_(raw_options.filter_policy), // 过滤器策略
+      internal_filter_policy_(raw_options.filter_policy,
+                              raw_options.prefix_extractor),  // 过滤器策略
       options_(SanitizeOptions(dbname, &internal_comparator_,
                                &internal_filter_policy_, raw_options)),
       owns_info_log_(options_.info_log != raw_options.info_log), // 是否使用自定义info log
@@ -145,26 +210,41 @@ DBImpl::DBImpl(const Options& raw_options, const std::string& dbname)
       shutting_down_(false),
       background_work_finished_signal_(&mutex_),
       mem_(nullptr),
-      imm_(nullptr),
-      has_imm_(false),
       logfile_(nullptr),
       logfile_number_(0),
       log_(nullptr),
       seed_(0),
       tmp_batch_(new WriteBatch),  // 批量写
-      background_compaction_scheduled_(false), // 是否有后台线程在进行compaction
+      pending_inserts_(0),
+      background_flush_scheduled_(false),
+      background_compactions_scheduled_(0), // 后台进行compaction的线程数
+      background_compactions_running_(0),
+      manifest_locked_(false),
       manual_compaction_(nullptr),
        // 创建version管理器，生成不同的manifest文件
       versions_(new VersionSet(dbname_, &options_, table_cache_,
-                               &internal_comparator_)) {}
+                               &internal_comparator_)),
+      remix_(nullptr),
+      remix_dirty_(false) {
+  for (int level = 0; level < config::kNumLevels; level++) {
+    compacting_levels_[level] = false;
+  }
+}
 
 DBImpl::~DBImpl() {
   // Wait for background work to finish.
   mutex_.Lock();
   shutting_down_.store(true, std::memory_order_release);
-  while (background_compaction_scheduled_) {
+  while (background_flush_scheduled_ || background_compactions_scheduled_ > 0) {
     background_work_finished_signal_.Wait();
   }
+  if (remix_ != nullptr) {
+    if (remix_dirty_) {
+      // Errors are logged; the view is rebuilt on the next open.
+      PersistRemixView(remix_);
+    }
+    remix_->Unref();
+  }
   mutex_.Unlock();
 
   if (db_lock_ != nullptr) {
@@ -173,7 +253,7 @@ DBImpl::~DBImpl() {
 
   delete versions_;
   if (mem_ != nullptr) mem_->Unref();
-  if (imm_ != nullptr) imm_->Unref();
+  for (const ImmutableMemTable& imm : imm_) imm.mem->Unref();
   delete tmp_batch_;
   delete log_;
   delete logfile_;
@@ -271,6 +351,16 @@ void DBImpl::RemoveObsoleteFiles() {
           // be recorded in pending_outputs_, which is inserted into "live"
           keep = (live.find(number) != live.end());
           break;
+        case kBlobFile:
+          // Blob files live as long as a live table refers to them
+          keep = (live.find(number) != live.end());
+          break;
+        case kRemixFile:
+          // Keep the view referenced by the MANIFEST and any view that
+          // is still being written
+          keep = (number == versions_->RemixFileNumber() ||
+                  live.find(number) != live.end());
+          break;
         case kCurrentFile:
         case kDBLockFile:
         case kInfoLogFile:
@@ -280,7 +370,7 @@ void DBImpl::RemoveObsoleteFiles() {
 
       if (!keep) {
         files_to_delete.push_back(std::move(filename));
-        if (type == kTableFile) {
+        if (type == kTableFile || type == kBlobFile) {
           table_cache_->Evict(number);
         }
         Log(options_.info_log, "Delete type=%d #%lld\n", static_cast<int>(type),
@@ -512,53 +602,125 @@ Status DBImpl::RecoverLogFile(uint64_t log_number, bool last_log,
   return status;
 }
 
+// Record the range tombstones of "mems" in *edit, since tables only hold
+// the other entries.
+static void AddRangeTombstones(const Comparator* ucmp,
+                               const std::vector<MemTable*>& mems,
+                               VersionEdit* edit) {
+  for (MemTable* mem : mems) {
+    if (!mem->HasRangeTombstones()) {
+      continue;
+    }
+    Iterator* iter = mem->NewRangeTombstoneIterator();
+    for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+      ParsedInternalKey ikey;
+      if (ParseInternalKey(iter->key(), &ikey) &&
+          ucmp->Compare(ikey.user_key, iter->value()) < 0) {
+        edit->AddRangeTombstone(
+            RangeTombstone(ikey.user_key, iter->value(), ikey.sequence));
+      }
+    }
+    delete iter;
+  }
+}
+
 // minor compaction 的过程，将imm_写入到L0，也就是flush操作
 Status DBImpl::WriteLevel0Table(MemTable* mem, VersionEdit* edit,
                                 Version* base) {
   mutex_.AssertHeld();
   const uint64_t start_micros = env_->NowMicros();
   FileMetaData meta;
+  std::vector<MemTable*> mems(1, mem);
+  Status s = BuildLevel0Table(mems, &meta);
+  if (s.ok()) {
+    AddLevel0Table(meta, base, start_micros, edit);
+    AddRangeTombstones(user_comparator(), mems, edit);
+  }
+  pending_outputs_.erase(meta.number);
+  for (uint64_t blob : meta.blob_files) {
+    pending_outputs_.erase(blob);
+  }
+  return s;
+}
+
+// Write the entries of all of "mems" into one table
+Status DBImpl::BuildLevel0Table(const std::vector<MemTable*>& mems,
+                                FileMetaData* meta) {
+  mutex_.AssertHeld();
   // 生成sstable编号，用于构建文件名
-  meta.number = versions_->NewFileNumber();
-  pending_outputs_.insert(meta.number);
-  Iterator* iter = mem->NewIterator();
+  meta->number = versions_->NewFileNumber();
+  pending_outputs_.insert(meta->number);
+  std::vector<Iterator*> list;
+  for (MemTable* mem : mems) {
+    list.push_back(mem->NewIterator());
+  }
+  Iterator* iter =
+      NewMergingIterator(&internal_comparator_, &list[0], list.size());
   Log(options_.info_log, "Level-0 table #%llu: started",
-      (unsigned long long)meta.number);
+      (unsigned long long)meta->number);
+
+  // Large values go to a blob file, which stays in pending_outputs_ along
+  // with the table until the caller has installed both.
+  BlobFileBuilder* blobs = nullptr;
+  if (options_.blob_value_threshold > 0) {
+    blobs = new BlobFileBuilder(options_, dbname_, versions_->NewFileNumber());
+    pending_outputs_.insert(blobs->file_number());
+  }
 
   Status s;
   {
     // 更新memtable中的全部数据到xxx.ldb文件
     // meta记录key range, file_size等sst信息
     mutex_.Unlock();
-    s = BuildTable(dbname_, env_, options_, table_cache_, iter, &meta);
+    s = BuildTable(dbname_, env_, options_, table_cache_, iter, meta, blobs);
     mutex_.Lock();
   }
+  if (blobs != nullptr) {
+    if (meta->blob_files.empty()) {
+      pending_outputs_.erase(blobs->file_number());
+    }
+    delete blobs;
+  }
 
   Log(options_.info_log, "Level-0 table #%llu: %lld bytes %s",
-      (unsigned long long)meta.number, (unsigned long long)meta.file_size,
+      (unsigned long long)meta->number, (unsigned long long)meta->file_size,
       s.ToString().c_str());
   delete iter;
-  pending_outputs_.erase(meta.number);
+  return s;
+}
 
+void DBImpl::AddLevel0Table(const FileMetaData& meta, Version* base,
+                            uint64_t start_micros, VersionEdit* edit) {
+  mutex_.AssertHeld();
   // Note that if file_size is zero, the file has been deleted and
   // should not be added to the manifest.
   int level = 0;
-  if (s.ok() && meta.file_size > 0) {
+  if (meta.file_size > 0) {
     const Slice min_user_key = meta.smallest.user_key();
     const Slice max_user_key = meta.largest.user_key();
     if (base != nullptr) {
       // 为新生成的sstable选择合适的level(不一定总是0）
       level = base->PickLevelForMemTableOutput(min_user_key, max_user_key);
     }
-    edit->AddFile(level, meta.number, meta.file_size, meta.smallest,
-                  meta.largest);
+    edit->AddFile(level, meta);
   }
 
   CompactionStats stats;
   stats.micros = env_->NowMicros() - start_micros;
   stats.bytes_written = meta.file_size;
   stats_[level].Add(stats);
-  return s;
+}
+
+void DBImpl::RefMemTables(bool skip_empty_mem, std::vector<MemTable*>* mems) {
+  mutex_.AssertHeld();
+  if (!skip_empty_mem || !mem_->IsEmpty()) {
+    mem_->Ref();
+    mems->push_back(mem_);
+  }
+  for (auto iter = imm_.rbegin(); iter != imm_.rend(); ++iter) {
+    iter->mem->Ref();
+    mems->push_back(iter->mem);
+  }
 }
 
 /**
@@ -567,14 +729,17 @@ Status DBImpl::WriteLevel0Table(MemTable* mem, VersionEdit* edit,
  */
 void DBImpl::CompactMemTable() {
   mutex_.AssertHeld();
-  assert(imm_ != nullptr);
+  assert(!imm_.empty());
 
-  // Save the contents of the memtable as a new Table
-  VersionEdit edit;
-  Version* base = versions_->current();
-  base->Ref();
-  Status s = WriteLevel0Table(imm_, &edit, base);
-  base->Unref();
+  // Save the contents of the waiting memtables as a new Table.  More
+  // memtables may be queued meanwhile; they are left for the next call.
+  const uint64_t start_micros = env_->NowMicros();
+  std::vector<MemTable*> mems;
+  for (const ImmutableMemTable& imm : imm_) {
+    mems.push_back(imm.mem);
+  }
+  FileMetaData meta;
+  Status s = BuildLevel0Table(mems, &meta);
 
   if (s.ok() && shutting_down_.load(std::memory_order_acquire)) {
     s = Status::IOError("Deleting DB during memtable compaction");
@@ -582,16 +747,35 @@ void DBImpl::CompactMemTable() {
 
   // Replace immutable memtable with the generated Table
   if (s.ok()) {
+    LockManifest();
+    // The table may only skip level 0 while no compaction runs, since a
+    // running compaction may write keys of its range to a deeper level.
+    VersionEdit edit;
+    AddLevel0Table(meta,
+                   background_compactions_running_ == 0 ? versions_->current()
+                                                        : nullptr,
+                   start_micros, &edit);
+    AddRangeTombstones(user_comparator(), mems, &edit);
+    // Logs older than that of the oldest memtable still in memory are no
+    // longer needed
     edit.SetPrevLogNumber(0);
-    edit.SetLogNumber(logfile_number_);  // Earlier logs no longer needed
+    edit.SetLogNumber(imm_.size() > mems.size()
+                          ? imm_[mems.size()].log_number
+                          : logfile_number_);
     s = versions_->LogAndApply(&edit, &mutex_);
+    UnlockManifest();
+  }
+  pending_outputs_.erase(meta.number);
+  for (uint64_t blob : meta.blob_files) {
+    pending_outputs_.erase(blob);
   }
 
   if (s.ok()) {
     // Commit to the new state
-    imm_->Unref();
-    imm_ = nullptr;
-    has_imm_.store(false, std::memory_order_release);
+    for (MemTable* mem : mems) {
+      mem->Unref();
+      imm_.pop_front();
+    }
     RemoveObsoleteFiles();
   } else {
     RecordBackgroundError(s);
@@ -634,6 +818,7 @@ void DBImpl::TEST_CompactRange(int level, const Slice* begin,
   ManualCompaction manual;
   manual.level = level;
   manual.done = false;
+  manual.in_progress = false;
   if (begin == nullptr) {
     manual.begin = nullptr;
   } else {
@@ -657,6 +842,10 @@ void DBImpl::TEST_CompactRange(int level, const Slice* begin,
       background_work_finished_signal_.Wait();
     }
   }
+  while (manual.in_progress) {
+    // A background thread still uses my manual compaction.
+    background_work_finished_signal_.Wait();
+  }
   if (manual_compaction_ == &manual) {
     // Cancel my manual compaction since we aborted early for some reason.
     manual_compaction_ = nullptr;
@@ -669,10 +858,10 @@ Status DBImpl::TEST_CompactMemTable() {
   if (s.ok()) {
     // Wait until the compaction completes
     MutexLock l(&mutex_);
-    while (imm_ != nullptr && bg_error_.ok()) {
+    while (!imm_.empty() && bg_error_.ok()) {
       background_work_finished_signal_.Wait();
     }
-    if (imm_ != nullptr) {
+    if (!imm_.empty()) {
       s = bg_error_;
     }
   }
@@ -687,35 +876,106 @@ void DBImpl::RecordBackgroundError(const Status& s) {
   }
 }
 
+void DBImpl::LockManifest() {
+  mutex_.AssertHeld();
+  while (manifest_locked_) {
+    background_work_finished_signal_.Wait();
+  }
+  manifest_locked_ = true;
+}
+
+void DBImpl::UnlockManifest() {
+  mutex_.AssertHeld();
+  assert(manifest_locked_);
+  manifest_locked_ = false;
+  background_work_finished_signal_.SignalAll();
+}
+
+SequenceNumber DBImpl::SmallestSnapshot() {
+  mutex_.AssertHeld();
+  if (snapshots_.empty()) {
+    return versions_->LastSequence();
+  } else {
+    return snapshots_.oldest()->sequence_number();
+  }
+}
+
+bool DBImpl::HasCompactionWork() {
+  mutex_.AssertHeld();
+  const ManualCompaction* m = manual_compaction_;
+  if (m != nullptr && !m->in_progress && !compacting_levels_[m->level] &&
+      !compacting_levels_[m->level + 1]) {
+    return true;
+  }
+  return versions_->NeedsCompaction(compacting_levels_) ||
+         versions_->PickRangeDeletions(SmallestSnapshot(), compacting_levels_,
+                                       nullptr);
+}
+
 /**
- * @brief 开启一个背景线程，将imm_写入磁盘生成一个新的sstable；对各个level中的文件进行合并，避免某个level中的文件过多，以及删除掉一些过期或者已经被用户调用delete删除的key-value。这个函数试图启动一个新的线程，因此它不是肯定会启动一个背景线程。 
+ * @brief 开启背景线程：将imm_写入磁盘生成一个新的sstable；对各个level中的文件进行合并，避免某个level中的文件过多，以及删除掉一些过期或者已经被用户调用delete删除的key-value。imm_由单独的线程写入磁盘，互不重叠的level可以由多个线程同时合并，因此它不是肯定会启动一个背景线程。
  * @return {*}
  */
 void DBImpl::MaybeScheduleCompaction() {
-  mutex_.AssertHeld(); // 这个函数试图启动一个新的线程，因此它不是肯定会启动一个背景线程。
-  if (background_compaction_scheduled_) {
-    // Already scheduled
-  } else if (shutting_down_.load(std::memory_order_acquire)) {
+  mutex_.AssertHeld();
+  if (options_.rate_limiter != nullptr) {
+    options_.rate_limiter->SetPendingCompactionBytes(
+        versions_->PendingCompactionBytes());
+  }
+  if (shutting_down_.load(std::memory_order_acquire)) {
     // DB is being deleted; no more background compactions
   } else if (!bg_error_.ok()) {
     // Already got an error; no more changes
-  } else if (imm_ == nullptr && manual_compaction_ == nullptr &&
-             !versions_->NeedsCompaction()) {
-    // No work to be done
   } else {
-    // 告诉其他线程当前数据库中已经有一个背景线程在运行了，数据库只能允许一个背景线程运行
-    background_compaction_scheduled_ = true;
-    env_->Schedule(&DBImpl::BGWork, this);
+    if (!imm_.empty() && !background_flush_scheduled_) {
+      // Flushes get a thread of their own so that writers never wait for
+      // a long compaction to finish.
+      background_flush_scheduled_ = true;
+      env_->StartThread(&DBImpl::BGFlushWork, this);
+    }
+    // Start one compaction thread at a time.  Once it has picked its
+    // compaction it calls back here, so that another thread can pick a
+    // compaction of the levels left.
+    if (background_compactions_scheduled_ == background_compactions_running_ &&
+        background_compactions_scheduled_ <
+            options_.max_background_compactions &&
+        HasCompactionWork()) {
+      background_compactions_scheduled_++;
+      env_->StartThread(&DBImpl::BGWork, this);
+    }
   }
 }
 
+void DBImpl::BGFlushWork(void* db) {
+  reinterpret_cast<DBImpl*>(db)->BackgroundFlushCall();
+}
+
 void DBImpl::BGWork(void* db) {
   reinterpret_cast<DBImpl*>(db)->BackgroundCall();
 }
 
+void DBImpl::BackgroundFlushCall() {
+  MutexLock l(&mutex_);
+  assert(background_flush_scheduled_);
+  if (shutting_down_.load(std::memory_order_acquire)) {
+    // No more background work when shutting down.
+  } else if (!bg_error_.ok()) {
+    // No more background work after a background error.
+  } else if (!imm_.empty()) {
+    CompactMemTable();
+    UpdateRemixView();
+  }
+
+  background_flush_scheduled_ = false;
+
+  // 在写盘期间，用户线程可能又写满了mem_，level 0也可能需要合并
+  MaybeScheduleCompaction();
+  background_work_finished_signal_.SignalAll();
+}
+
 void DBImpl::BackgroundCall() {
   MutexLock l(&mutex_);
-  assert(background_compaction_scheduled_);
+  assert(background_compactions_scheduled_ > 0);
   if (shutting_down_.load(std::memory_order_acquire)) {
     // No more background work when shutting down.
   } else if (!bg_error_.ok()) {
@@ -724,13 +984,10 @@ void DBImpl::BackgroundCall() {
     BackgroundCompaction();
   }
 
-  background_compaction_scheduled_ = false;
+  background_compactions_scheduled_--;
 
   // Previous compaction may have produced too many files in a level,
   // so reschedule another compaction if needed.
-  // 因为在背景线程执行的时候，其他的用户线程可能已经向mem_写入了很多数据，
-  // 而imm_在BackgroundCompaction已经被写入磁盘变为空，所以可能此时imm又已经被写满的mem_赋值了，
-  // 所以应该尝试继续开启新的线程对imm_进行写盘。
   MaybeScheduleCompaction();
   background_work_finished_signal_.SignalAll();
 }
@@ -742,16 +999,40 @@ void DBImpl::BackgroundCall() {
 void DBImpl::BackgroundCompaction() {
   mutex_.AssertHeld();
 
-  if (imm_ != nullptr) {
-    CompactMemTable();
+  // Wait for the MANIFEST write in progress, so that the compaction is
+  // picked from the latest version.
+  while (manifest_locked_ && !shutting_down_.load(std::memory_order_acquire)) {
+    background_work_finished_signal_.Wait();
+  }
+  if (shutting_down_.load(std::memory_order_acquire) || !bg_error_.ok()) {
     return;
   }
 
+  // Table files and range tombstones made obsolete by range deletions are
+  // dropped without a compaction.
+  VersionEdit range_edit;
+  if (versions_->PickRangeDeletions(SmallestSnapshot(), compacting_levels_,
+                                    &range_edit)) {
+    LockManifest();
+    Status s = versions_->LogAndApply(&range_edit, &mutex_);
+    UnlockManifest();
+    if (!s.ok()) {
+      RecordBackgroundError(s);
+      return;
+    }
+    Log(options_.info_log, "Dropped range-deleted files: %s",
+        range_edit.DebugString().c_str());
+    RemoveObsoleteFiles();
+  }
+
   Compaction* c;
-  bool is_manual = (manual_compaction_ != nullptr);
+  ManualCompaction* m = manual_compaction_;
+  bool is_manual = (m != nullptr && !m->in_progress &&
+                    !compacting_levels_[m->level] &&
+                    !compacting_levels_[m->level + 1]);
   InternalKey manual_end;
   if (is_manual) {
-    ManualCompaction* m = manual_compaction_;
+    m->in_progress = true;
     c = versions_->CompactRange(m->level, m->begin, m->end);
     m->done = (c == nullptr);
     if (c != nullptr) {
@@ -763,7 +1044,18 @@ void DBImpl::BackgroundCompaction() {
         (m->end ? m->end->DebugString().c_str() : "(end)"),
         (m->done ? "(end)" : manual_end.DebugString().c_str()));
   } else {
-    c = versions_->PickCompaction();
+    c = versions_->PickCompaction(compacting_levels_);
+  }
+
+  // Keep other compactions off the levels of this one, and let another
+  // thread look for a compaction of the remaining levels.
+  int level = -1;
+  if (c != nullptr) {
+    level = c->level();
+    compacting_levels_[level] = true;
+    compacting_levels_[level + 1] = true;
+    background_compactions_running_++;
+    MaybeScheduleCompaction();
   }
 
   Status status;
@@ -774,9 +1066,10 @@ void DBImpl::BackgroundCompaction() {
     assert(c->num_input_files(0) == 1);
     FileMetaData* f = c->input(0, 0);
     c->edit()->RemoveFile(c->level(), f->number);
-    c->edit()->AddFile(c->level() + 1, f->number, f->file_size, f->smallest,
-                       f->largest);
+    c->edit()->AddFile(c->level() + 1, *f);
+    LockManifest();
     status = versions_->LogAndApply(c->edit(), &mutex_);
+    UnlockManifest();
     if (!status.ok()) {
       RecordBackgroundError(status);
     }
@@ -796,6 +1089,12 @@ void DBImpl::BackgroundCompaction() {
     RemoveObsoleteFiles();
   }
   delete c;
+  if (level >= 0) {
+    compacting_levels_[level] = false;
+    compacting_levels_[level + 1] = false;
+    background_compactions_running_--;
+  }
+  UpdateRemixView();
 
   if (status.ok()) {
     // Done
@@ -806,7 +1105,7 @@ void DBImpl::BackgroundCompaction() {
   }
 
   if (is_manual) {
-    ManualCompaction* m = manual_compaction_;
+    assert(manual_compaction_ == m);
     if (!status.ok()) {
       m->done = true;
     }
@@ -816,6 +1115,7 @@ void DBImpl::BackgroundCompaction() {
       m->tmp_storage = manual_end;
       m->begin = &m->tmp_storage;
     }
+    m->in_progress = false;
     manual_compaction_ = nullptr;
   }
 }
@@ -830,10 +1130,14 @@ void DBImpl::CleanupCompaction(CompactionState* compact) {
     assert(compact->outfile == nullptr);
   }
   delete compact->outfile;
+  delete compact->blobs;
   for (size_t i = 0; i < compact->outputs.size(); i++) {
     const CompactionState::Output& out = compact->outputs[i];
     pending_outputs_.erase(out.number);
   }
+  for (uint64_t blob : compact->blob_numbers) {
+    pending_outputs_.erase(blob);
+  }
   delete compact;
 }
 
@@ -849,6 +1153,8 @@ Status DBImpl::OpenCompactionOutputFile(CompactionState* compact) {
     out.number = file_number;
     out.smallest.Clear();
     out.largest.Clear();
+    out.smallest_sequence = kMaxSequenceNumber;
+    out.largest_sequence = 0;
     compact->outputs.push_back(out);
     mutex_.Unlock();
   }
@@ -923,16 +1229,25 @@ Status DBImpl::InstallCompactionResults(CompactionState* compact) {
   const int level = compact->compaction->level();
   for (size_t i = 0; i < compact->outputs.size(); i++) {
     const CompactionState::Output& out = compact->outputs[i];
-    compact->compaction->edit()->AddFile(level + 1, out.number, out.file_size,
-                                         out.smallest, out.largest);
-  }
-  return versions_->LogAndApply(compact->compaction->edit(), &mutex_);
+    FileMetaData f;
+    f.number = out.number;
+    f.file_size = out.file_size;
+    f.smallest = out.smallest;
+    f.largest = out.largest;
+    f.smallest_sequence = out.smallest_sequence;
+    f.largest_sequence = out.largest_sequence;
+    f.blob_files.assign(out.blob_files.begin(), out.blob_files.end());
+    compact->compaction->edit()->AddFile(level + 1, f);
+  }
+  LockManifest();
+  Status s = versions_->LogAndApply(compact->compaction->edit(), &mutex_);
+  UnlockManifest();
+  return s;
 }
 
 // 进行compaction 操作
 Status DBImpl::DoCompactionWork(CompactionState* compact) {
   const uint64_t start_micros = env_->NowMicros();
-  int64_t imm_micros = 0;  // Micros spent doing imm_ compactions
 
   Log(options_.info_log, "Compacting %d@%d + %d@%d files",
       compact->compaction->num_input_files(0), compact->compaction->level(),
@@ -944,10 +1259,39 @@ Status DBImpl::DoCompactionWork(CompactionState* compact) {
   assert(compact->outfile == nullptr);
   // 计算最小序列号，如果compaction操作过程中有重复写入的键为最小的序列号
   // 要根据该序列号判断是否可以删除该键
-  if (snapshots_.empty()) {
-    compact->smallest_snapshot = versions_->LastSequence();
-  } else {
-    compact->smallest_snapshot = snapshots_.oldest()->sequence_number();
+  compact->smallest_snapshot = SmallestSnapshot();
+  RangeTombstoneSet range_tombstones(user_comparator(),
+                                     compact->smallest_snapshot);
+  for (const RangeTombstone& t : versions_->current()->range_tombstones()) {
+    range_tombstones.Add(t.begin, t.end, t.sequence);
+  }
+  range_tombstones.Finish();
+  compact->range_tombstones = &range_tombstones;
+  compact->blob_gc_before = BlobGarbageCollectionLimit();
+  // Large compactions are split into key ranges at input file boundaries.
+  // This thread merges the first range and every other range is merged on
+  // a thread of its own.
+  std::vector<std::string> boundaries;
+  if (options_.max_subcompactions > 1) {
+    compact->compaction->GetSubcompactionBoundaries(options_.max_subcompactions,
+                                                    &boundaries);
+  }
+  std::vector<Subcompaction> subs(boundaries.size());
+  for (size_t i = 0; i < subs.size(); i++) {
+    CompactionState* sub = new CompactionState(compact->compaction);
+    sub->start = &boundaries[i];
+    sub->end = (i + 1 < boundaries.size()) ? &boundaries[i + 1] : nullptr;
+    sub->smallest_snapshot = compact->smallest_snapshot;
+    sub->range_tombstones = compact->range_tombstones;
+    sub->blob_gc_before = compact->blob_gc_before;
+    subs[i].db = this;
+    subs[i].compact = sub;
+    subs[i].input = versions_->MakeInputIterator(compact->compaction);
+    subs[i].done = false;
+    env_->StartThread(&DBImpl::BGSubcompactionWork, &subs[i]);
+  }
+  if (!boundaries.empty()) {
+    compact->end = &boundaries[0];
   }
     // 这里生成一个MergingIterator，相当于在遍历要合并的sst文件时，同时进行多路归并排序
   // MergingIterator内部维护了n个Iterator，每个Iterator指向一个sst，进行迭代时，MergingIterator
@@ -956,30 +1300,94 @@ Status DBImpl::DoCompactionWork(CompactionState* compact) {
 
   // Release mutex while we're actually doing the compaction work
   mutex_.Unlock();
+  Status status = CompactKeyRange(compact, input);
+  mutex_.Lock();
 
-  input->SeekToFirst();
-  Status status;
+  // Take over the output files of the other key ranges, which follow
+  // those of this thread in key order.
+  for (Subcompaction& sub : subs) {
+    while (!sub.done) {
+      background_work_finished_signal_.Wait();
+    }
+    if (status.ok()) {
+      status = sub.status;
+    }
+    compact->outputs.insert(compact->outputs.end(),
+                            sub.compact->outputs.begin(),
+                            sub.compact->outputs.end());
+    compact->total_bytes += sub.compact->total_bytes;
+    sub.compact->outputs.clear();
+    compact->blob_numbers.insert(compact->blob_numbers.end(),
+                                 sub.compact->blob_numbers.begin(),
+                                 sub.compact->blob_numbers.end());
+    sub.compact->blob_numbers.clear();
+    CleanupCompaction(sub.compact);
+  }
+
+  CompactionStats stats;
+  stats.micros = env_->NowMicros() - start_micros;
+  for (int which = 0; which < 2; which++) {
+    for (int i = 0; i < compact->compaction->num_input_files(which); i++) {
+      stats.bytes_read += compact->compaction->input(which, i)->file_size;
+    }
+  }
+  for (size_t i = 0; i < compact->outputs.size(); i++) {
+    stats.bytes_written += compact->outputs[i].file_size;
+  }
+  stats_[compact->compaction->level() + 1].Add(stats);
+
+  if (status.ok()) {
+    status = InstallCompactionResults(compact);
+  }
+  if (!status.ok()) {
+    RecordBackgroundError(status);
+  }
+  VersionSet::LevelSummaryStorage tmp;
+  Log(options_.info_log, "compacted to: %s", versions_->LevelSummary(&tmp));
+  return status;
+}
+
+void DBImpl::BGSubcompactionWork(void* arg) {
+  Subcompaction* sub = reinterpret_cast<Subcompaction*>(arg);
+  DBImpl* db = sub->db;
+  Status s = db->CompactKeyRange(sub->compact, sub->input);
+  MutexLock l(&db->mutex_);
+  sub->status = s;
+  sub->done = true;
+  db->background_work_finished_signal_.SignalAll();
+}
+
+Status DBImpl::CompactKeyRange(CompactionState* compact, Iterator* input) {
+  const Comparator* const ucmp = user_comparator();
   ParsedInternalKey ikey;
+  if (compact->start == nullptr) {
+    input->SeekToFirst();
+  } else {
+    // Entries up to and including the start key belong to the previous
+    // key range.
+    InternalKey start(*compact->start, kMaxSequenceNumber, kValueTypeForSeek);
+    input->Seek(start.Encode());
+    while (input->Valid() && (!ParseInternalKey(input->key(), &ikey) ||
+                              ucmp->Compare(ikey.user_key, *compact->start) <=
+                                  0)) {
+      input->Next();
+    }
+  }
+
+  Status status;
   std::string current_user_key;
   bool has_current_user_key = false;
   SequenceNumber last_sequence_for_key = kMaxSequenceNumber;
+  std::string compacted_key, blob_value, blob_index;
   // 遍历迭代器
   while (input->Valid() && !shutting_down_.load(std::memory_order_acquire)) {
-    // Prioritize immutable compaction work
-    if (has_imm_.load(std::memory_order_relaxed)) {
-      const uint64_t imm_start = env_->NowMicros();
-      mutex_.Lock();
-      if (imm_ != nullptr) {
-        CompactMemTable();
-        // Wake up MakeRoomForWrite() if necessary.
-        background_work_finished_signal_.SignalAll();
-      }
-      mutex_.Unlock();
-      imm_micros += (env_->NowMicros() - imm_start);
-    }
-
     Slice key = input->key();
-    if (compact->compaction->ShouldStopBefore(key) &&
+    if (compact->end != nullptr && ParseInternalKey(key, &ikey) &&
+        ucmp->Compare(ikey.user_key, *compact->end) > 0) {
+      // The rest belongs to the next key range
+      break;
+    }
+    if (compact->compaction->ShouldStopBefore(key, &compact->cursor) &&
         compact->builder != nullptr) {
       status = FinishCompactionOutputFile(compact, input);
       if (!status.ok()) {
@@ -996,8 +1404,7 @@ Status DBImpl::DoCompactionWork(CompactionState* compact) {
       last_sequence_for_key = kMaxSequenceNumber;
     } else {
       if (!has_current_user_key ||
-          user_comparator()->Compare(ikey.user_key, Slice(current_user_key)) !=
-              0) {
+          ucmp->Compare(ikey.user_key, Slice(current_user_key)) != 0) {
         // First occurrence of this user key
         current_user_key.assign(ikey.user_key.data(), ikey.user_key.size());
         has_current_user_key = true;
@@ -1007,9 +1414,13 @@ Status DBImpl::DoCompactionWork(CompactionState* compact) {
       if (last_sequence_for_key <= compact->smallest_snapshot) {
         // Hidden by an newer entry for same user key
         drop = true;  // (A)
+      } else if (compact->range_tombstones->ShouldDelete(ikey)) {
+        // Deleted by a range tombstone that every snapshot sees
+        drop = true;
       } else if (ikey.type == kTypeDeletion &&
                  ikey.sequence <= compact->smallest_snapshot &&
-                 compact->compaction->IsBaseLevelForKey(ikey.user_key)) {
+                 compact->compaction->IsBaseLevelForKey(ikey.user_key,
+                                                    &compact->cursor)) {
         // For this user key:
         // (1) there is no data in higher levels
         // (2) data in lower levels will have larger sequence numbers
@@ -1040,11 +1451,36 @@ Status DBImpl::DoCompactionWork(CompactionState* compact) {
           break;
         }
       }
+      Slice value = input->value();
+      if (has_current_user_key &&
+          (ikey.type == kTypeValue || ikey.type == kTypeBlobIndex)) {
+        const ValueType type = ikey.type;
+        status = CompactValue(compact, &ikey, &value, &blob_value, &blob_index);
+        if (!status.ok()) {
+          break;
+        }
+        if (ikey.type != type) {
+          compacted_key.clear();
+          AppendInternalKey(&compacted_key, ikey);
+          key = compacted_key;
+        }
+      }
+      CompactionState::Output* out = compact->current_output();
       if (compact->builder->NumEntries() == 0) {
-        compact->current_output()->smallest.DecodeFrom(key);
+        out->smallest.DecodeFrom(key);
       }
-      compact->current_output()->largest.DecodeFrom(key);
-      compact->builder->Add(key, input->value());
+      out->largest.DecodeFrom(key);
+      if (has_current_user_key) {
+        out->smallest_sequence =
+            std::min(out->smallest_sequence, ikey.sequence);
+        out->largest_sequence =
+            std::max(out->largest_sequence, ikey.sequence);
+      } else {
+        // Keep the widest bounds for keys that cannot be parsed
+        out->smallest_sequence = 0;
+        out->largest_sequence = kMaxSequenceNumber;
+      }
+      compact->builder->Add(key, value);
 
       // Close output file if it is big enough
       if (compact->builder->FileSize() >=
@@ -1065,35 +1501,74 @@ Status DBImpl::DoCompactionWork(CompactionState* compact) {
   if (status.ok() && compact->builder != nullptr) {
     status = FinishCompactionOutputFile(compact, input);
   }
+  if (status.ok() && compact->blobs != nullptr) {
+    status = compact->blobs->Finish();
+  }
   if (status.ok()) {
     status = input->status();
   }
   delete input;
-  input = nullptr;
+  return status;
+}
 
-  CompactionStats stats;
-  stats.micros = env_->NowMicros() - start_micros - imm_micros;
-  for (int which = 0; which < 2; which++) {
-    for (int i = 0; i < compact->compaction->num_input_files(which); i++) {
-      stats.bytes_read += compact->compaction->input(which, i)->file_size;
+Status DBImpl::CompactValue(CompactionState* compact, ParsedInternalKey* ikey,
+                            Slice* value, std::string* blob_value,
+                            std::string* blob_index) {
+  Status s;
+  if (ikey->type == kTypeBlobIndex) {
+    BlobIndex index;
+    if (!index.DecodeFrom(*value)) {
+      return Status::Corruption("bad blob index for", ikey->user_key);
     }
+    if (index.file_number >= compact->blob_gc_before) {
+      compact->current_output()->blob_files.insert(index.file_number);
+      return s;
+    }
+    ReadOptions options;
+    options.verify_checksums = options_.paranoid_checks;
+    options.fill_cache = false;
+    s = table_cache_->GetBlob(options, *value, blob_value);
+    if (!s.ok()) {
+      return s;
+    }
+    *value = *blob_value;
+    ikey->type = kTypeValue;
   }
-  for (size_t i = 0; i < compact->outputs.size(); i++) {
-    stats.bytes_written += compact->outputs[i].file_size;
-  }
-
-  mutex_.Lock();
-  stats_[compact->compaction->level() + 1].Add(stats);
 
-  if (status.ok()) {
-    status = InstallCompactionResults(compact);
-  }
-  if (!status.ok()) {
-    RecordBackgroundError(status);
+  if (options_.blob_value_threshold > 0 &&
+      value->size() >= options_.blob_value_threshold) {
+    if (compact->blobs == nullptr) {
+      mutex_.Lock();
+      compact->blobs =
+          new BlobFileBuilder(options_, dbname_, versions_->NewFileNumber());
+      pending_outputs_.insert(compact->blobs->file_number());
+      compact->blob_numbers.push_back(compact->blobs->file_number());
+      mutex_.Unlock();
+    }
+    s = compact->blobs->Add(*value, blob_index);
+    if (s.ok()) {
+      *value = *blob_index;
+      ikey->type = kTypeBlobIndex;
+      compact->current_output()->blob_files.insert(
+          compact->blobs->file_number());
+    }
   }
-  VersionSet::LevelSummaryStorage tmp;
-  Log(options_.info_log, "compacted to: %s", versions_->LevelSummary(&tmp));
-  return status;
+  return s;
+}
+
+uint64_t DBImpl::BlobGarbageCollectionLimit() {
+  mutex_.AssertHeld();
+  std::set<uint64_t> blob_files;
+  versions_->current()->AddBlobFiles(&blob_files);
+  const size_t n = std::min(
+      blob_files.size(),
+      static_cast<size_t>(blob_files.size() * options_.blob_gc_age_cutoff));
+  if (n == 0) {
+    return 0;
+  }
+  auto iter = blob_files.begin();
+  std::advance(iter, n - 1);
+  return *iter + 1;
 }
 
 namespace {
@@ -1101,18 +1576,17 @@ namespace {
 struct IterState {
   port::Mutex* const mu;
   Version* const version GUARDED_BY(mu);
-  MemTable* const mem GUARDED_BY(mu);
-  MemTable* const imm GUARDED_BY(mu);
+  const std::vector<MemTable*> mems GUARDED_BY(mu);
 
-  IterState(port::Mutex* mutex, MemTable* mem, MemTable* imm, Version* version)
-      : mu(mutex), version(version), mem(mem), imm(imm) {}
+  IterState(port::Mutex* mutex, const std::vector<MemTable*>& mems,
+            Version* version)
+      : mu(mutex), version(version), mems(mems) {}
 };
 
 static void CleanupIteratorState(void* arg1, void* arg2) {
   IterState* state = reinterpret_cast<IterState*>(arg1);
   state->mu->Lock();
-  state->mem->Unref();
-  if (state->imm != nullptr) state->imm->Unref();
+  for (MemTable* mem : state->mems) mem->Unref();
   state->version->Unref();
   state->mu->Unlock();
   delete state;
@@ -1129,39 +1603,81 @@ static void CleanupIteratorState(void* arg1, void* arg2) {
  */
 Iterator* DBImpl::NewInternalIterator(const ReadOptions& options,
                                       SequenceNumber* latest_snapshot,
-                                      uint32_t* seed) {
+                                      uint32_t* seed,
+                                      RangeTombstoneSet** tombstones) {
   mutex_.Lock();
   *latest_snapshot = versions_->LastSequence();
 
   // Collect together all needed child iterators
   std::vector<Iterator*> list;
   // 先将memtable的迭代器加入list
-  list.push_back(mem_->NewIterator());
-  mem_->Ref();
-  if (imm_ != nullptr) {
-    list.push_back(imm_->NewIterator());
-    imm_->Ref();
+  std::vector<MemTable*> mems;
+  RefMemTables(false, &mems);
+  for (MemTable* mem : mems) {
+    list.push_back(mem->NewIterator());
   }
   versions_->current()->AddIterators(options, &list);
   // 产生全局有序视图，一个全局有序的迭代器
   Iterator* internal_iter =
       NewMergingIterator(&internal_comparator_, &list[0], list.size());
   versions_->current()->Ref();
-  //internal_iter->set_comparator(&internal_comparator_);
 
-  IterState* cleanup = new IterState(&mutex_, mem_, imm_, versions_->current());
+  IterState* cleanup = new IterState(&mutex_, mems, versions_->current());
   internal_iter->RegisterCleanup(CleanupIteratorState, cleanup, nullptr);
+  if (versions_->current()->HasBlobFiles()) {
+    internal_iter =
+        NewBlobResolvingIterator(internal_iter, table_cache_, options);
+  }
+
+  if (tombstones != nullptr) {
+    *tombstones = NewRangeTombstoneSet(
+        mems, versions_->current(),
+        options.snapshot != nullptr
+            ? static_cast<const SnapshotImpl*>(options.snapshot)
+                  ->sequence_number()
+            : *latest_snapshot);
+  }
 
   *seed = ++seed_;
   mutex_.Unlock();
-  internal_iter->set_runs_num(list.size());
   return internal_iter;
 }
 
 Iterator* DBImpl::TEST_NewInternalIterator() {
   SequenceNumber ignored;
   uint32_t ignored_seed;
-  return NewInternalIterator(ReadOptions(), &ignored, &ignored_seed);
+  return NewInternalIterator(ReadOptions(), &ignored, &ignored_seed, nullptr);
+}
+
+RangeTombstoneSet* DBImpl::NewRangeTombstoneSet(
+    const std::vector<MemTable*>& mems, Version* version,
+    SequenceNumber snapshot) const {
+  bool found = !version->range_tombstones().empty();
+  for (size_t i = 0; i < mems.size() && !found; i++) {
+    found = mems[i]->HasRangeTombstones();
+  }
+  if (!found) {
+    return nullptr;
+  }
+
+  RangeTombstoneSet* tombstones =
+      new RangeTombstoneSet(user_comparator(), snapshot);
+  for (MemTable* mem : mems) {
+    if (mem->HasRangeTombstones()) {
+      Iterator* iter = mem->NewRangeTombstoneIterator();
+      tombstones->AddAll(iter);
+      delete iter;
+    }
+  }
+  for (const RangeTombstone& t : version->range_tombstones()) {
+    tombstones->Add(t.begin, t.end, t.sequence);
+  }
+  if (tombstones->empty()) {
+    delete tombstones;
+    return nullptr;
+  }
+  tombstones->Finish();
+  return tombstones;
 }
 
 int64_t DBImpl::TEST_MaxNextLevelOverlappingBytes() {
@@ -1183,14 +1699,12 @@ Status DBImpl::Get(const ReadOptions& options, const Slice& key,
     snapshot = versions_->LastSequence();
   }
 
-  MemTable* mem = mem_;
-  MemTable* imm = imm_;
+  // MemTable， Immutable Memtable 和 Current Version（SSTable） 增加引用计数，避免在读取过程中被后台线程进行 compaction 时“垃圾回收”了。
+  std::vector<MemTable*> mems;
+  RefMemTables(false, &mems);
   // 表示当前的一个版本
   // SSTable
-  // MemTable， Immutable Memtable 和 Current Version（SSTable） 增加引用计数，避免在读取过程中被后台线程进行 compaction 时“垃圾回收”了。
   Version* current = versions_->current();
-  mem->Ref();
-  if (imm != nullptr) imm->Ref();
   current->Ref();
 
   bool have_stat_update = false;
@@ -1201,15 +1715,26 @@ Status DBImpl::Get(const ReadOptions& options, const Slice& key,
   {
     mutex_.Unlock();
     // 释放了锁，因此各个线程可以并发执行
-    // First look in the memtable, then in the immutable memtable (if any).
+    // First look in the memtable, then in the immutable memtables, newest
+    // first.
     // 通过该对象进行索引
     LookupKey lkey(key, snapshot);
-    if (mem->Get(lkey, value, &s)) { // 在memtable中找
-      // Done
-    } else if (imm != nullptr && imm->Get(lkey, value, &s)) { // 在immune memtable中找
-      // Done
-    } else { // SStable
-      s = current->Get(options, lkey, value, &stats);
+    SequenceNumber deleted_before = 0;
+    RangeTombstoneSet* tombstones =
+        NewRangeTombstoneSet(mems, current, snapshot);
+    if (tombstones != nullptr) {
+      deleted_before = tombstones->MaxCoveringSequence(key);
+      delete tombstones;
+    }
+    bool found = false;
+    for (MemTable* mem : mems) {
+      if (mem->Get(lkey, value, &s, deleted_before)) {
+        found = true;
+        break;
+      }
+    }
+    if (!found) { // SStable
+      s = current->Get(options, lkey, value, &stats, deleted_before);
       have_stat_update = true;
     }
     mutex_.Lock();
@@ -1218,22 +1743,377 @@ Status DBImpl::Get(const ReadOptions& options, const Slice& key,
   if (have_stat_update && current->UpdateStats(stats)) {
     MaybeScheduleCompaction();
   }
-  mem->Unref();
-  if (imm != nullptr) imm->Unref();
+  for (MemTable* mem : mems) mem->Unref();
   current->Unref();
   return s;
 }
+std::vector<Status> DBImpl::MultiGet(const ReadOptions& options,
+                                     const std::vector<Slice>& keys,
+                                     std::vector<std::string>* values) {
+  const size_t n = keys.size();
+  values->assign(n, std::string());
+  std::vector<Status> statuses(n);
+  if (n == 0) {
+    return statuses;
+  }
+
+  mutex_.Lock();
+  SequenceNumber snapshot;
+  if (options.snapshot != nullptr) {
+    snapshot =
+        static_cast<const SnapshotImpl*>(options.snapshot)->sequence_number();
+  } else {
+    snapshot = versions_->LastSequence();
+  }
+  std::vector<MemTable*> mems;
+  RefMemTables(false, &mems);
+  Version* current = versions_->current();
+  current->Ref();
+  mutex_.Unlock();
+
+  // Sort the keys so that Version::MultiGet() finds the keys of each table
+  // file next to each other.
+  std::vector<size_t> order(n);
+  for (size_t i = 0; i < n; i++) {
+    order[i] = i;
+  }
+  const Comparator* ucmp = user_comparator();
+  std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+    return ucmp->Compare(keys[a], keys[b]) < 0;
+  });
+
+  RangeTombstoneSet* tombstones = NewRangeTombstoneSet(mems, current, snapshot);
+  std::deque<LookupKey> lkeys;
+  std::vector<Version::KeyLookup> lookups(n);
+  std::vector<Version::KeyLookup*> sorted(n);
+  for (size_t i = 0; i < n; i++) {
+    const size_t k = order[i];
+    lkeys.emplace_back(keys[k], snapshot);
+    Version::KeyLookup* lookup = &lookups[k];
+    lookup->key = &lkeys.back();
+    lookup->value = &(*values)[k];
+    lookup->done = false;
+    lookup->deleted_before =
+        tombstones != nullptr ? tombstones->MaxCoveringSequence(keys[k]) : 0;
+    for (MemTable* mem : mems) {
+      if (mem->Get(*lookup->key, lookup->value, &lookup->status,
+                   lookup->deleted_before)) {
+        lookup->done = true;
+        break;
+      }
+    }
+    sorted[i] = lookup;
+  }
+  delete tombstones;
+  current->MultiGet(options, sorted);
+
+  mutex_.Lock();
+  bool schedule = false;
+  for (size_t i = 0; i < n; i++) {
+    if (current->UpdateStats(lookups[i].stats)) {
+      schedule = true;
+    }
+    statuses[i] = lookups[i].status;
+  }
+  if (schedule) {
+    MaybeScheduleCompaction();
+  }
+  for (MemTable* mem : mems) mem->Unref();
+  current->Unref();
+  mutex_.Unlock();
+  return statuses;
+}
+
 // 构造一个新得迭代器
 Iterator* DBImpl::NewIterator(const ReadOptions& options) {
+  if (options_.use_remix) {
+    mutex_.Lock();
+    // The view only covers the tables of its version; newer entries must
+    // still be in the memtables.
+    if (remix_ != nullptr && remix_->version() == versions_->current()) {
+      return NewRemixDBIterator(remix_, options, true);
+    }
+    mutex_.Unlock();
+  }
+
   SequenceNumber latest_snapshot;
   uint32_t seed;
-  Iterator* iter = NewInternalIterator(options, &latest_snapshot, &seed);
+  RangeTombstoneSet* tombstones;
+  Iterator* iter =
+      NewInternalIterator(options, &latest_snapshot, &seed, &tombstones);
   return NewDBIterator(this, user_comparator(), iter,
                        (options.snapshot != nullptr
                             ? static_cast<const SnapshotImpl*>(options.snapshot)
                                   ->sequence_number()
                             : latest_snapshot),
-                       seed);
+                       seed, tombstones, PrefixExtractor(options));
+}
+
+namespace {
+
+struct RemixIterState {
+  port::Mutex* const mu;
+  RemixView* const view GUARDED_BY(mu);
+  const std::vector<MemTable*> mems GUARDED_BY(mu);
+
+  RemixIterState(port::Mutex* mutex, RemixView* view,
+                 const std::vector<MemTable*>& mems)
+      : mu(mutex), view(view), mems(mems) {}
+};
+
+static void CleanupRemixIteratorState(void* arg1, void* arg2) {
+  RemixIterState* state = reinterpret_cast<RemixIterState*>(arg1);
+  state->mu->Lock();
+  state->view->Unref();
+  for (MemTable* mem : state->mems) mem->Unref();
+  state->mu->Unlock();
+  delete state;
+}
+
+// Read the REMIX file "fname" and decode it as a view of "version".  The
+// view is not served from the file: Decode() copies the segments into the
+// arrays of the view, which Update() and SetMemoryBudget() work on.
+static Status LoadRemixView(Env* env, TableCache* table_cache,
+                            const InternalKeyComparator* icmp,
+                            const std::string& fname, Version* version,
+                            int segment_size, RemixView** view) {
+  uint64_t size;
+  Status s = env->GetFileSize(fname, &size);
+  if (!s.ok()) {
+    return s;
+  }
+  RandomAccessFile* file;
+  s = env->NewRandomAccessFile(fname, &file);
+  if (!s.ok()) {
+    return s;
+  }
+  char* scratch = new char[size];
+  Slice contents;
+  s = file->Read(0, size, &contents, scratch);
+  if (s.ok() && contents.size() != size) {
+    s = Status::Corruption("truncated REMIX file", fname);
+  }
+  if (s.ok()) {
+    s = RemixView::Decode(table_cache, icmp, version, segment_size, contents,
+                          view);
+  }
+  delete[] scratch;
+  delete file;
+  return s;
+}
+
+}  // anonymous namespace
+
+Status DBImpl::GetRemixView(int segment_size, RemixView** view) {
+  *view = nullptr;
+  MutexLock l(&mutex_);
+  // A running compaction brings remix_ up to date when it finishes, which
+  // is much cheaper than building a new view here.
+  while ((background_flush_scheduled_ ||
+          background_compactions_scheduled_ > 0) &&
+         remix_ != nullptr &&
+         !remix_->Matches(versions_->current())) {
+    background_work_finished_signal_.Wait();
+  }
+  Version* current = versions_->current();
+  if (remix_ != nullptr && remix_->segment_size() == segment_size &&
+      remix_->Matches(current)) {
+    remix_->Ref();
+    *view = remix_;
+    return Status::OK();
+  }
+
+  current->Ref();
+  const uint64_t remix_number = versions_->RemixFileNumber();
+  RemixView* result = nullptr;
+  bool loaded = false;
+  Status s;
+  {
+    mutex_.Unlock();
+    if (remix_number != 0) {
+      s = LoadRemixView(env_, table_cache_, &internal_comparator_,
+                        RemixFileName(dbname_, remix_number), current,
+                        segment_size, &result);
+      loaded = s.ok();
+      if (!s.ok()) {
+        Log(options_.info_log, "REMIX #%llu not reused: %s\n",
+            static_cast<unsigned long long>(remix_number),
+            s.ToString().c_str());
+      }
+    }
+    if (result == nullptr) {
+      s = RemixView::Build(table_cache_, &internal_comparator_, current,
+                           segment_size, options_.remix_build_threads,
+                           &result);
+    }
+    mutex_.Lock();
+  }
+  if (!s.ok()) {
+    current->Unref();
+    return s;
+  }
+  // A loaded view that had to shrink into the budget is persisted again
+  // when the DB is closed.
+  const bool shrunk = result->SetMemoryBudget(options_.remix_memory_budget);
+
+  if (remix_ != nullptr) {
+    remix_->Unref();
+  }
+  remix_ = result;
+  remix_->Ref();
+  remix_dirty_ = shrunk;
+  result->Ref();
+  *view = result;
+  if (!loaded) {
+    // A view that cannot be persisted is still usable; the error is logged.
+    remix_dirty_ = !PersistRemixView(result).ok();
+    // Recording the file installed a new version with the same tables
+    UpdateRemixView();
+  }
+  return Status::OK();
+}
+
+void DBImpl::UpdateRemixView() {
+  mutex_.AssertHeld();
+  Version* current = versions_->current();
+  if (remix_ == nullptr || remix_->version() == current ||
+      shutting_down_.load(std::memory_order_acquire)) {
+    return;
+  }
+  if (remix_->Matches(current)) {
+    // NewIterator() only serves the view of the current version.
+    remix_->SetVersion(current);
+    return;
+  }
+
+  RemixView* base = remix_;
+  base->Ref();
+  current->Ref();
+  RemixView* updated = nullptr;
+  Status s;
+  {
+    mutex_.Unlock();
+    s = base->Update(current, &updated);
+    mutex_.Lock();
+  }
+  if (!s.ok()) {
+    // remix_ stays stale and is rebuilt by the next GetRemixView().
+    Log(options_.info_log, "REMIX update failed: %s\n", s.ToString().c_str());
+    current->Unref();
+  } else {
+    updated->Ref();
+    if (remix_ == base) {
+      remix_->Unref();
+      remix_ = updated;
+      remix_->Ref();
+      // The new view is persisted lazily, by the DB destructor.
+      remix_dirty_ = true;
+    }
+    updated->Unref();
+  }
+  base->Unref();
+}
+
+void DBImpl::ReleaseRemixView(RemixView* view) {
+  MutexLock l(&mutex_);
+  view->Unref();
+}
+
+Iterator* DBImpl::NewRemixIterator(RemixView* view,
+                                   const ReadOptions& options) {
+  mutex_.Lock();
+  return NewRemixDBIterator(view, options, false);
+}
+
+Iterator* DBImpl::NewRemixDBIterator(RemixView* view,
+                                     const ReadOptions& options,
+                                     bool with_memtables) {
+  mutex_.AssertHeld();
+  const SequenceNumber sequence =
+      (options.snapshot != nullptr
+           ? static_cast<const SnapshotImpl*>(options.snapshot)
+                 ->sequence_number()
+           : versions_->LastSequence());
+  const uint32_t seed = ++seed_;
+  view->Ref();
+  std::vector<MemTable*> mems;
+  if (with_memtables) {
+    RefMemTables(true, &mems);
+  }
+  RangeTombstoneSet* tombstones =
+      NewRangeTombstoneSet(mems, view->version(), sequence);
+  // A read that sees every entry of the view can skip shadowed entries
+  // and tombstones by the flags in the view instead of through a DBIter.
+  const bool scan = (mems.empty() && tombstones == nullptr &&
+                     sequence >= versions_->LastSequence() &&
+                     PrefixExtractor(options) == nullptr);
+  mutex_.Unlock();
+
+  if (scan) {
+    Iterator* iter = view->NewScanIterator(options);
+    iter->RegisterCleanup(CleanupRemixIteratorState,
+                          new RemixIterState(&mutex_, view, mems),
+                          nullptr);
+    return iter;
+  }
+
+  // Only the few memtable entries are merged by key comparisons; the
+  // table entries come from the view in order.
+  Iterator* internal_iter = view->NewIterator(options);
+  if (!mems.empty()) {
+    std::vector<Iterator*> list;
+    for (MemTable* mem : mems) {
+      list.push_back(mem->NewIterator());
+    }
+    list.push_back(internal_iter);
+    internal_iter =
+        NewMergingIterator(&internal_comparator_, &list[0], list.size());
+  }
+  internal_iter->RegisterCleanup(CleanupRemixIteratorState,
+                                 new RemixIterState(&mutex_, view, mems),
+                                 nullptr);
+  if (view->version()->HasBlobFiles()) {
+    internal_iter =
+        NewBlobResolvingIterator(internal_iter, table_cache_, options);
+  }
+  return NewDBIterator(this, user_comparator(), internal_iter, sequence, seed,
+                       tombstones, PrefixExtractor(options));
+}
+
+Status DBImpl::PersistRemixView(RemixView* view) {
+  mutex_.AssertHeld();
+  if (!bg_error_.ok()) {
+    return bg_error_;
+  }
+
+  const uint64_t number = versions_->NewFileNumber();
+  pending_outputs_.insert(number);
+  Status s;
+  {
+    mutex_.Unlock();
+    std::string contents;
+    view->EncodeTo(&contents);
+    s = WriteStringToFileSync(env_, contents, RemixFileName(dbname_, number));
+    mutex_.Lock();
+  }
+  if (s.ok()) {
+    VersionEdit edit;
+    edit.SetRemixFile(number);
+    LockManifest();
+    s = versions_->LogAndApply(&edit, &mutex_);
+    UnlockManifest();
+  }
+  pending_outputs_.erase(number);
+  if (s.ok()) {
+    Log(options_.info_log, "REMIX #%llu: %d segments of %d entries\n",
+        static_cast<unsigned long long>(number),
+        static_cast<int>(view->NumSegments()), view->segment_size());
+  } else {
+    Log(options_.info_log, "REMIX #%llu not persisted: %s\n",
+        static_cast<unsigned long long>(number), s.ToString().c_str());
+  }
+  RemoveObsoleteFiles();
+  return s;
 }
 
 void DBImpl::RecordReadSample(Slice key) {
@@ -1279,9 +2159,26 @@ Status DBImpl::Write(const WriteOptions& options, WriteBatch* updates) {
   MutexLock l(&mutex_);
   writers_.push_back(&w);
   // 等待其他线程signal，若被唤醒但前边还有任务，则继续阻塞
-  while (!w.done && &w != writers_.front()) {
+  while (!w.done && w.leader == nullptr && &w != writers_.front()) {
     w.cv.Wait();
   }
+  if (w.leader != nullptr) {
+    // The leader has logged the group; insert this batch alongside the
+    // other writers of the group and wait for the leader to finish.
+    MemTable* mem = mem_;
+    mutex_.Unlock();
+    Status s = WriteBatchInternal::ConcurrentInsertInto(updates, mem);
+    mutex_.Lock();
+    if (!s.ok() && insert_status_.ok()) {
+      insert_status_ = s;
+    }
+    if (--pending_inserts_ == 0) {
+      w.leader->cv.Signal();
+    }
+    while (!w.done) {
+      w.cv.Wait();
+    }
+  }
   if (w.done) {
     return w.status;
   }
@@ -1290,15 +2187,37 @@ Status DBImpl::Write(const WriteOptions& options, WriteBatch* updates) {
   // 其会将内存占用过高的MemTable转换成Immutable，并构造一个新的Memtable进行写入，
   // 刚刚形成的Immutable则交由后台线程dump到level0层。
   Status status = MakeRoomForWrite(updates == nullptr);
-  uint64_t last_sequence = versions_->LastSequence();
+  // Groups that are logged but not yet inserted have taken the sequence
+  // numbers up to that of the last one.
+  uint64_t last_sequence = memtable_writers_.empty()
+                               ? versions_->LastSequence()
+                               : memtable_writers_.back()->last_sequence;
   Writer* last_writer = &w;
   if (status.ok() && updates != nullptr) {  // nullptr batch is for compactions
     //从队列中批量取出任务
     // 合并写入操作
     WriteBatch* write_batch = BuildBatchGroup(&last_writer);
     WriteBatchInternal::SetSequence(write_batch, last_sequence + 1);
+    SequenceNumber sequence = last_sequence + 1;
     last_sequence += WriteBatchInternal::Count(write_batch);
 
+    // Only groups of several batches are worth inserting in parallel.  A
+    // pipelined group inserts the batches of its writers instead of the
+    // combined batch, which the next group reuses meanwhile.
+    const bool pipelined = options_.enable_pipelined_write;
+    const bool parallel = options_.allow_concurrent_memtable_write &&
+                          write_batch == tmp_batch_;
+    std::vector<Writer*> group;
+    for (Writer* writer : writers_) {
+      if ((pipelined || parallel) && writer->batch != nullptr) {
+        // Give every batch the sequence numbers it has in the logged group
+        WriteBatchInternal::SetSequence(writer->batch, sequence);
+        sequence += WriteBatchInternal::Count(writer->batch);
+      }
+      group.push_back(writer);
+      if (writer == last_writer) break;
+    }
+
     // Add to log and apply to memtable.  We can release the lock
     // during this phase since &w is currently responsible for logging
     // and protects against concurrent loggers and concurrent writes
@@ -1307,7 +2226,11 @@ Status DBImpl::Write(const WriteOptions& options, WriteBatch* updates) {
     {
       mutex_.Unlock();
       // 将更新记录到日志文件并且将日志文件刷新到磁盘
-      status = log_->AddRecord(WriteBatchInternal::Contents(write_batch));
+      const Slice record = WriteBatchInternal::Contents(write_batch);
+      status = log_->AddRecord(record);
+      if (options_.rate_limiter != nullptr) {
+        options_.rate_limiter->Charge(record.size());
+      }
       bool sync_error = false;
       if (status.ok() && options.sync) {
         status = logfile_->Sync();
@@ -1315,8 +2238,8 @@ Status DBImpl::Write(const WriteOptions& options, WriteBatch* updates) {
           sync_error = true;
         }
       }
-      
-      if (status.ok()) {
+
+      if (status.ok() && !parallel && !pipelined) {
         // 将更新写入到MemTable中
         status = WriteBatchInternal::InsertInto(write_batch, mem_);
       }
@@ -1330,6 +2253,13 @@ Status DBImpl::Write(const WriteOptions& options, WriteBatch* updates) {
     }
     if (write_batch == tmp_batch_) tmp_batch_->Clear();
 
+    if (pipelined) {
+      return InsertPipelined(&w, group, last_sequence, parallel, status);
+    }
+    if (status.ok() && parallel) {
+      status = InsertGroupConcurrently(group);
+    }
+
     versions_->SetLastSequence(last_sequence);
   }
   // 由于合并写入操作一次可能处理多个writers_队列中的元素，因此此处将所有已处理的元素
@@ -1356,6 +2286,86 @@ Status DBImpl::Write(const WriteOptions& options, WriteBatch* updates) {
   return status;
 }
 
+// REQUIRES: "group" is the logged write group led by group[0], whose
+// batches carry their sequence numbers
+Status DBImpl::InsertGroupConcurrently(const std::vector<Writer*>& group) {
+  mutex_.AssertHeld();
+  Writer* const leader = group[0];
+  MemTable* const mem = mem_;
+  insert_status_ = Status::OK();
+  for (size_t i = 1; i < group.size(); i++) {
+    if (group[i]->batch != nullptr) {
+      group[i]->leader = leader;
+      pending_inserts_++;
+      group[i]->cv.Signal();
+    }
+  }
+
+  mutex_.Unlock();
+  Status s = WriteBatchInternal::ConcurrentInsertInto(leader->batch, mem);
+  mutex_.Lock();
+  while (pending_inserts_ > 0) {
+    leader->cv.Wait();
+  }
+  if (s.ok()) {
+    s = insert_status_;
+  }
+  return s;
+}
+
+// REQUIRES: "group" is the write group led by "w", which was just logged
+// with "status", and "last_sequence" is the last sequence number it took.
+// Lets the next group write the log while this group is inserted into
+// mem_.  Groups are inserted one at a time, in log order, so their
+// sequence numbers are published in order.
+Status DBImpl::InsertPipelined(Writer* w, const std::vector<Writer*>& group,
+                               SequenceNumber last_sequence, bool parallel,
+                               Status status) {
+  mutex_.AssertHeld();
+  for (size_t i = 0; i < group.size(); i++) {
+    assert(writers_.front() == group[i]);
+    writers_.pop_front();
+  }
+  w->last_sequence = last_sequence;
+  memtable_writers_.push_back(w);
+  if (!writers_.empty()) {
+    writers_.front()->cv.Signal();
+  }
+  while (memtable_writers_.front() != w) {
+    w->cv.Wait();
+  }
+
+  if (status.ok()) {
+    if (parallel) {
+      status = InsertGroupConcurrently(group);
+    } else {
+      MemTable* const mem = mem_;
+      mutex_.Unlock();
+      for (size_t i = 0; i < group.size() && status.ok(); i++) {
+        if (group[i]->batch != nullptr) {
+          status = WriteBatchInternal::InsertInto(group[i]->batch, mem);
+        }
+      }
+      mutex_.Lock();
+    }
+  }
+  versions_->SetLastSequence(last_sequence);
+
+  memtable_writers_.pop_front();
+  for (size_t i = 1; i < group.size(); i++) {
+    group[i]->status = status;
+    group[i]->done = true;
+    group[i]->cv.Signal();
+  }
+  if (!memtable_writers_.empty()) {
+    memtable_writers_.front()->cv.Signal();
+  } else if (!writers_.empty()) {
+    // The front writer may be waiting to switch memtables
+    writers_.front()->cv.Signal();
+  }
+  return status;
+}
+
 // REQUIRES: Writer list must be non-empty
 // REQUIRES: First writer must have a non-null batch
 /**
@@ -1387,6 +2397,11 @@ WriteBatch* DBImpl::BuildBatchGroup(Writer** last_writer) {
   ++iter;  // Advance past "first"
   for (; iter != writers_.end(); ++iter) {
     Writer* w = *iter;
+    if (w->exclusive) {
+      // Only the writer itself can do its work, like an ingestion
+      break;
+    }
+
     if (w->sync && !first->sync) {
       // Do not include a sync write into a batch handled by a non-sync write.
       break;
@@ -1447,7 +2462,8 @@ Status DBImpl::MakeRoomForWrite(bool force) {
       // mem_有空间还没有达到阈值，while只有这个条件为True时才会跳出
       // There is room in current memtable
       break;
-    } else if (imm_ != nullptr) {  // 此时mem_空间不够，且imm_不为空，那么需要将imm_中的数据写入磁盘，试图将mem_赋值给imm_，然后重新分配一个mem_供用户写
+    } else if (imm_.size() >=
+               static_cast<size_t>(options_.max_immutable_memtables)) {  // 此时mem_空间不够，且imm_不为空，那么需要将imm_中的数据写入磁盘，试图将mem_赋值给imm_，然后重新分配一个mem_供用户写
       // We have filled up the current memtable, but the previous
       // one is still being compacted, so we wait.
       // 但在此之前必须先检查imm_是否为空，如果它不为空的话，说明上次赋值给imm_的mem还没有被背景线程写入磁盘，那只能等待了，不然就会覆盖掉之前的mem_。
@@ -1459,6 +2475,9 @@ Status DBImpl::MakeRoomForWrite(bool force) {
       // There are too many level-0 files.
       Log(options_.info_log, "Too many L0 files; waiting...\n");
       background_work_finished_signal_.Wait();
+    } else if (!memtable_writers_.empty()) {
+      // Logged groups are still being inserted into the current memtable
+      writers_.front()->cv.Wait();
     } else { //imm_为空，mem_没有空间可写
       // 构造一个新的Memtable进行写入，刚刚形成的Immutable则交由后台线程dump到level0层
       // Attempt to switch to a new memtable and trigger compaction of old
@@ -1489,11 +2508,10 @@ Status DBImpl::MakeRoomForWrite(bool force) {
       }
       delete logfile_;
 
+      imm_.push_back(ImmutableMemTable{mem_, logfile_number_});  // 后台将启动对imm_ 进行写磁盘的过程
       logfile_ = lfile;
       logfile_number_ = new_log_number;
       log_ = new log::Writer(lfile);
-      imm_ = mem_;  // 后台将启动对imm_ 进行写磁盘的过程
-      has_imm_.store(true, std::memory_order_release);
       // 申请新的memtable
       mem_ = new MemTable(internal_comparator_);
       mem_->Ref();
@@ -1505,6 +2523,267 @@ Status DBImpl::MakeRoomForWrite(bool force) {
   return s;
 }
 
+bool DBImpl::MemTablesOverlap(const Slice& smallest_user_key,
+                              const Slice& largest_user_key) {
+  mutex_.AssertHeld();
+  std::vector<MemTable*> mems(1, mem_);
+  for (const ImmutableMemTable& imm : imm_) {
+    mems.push_back(imm.mem);
+  }
+  InternalKey start(smallest_user_key, kMaxSequenceNumber, kValueTypeForSeek);
+  for (MemTable* mem : mems) {
+    Iterator* iter = mem->NewIterator();
+    iter->Seek(start.Encode());
+    const bool overlap =
+        iter->Valid() && user_comparator()->Compare(ExtractUserKey(iter->key()),
+                                                    largest_user_key) <= 0;
+    delete iter;
+    if (overlap) {
+      return true;
+    }
+  }
+  return false;
+}
+
+namespace {
+
+// Yields the entries of an external table with the sequence number that
+// DBImpl::IngestExternalFile() assigned to them.  Since the table holds
+// one entry per user key, the entries keep their order.
+class GlobalSequenceIterator : public Iterator {
+ public:
+  GlobalSequenceIterator(Iterator* iter, SequenceNumber sequence)
+      : iter_(iter), sequence_(sequence) {}
+
+  ~GlobalSequenceIterator() override { delete iter_; }
+
+  bool Valid() const override { return status_.ok() && iter_->Valid(); }
+  void SeekToFirst() override {
+    iter_->SeekToFirst();
+    Update();
+  }
+  void SeekToLast() override {
+    iter_->SeekToLast();
+    Update();
+  }
+  void Seek(const Slice& target) override {
+    iter_->Seek(target);
+    Update();
+  }
+  void Next() override {
+    iter_->Next();
+    Update();
+  }
+  void Prev() override {
+    iter_->Prev();
+    Update();
+  }
+  Slice key() const override { return key_; }
+  Slice value() const override { return iter_->value(); }
+  Status status() const override {
+    return status_.ok() ? iter_->status() : status_;
+  }
+
+ private:
+  void Update() {
+    ParsedInternalKey ikey;
+    if (!iter_->Valid()) {
+      return;
+    }
+    if (!ParseInternalKey(iter_->key(), &ikey) ||
+        (ikey.type != kTypeValue && ikey.type != kTypeDeletion)) {
+      status_ = Status::Corruption("bad entry in external file");
+      return;
+    }
+    key_.clear();
+    AppendInternalKey(&key_,
+                      ParsedInternalKey(ikey.user_key, sequence_, ikey.type));
+  }
+
+  Iterator* const iter_;
+  const SequenceNumber sequence_;
+  std::string key_;
+  Status status_;
+};
+
+// Copy the file "src" to "dst" and sync the copy.
+Status CopyFile(Env* env, const std::string& src, const std::string& dst) {
+  SequentialFile* in;
+  Status s = env->NewSequentialFile(src, &in);
+  if (!s.ok()) {
+    return s;
+  }
+  WritableFile* out;
+  s = env->NewWritableFile(dst, &out);
+  if (!s.ok()) {
+    delete in;
+    return s;
+  }
+  const size_t kBufferSize = 1 << 20;
+  char* buffer = new char[kBufferSize];
+  while (s.ok()) {
+    Slice fragment;
+    s = in->Read(kBufferSize, &fragment, buffer);
+    if (!s.ok() || fragment.empty()) {
+      break;
+    }
+    s = out->Append(fragment);
+  }
+  delete[] buffer;
+  if (s.ok()) {
+    s = out->Sync();
+  }
+  if (s.ok()) {
+    s = out->Close();
+  }
+  delete out;
+  delete in;
+  if (!s.ok()) {
+    env->RemoveFile(dst);
+  }
+  return s;
+}
+
+}  // namespace
+
+Status DBImpl::IngestExternalFile(const IngestExternalFileOptions& options,
+                                  const std::string& fname) {
+  // Read the key range of the file.  Its entries have sequence number
+  // zero (see SstFileWriter).
+  uint64_t file_size = 0;
+  RandomAccessFile* file = nullptr;
+  Table* table = nullptr;
+  Status s = env_->GetFileSize(fname, &file_size);
+  if (s.ok()) {
+    s = env_->NewRandomAccessFile(fname, &file);
+  }
+  if (s.ok()) {
+    s = Table::Open(options_, file, file_size, &table);
+  }
+  ReadOptions read_options;
+  read_options.verify_checksums = options_.paranoid_checks;
+  read_options.fill_cache = false;
+  FileMetaData meta;
+  std::string smallest_user_key, largest_user_key;
+  if (s.ok()) {
+    Iterator* iter = table->NewIterator(read_options);
+    ParsedInternalKey first, last;
+    iter->SeekToFirst();
+    if (iter->Valid() && ParseInternalKey(iter->key(), &first)) {
+      meta.smallest.DecodeFrom(iter->key());
+      smallest_user_key = first.user_key.ToString();
+      iter->SeekToLast();
+    }
+    if (!iter->status().ok()) {
+      s = iter->status();
+    } else if (!iter->Valid()) {
+      s = Status::InvalidArgument("no entries in external file", fname);
+    } else if (!ParseInternalKey(iter->key(), &last) || first.sequence != 0 ||
+               last.sequence != 0) {
+      s = Status::InvalidArgument("not written by an SstFileWriter", fname);
+    } else {
+      meta.largest.DecodeFrom(iter->key());
+      largest_user_key = last.user_key.ToString();
+    }
+    delete iter;
+  }
+
+  MutexLock l(&mutex_);
+  Writer w(&mutex_);
+  w.exclusive = true;
+  const bool queued = s.ok();
+  if (queued) {
+    // Hold off other writes, so that no write newer than the file can
+    // touch its range before it is installed.
+    writers_.push_back(&w);
+    while (!w.done &&
+           (&w != writers_.front() || !memtable_writers_.empty())) {
+      w.cv.Wait();
+    }
+    // Write groups stop at exclusive writers, so none completed w
+    assert(!w.done);
+    s = bg_error_;
+  }
+  // Entries in the memtables would hide the newer ones of the file
+  if (s.ok() && MemTablesOverlap(smallest_user_key, largest_user_key)) {
+    s = MakeRoomForWrite(true /* force compaction */);
+    while (s.ok() && !imm_.empty()) {
+      background_work_finished_signal_.Wait();
+      s = bg_error_;
+    }
+  }
+
+  bool as_is = false;
+  SequenceNumber sequence = 0;
+  if (s.ok()) {
+    // Sequence number zero is only newer than the entries of the file's
+    // range if there are none, and if no snapshot must miss the file.
+    bool mem_tombstones = mem_->HasRangeTombstones();
+    for (const ImmutableMemTable& imm : imm_) {
+      mem_tombstones = mem_tombstones || imm.mem->HasRangeTombstones();
+    }
+    as_is = snapshots_.empty() && !mem_tombstones &&
+            !versions_->current()->OverlapInAnyLevel(smallest_user_key,
+                                                     largest_user_key);
+    sequence = as_is ? 0 : versions_->LastSequence() + 1;
+    meta.number = versions_->NewFileNumber();
+    pending_outputs_.insert(meta.number);
+    mutex_.Unlock();
+    if (as_is) {
+      delete table;
+      delete file;
+      table = nullptr;
+      file = nullptr;
+      const std::string dbfile = TableFileName(dbname_, meta.number);
+      s = options.move_files ? env_->RenameFile(fname, dbfile)
+                             : CopyFile(env_, fname, dbfile);
+      meta.file_size = file_size;
+    } else {
+      Iterator* input =
+          new GlobalSequenceIterator(table->NewIterator(read_options), sequence);
+      s = BuildTable(dbname_, env_, options_, table_cache_, input, &meta);
+      delete input;
+    }
+    meta.smallest_sequence = sequence;
+    meta.largest_sequence = sequence;
+    mutex_.Lock();
+
+    if (s.ok()) {
+      LockManifest();
+      VersionEdit edit;
+      const int level = versions_->current()->PickLevelForExternalFile(
+          smallest_user_key, largest_user_key, compacting_levels_);
+      edit.AddFile(level, meta);
+      if (!as_is) {
+        versions_->SetLastSequence(sequence);
+      }
+      s = versions_->LogAndApply(&edit, &mutex_);
+      UnlockManifest();
+      Log(options_.info_log, "Ingested %s as #%llu at level-%d: %s\n",
+          fname.c_str(), static_cast<unsigned long long>(meta.number), level,
+          s.ToString().c_str());
+      if (s.ok()) {
+        UpdateRemixView();
+        MaybeScheduleCompaction();
+      } else {
+        RecordBackgroundError(s);
+      }
+    }
+    pending_outputs_.erase(meta.number);
+  }
+
+  if (queued) {
+    assert(writers_.front() == &w);
+    writers_.pop_front();
+    if (!writers_.empty()) {
+      writers_.front()->cv.Signal();
+    }
+  }
+  delete table;
+  delete file;
+  return s;
+}
+
 bool DBImpl::GetProperty(const Slice& property, std::string* value) {
   value->clear();
 
@@ -1549,19 +2828,43 @@ bool DBImpl::GetProperty(const Slice& property, std::string* value) {
   } else if (in == "sstables") {
     *value = versions_->current()->DebugString();
     return true;
+  } else if (in == "rate-limiter-bytes-per-second" ||
+             in == "rate-limiter-throttled-bytes") {
+    if (options_.rate_limiter == nullptr) {
+      return false;
+    }
+    value->append(NumberToString(
+        in == "rate-limiter-bytes-per-second"
+            ? options_.rate_limiter->GetBytesPerSecond()
+            : options_.rate_limiter->GetTotalBytesThrottled()));
+    return true;
+  } else if (in == "num-immutable-memtables") {
+    value->append(NumberToString(imm_.size()));
+    return true;
   } else if (in == "approximate-memory-usage") {
     size_t total_usage = options_.block_cache->TotalCharge();
     if (mem_) {
       total_usage += mem_->ApproximateMemoryUsage();
     }
-    if (imm_) {
-      total_usage += imm_->ApproximateMemoryUsage();
+    for (const ImmutableMemTable& imm : imm_) {
+      total_usage += imm.mem->ApproximateMemoryUsage();
+    }
+    if (remix_) {
+      total_usage += remix_->ApproximateMemoryUsage();
     }
     char buf[50];
     std::snprintf(buf, sizeof(buf), "%llu",
                   static_cast<unsigned long long>(total_usage));
     value->append(buf);
     return true;
+  } else if (in == "remix-memory-usage") {
+    const size_t usage =
+        (remix_ != nullptr) ? remix_->ApproximateMemoryUsage() : 0;
+    char buf[50];
+    std::snprintf(buf, sizeof(buf), "%llu",
+                  static_cast<unsigned long long>(usage));
+    value->append(buf);
+    return true;
   }
 
   return false;
@@ -1609,6 +2912,29 @@ Status DB::Delete(const WriteOptions& opt, const Slice& key) {
   return Write(opt, &batch);
 }
 
+Status DB::IngestExternalFile(const IngestExternalFileOptions& /*options*/,
+                              const std::string& fname) {
+  return Status::NotSupported("IngestExternalFile", fname);
+}
+
+Status DB::DeleteRange(const WriteOptions& opt, const Slice& begin,
+                       const Slice& end) {
+  WriteBatch batch;
+  batch.DeleteRange(begin, end);
+  return Write(opt, &batch);
+}
+
+std::vector<Status> DB::MultiGet(const ReadOptions& options,
+                                 const std::vector<Slice>& keys,
+                                 std::vector<std::string>* values) {
+  std::vector<Status> statuses(keys.size());
+  values->resize(keys.size());
+  for (size_t i = 0; i < keys.size(); i++) {
+    statuses[i] = Get(options, keys[i], &(*values)[i]);
+  }
+  return statuses;
+}
+
 DB::~DB() = default;
 /**
  * @description: 打开数据库
@@ -1658,6 +2984,18 @@ Status DB::Open(const Options& options, const std::string& dbname, DB** dbptr) {
   if (s.ok()) {
     // 如果成功
     assert(impl->mem_ != nullptr);
+    if (impl->options_.use_remix) {
+      // Without a view, iterators use the merging path; the error is logged.
+      RemixView* view;
+      Status remix_status =
+          impl->GetRemixView(impl->options_.remix_segment_size, &view);
+      if (remix_status.ok()) {
+        impl->ReleaseRemixView(view);
+      } else {
+        Log(impl->options_.info_log, "REMIX view not available: %s\n",
+            remix_status.ToString().c_str());
+      }
+    }
     *dbptr = impl;
   } else {
     delete impl;  // 出错释放当前数据库
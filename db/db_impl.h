@@ -9,6 +9,7 @@
 #include <deque>
 #include <set>
 #include <string>
+#include <vector>
 
 #include "db/dbformat.h"
 #include "db/log_writer.h"
@@ -20,7 +21,10 @@
 
 namespace leveldb {
 
+struct FileMetaData;
 class MemTable;
+class RangeTombstoneSet;
+class RemixView;
 class TableCache;
 class Version;
 class VersionEdit;
@@ -40,8 +44,13 @@ class DBImpl : public DB {
              const Slice& value) override;
   Status Delete(const WriteOptions&, const Slice& key) override;
   Status Write(const WriteOptions& options, WriteBatch* updates) override;
+  Status IngestExternalFile(const IngestExternalFileOptions& options,
+                            const std::string& fname) override;
   Status Get(const ReadOptions& options, const Slice& key,
              std::string* value) override;
+  std::vector<Status> MultiGet(const ReadOptions& options,
+                               const std::vector<Slice>& keys,
+                               std::vector<std::string>* values) override;
   Iterator* NewIterator(const ReadOptions&) override;
   const Snapshot* GetSnapshot() override;
   void ReleaseSnapshot(const Snapshot* snapshot) override;
@@ -74,15 +83,31 @@ class DBImpl : public DB {
   // 字节。
   void RecordReadSample(Slice key);
 
+  // Store in "*view" a referenced REMIX view of the current tables with
+  // "segment_size" entries per segment.  The view persisted in the MANIFEST
+  // is reused if it still matches the tables; otherwise a new view is built
+  // and persisted.  The caller must pass the view to ReleaseRemixView().
+  Status GetRemixView(int segment_size, RemixView** view);
+
+  // Drop a reference obtained from GetRemixView().
+  void ReleaseRemixView(RemixView* view);
+
+  // Return an iterator over the user entries of "view".  Entries that are
+  // still in the memtables are not visible.  The iterator holds its own
+  // reference to the view.
+  Iterator* NewRemixIterator(RemixView* view, const ReadOptions& options);
+
  private:
   friend class DB;
   struct CompactionState;
+  struct Subcompaction;
   struct Writer;
 
   // Information for a manual compaction
   struct ManualCompaction {
     int level;
     bool done;
+    bool in_progress;          // Picked by a background compaction thread
     const InternalKey* begin;  // null means beginning of key range
     const InternalKey* end;    // null means end of key range
     InternalKey tmp_storage;   // Used to keep track of compaction progress
@@ -104,9 +129,19 @@ class DBImpl : public DB {
     int64_t bytes_written;
   };
 
+  // If "tombstones" is non-null, the range tombstones visible to the read
+  // are stored in *tombstones (see NewRangeTombstoneSet()).
   Iterator* NewInternalIterator(const ReadOptions&,
                                 SequenceNumber* latest_snapshot,
-                                uint32_t* seed);
+                                uint32_t* seed,
+                                RangeTombstoneSet** tombstones);
+
+  // Return the range tombstones of "mems" and "version" that are visible
+  // at "snapshot", or nullptr if there are none.  The caller must hold
+  // references to "mems" and "version".
+  RangeTombstoneSet* NewRangeTombstoneSet(const std::vector<MemTable*>& mems,
+                                          Version* version,
+                                          SequenceNumber snapshot) const;
 
   Status NewDB();
 
@@ -133,15 +168,56 @@ class DBImpl : public DB {
   Status WriteLevel0Table(MemTable* mem, VersionEdit* edit, Version* base)
       EXCLUSIVE_LOCKS_REQUIRED(mutex_);
 
+  // Write the entries of "mems" to a new table described by *meta.  The
+  // table stays in pending_outputs_ until the caller erases it.
+  Status BuildLevel0Table(const std::vector<MemTable*>& mems,
+                          FileMetaData* meta) EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  // Add the table built by BuildLevel0Table() to *edit, at the level picked
+  // by "base" or at level 0 if "base" is null.
+  void AddLevel0Table(const FileMetaData& meta, Version* base,
+                      uint64_t start_micros, VersionEdit* edit)
+      EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  // Append mem_ (unless "skip_empty_mem" and it is empty) and the immutable
+  // memtables to *mems, newest first, and take a reference to each.
+  void RefMemTables(bool skip_empty_mem, std::vector<MemTable*>* mems)
+      EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
   Status MakeRoomForWrite(bool force /* compact even if there is room? */)
       EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  // Returns true iff mem_ or an immutable memtable holds an entry in
+  // [smallest_user_key,largest_user_key].
+  bool MemTablesOverlap(const Slice& smallest_user_key,
+                        const Slice& largest_user_key)
+      EXCLUSIVE_LOCKS_REQUIRED(mutex_);
   WriteBatch* BuildBatchGroup(Writer** last_writer)
       EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  Status InsertGroupConcurrently(const std::vector<Writer*>& group)
+      EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  Status InsertPipelined(Writer* w, const std::vector<Writer*>& group,
+                         SequenceNumber last_sequence, bool parallel,
+                         Status status) EXCLUSIVE_LOCKS_REQUIRED(mutex_);
 
   void RecordBackgroundError(const Status& s);
 
+  // Wait until no other thread writes to the MANIFEST and claim it.
+  // Compactions are only picked while the MANIFEST is not claimed, so that
+  // they always see the latest version.
+  void LockManifest() EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  void UnlockManifest() EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  // Return the sequence number of the oldest snapshot, or the last sequence
+  // number if there is none.
+  SequenceNumber SmallestSnapshot() EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  // Returns true iff a new compaction thread would find work to do.
+  bool HasCompactionWork() EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
   void MaybeScheduleCompaction() EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  static void BGFlushWork(void* db);
   static void BGWork(void* db);
+  void BackgroundFlushCall();
   void BackgroundCall();
   void BackgroundCompaction() EXCLUSIVE_LOCKS_REQUIRED(mutex_);
   void CleanupCompaction(CompactionState* compact)
@@ -149,15 +225,51 @@ class DBImpl : public DB {
   Status DoCompactionWork(CompactionState* compact)
       EXCLUSIVE_LOCKS_REQUIRED(mutex_);
 
+  // Merge the entries of "input" in the key range of "compact" into new
+  // output files of "compact", and delete "input".
+  Status CompactKeyRange(CompactionState* compact, Iterator* input)
+      LOCKS_EXCLUDED(mutex_);
+  static void BGSubcompactionWork(void* arg);
+
+  // Move the value of the entry "ikey" that a compaction keeps into a blob
+  // file if it is large, or out of a blob file that is being collected,
+  // updating ikey->type and *value, which may then point into *blob_value
+  // or *blob_index.
+  Status CompactValue(CompactionState* compact, ParsedInternalKey* ikey,
+                      Slice* value, std::string* blob_value,
+                      std::string* blob_index) LOCKS_EXCLUDED(mutex_);
+
+  // Return the number below which the blob files of the current version
+  // are the oldest options_.blob_gc_age_cutoff of them, or zero if none is.
+  uint64_t BlobGarbageCollectionLimit() EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
   Status OpenCompactionOutputFile(CompactionState* compact);
   Status FinishCompactionOutputFile(CompactionState* compact, Iterator* input);
   Status InstallCompactionResults(CompactionState* compact)
       EXCLUSIVE_LOCKS_REQUIRED(mutex_);
 
+  // Return a DB iterator over "view" and release mutex_.  If
+  // "with_memtables" is true, the entries of the memtables are merged in,
+  // which requires that "view" covers the current version.
+  Iterator* NewRemixDBIterator(RemixView* view, const ReadOptions& options,
+                               bool with_memtables) UNLOCK_FUNCTION(mutex_);
+
+  // Write "view" to a new REMIX file and record it in the MANIFEST.
+  Status PersistRemixView(RemixView* view) EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  // Bring remix_ up to date with the current version after a flush or a
+  // compaction, rebuilding only the segments that cover changed tables.
+  void UpdateRemixView() EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
   const Comparator* user_comparator() const {
     return internal_comparator_.user_comparator();
   }
 
+  // The extractor that bounds the iterators of "options", if any.
+  const SliceTransform* PrefixExtractor(const ReadOptions& options) const {
+    return options.prefix_same_as_start ? options_.prefix_extractor : nullptr;
+  }
+
   // Constant after construction
   Env* const env_;
   const InternalKeyComparator internal_comparator_;
@@ -178,8 +290,13 @@ class DBImpl : public DB {
   std::atomic<bool> shutting_down_;  // db是否已经关闭
   port::CondVar background_work_finished_signal_ GUARDED_BY(mutex_);
   MemTable* mem_;
-  MemTable* imm_ GUARDED_BY(mutex_);  // Memtable being compacted
-  std::atomic<bool> has_imm_;         // So bg thread can detect non-null imm_
+
+  // A full memtable waiting to be compacted, and the log file holding it
+  struct ImmutableMemTable {
+    MemTable* mem;
+    uint64_t log_number;
+  };
+  std::deque<ImmutableMemTable> imm_ GUARDED_BY(mutex_);  // Oldest first
   WritableFile* logfile_;
   uint64_t logfile_number_ GUARDED_BY(mutex_);
   log::Writer* log_;
@@ -189,14 +306,34 @@ class DBImpl : public DB {
   std::deque<Writer*> writers_ GUARDED_BY(mutex_);
   WriteBatch* tmp_batch_ GUARDED_BY(mutex_);
 
+  // Leaders of the logged write groups that wait for their turn to insert
+  // into mem_, oldest first (Options::enable_pipelined_write)
+  std::deque<Writer*> memtable_writers_ GUARDED_BY(mutex_);
+
+  // Followers of the write group that are still inserting their batches,
+  // and the first error they hit
+  int pending_inserts_ GUARDED_BY(mutex_);
+  Status insert_status_ GUARDED_BY(mutex_);
+
   SnapshotList snapshots_ GUARDED_BY(mutex_);
 
   // Set of table files to protect from deletion because they are
   // part of ongoing compactions.
   std::set<uint64_t> pending_outputs_ GUARDED_BY(mutex_);
 
-  // Has a background compaction been scheduled or is running?
-  bool background_compaction_scheduled_ GUARDED_BY(mutex_);
+  // Has a memtable flush been scheduled or is running?
+  bool background_flush_scheduled_ GUARDED_BY(mutex_);
+
+  // Number of compaction threads that have been started, and how many of
+  // them have picked a compaction and are running it
+  int background_compactions_scheduled_ GUARDED_BY(mutex_);
+  int background_compactions_running_ GUARDED_BY(mutex_);
+
+  // Levels read or written by the running compactions
+  bool compacting_levels_[config::kNumLevels] GUARDED_BY(mutex_);
+
+  // Is a thread writing to the MANIFEST?
+  bool manifest_locked_ GUARDED_BY(mutex_);
 
   ManualCompaction* manual_compaction_ GUARDED_BY(mutex_);
 
@@ -206,6 +343,11 @@ class DBImpl : public DB {
   Status bg_error_ GUARDED_BY(mutex_);
 
   CompactionStats stats_[config::kNumLevels] GUARDED_BY(mutex_);
+
+  // Most recently opened REMIX view, or nullptr
+  RemixView* remix_ GUARDED_BY(mutex_);
+  // Is remix_ newer than the REMIX file recorded in the MANIFEST?
+  bool remix_dirty_ GUARDED_BY(mutex_);
 };
 
 // Sanitize db options.  The caller should delete result.info_log if
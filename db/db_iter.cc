@@ -7,14 +7,14 @@
 #include "db/db_impl.h"
 #include "db/dbformat.h"
 #include "db/filename.h"
+#include "db/range_tombstone.h"
 #include "leveldb/env.h"
 #include "leveldb/iterator.h"
+#include "leveldb/slice_transform.h"
 #include "port/port.h"
 #include "util/logging.h"
 #include "util/mutexlock.h"
 #include "util/random.h"
-#include "leveldb/Remix.h"
-#include "leveldb/RemixHelper.h"
 
 namespace leveldb {
 
@@ -53,33 +53,32 @@ class DBIter : public Iterator {
   enum Direction { kForward, kReverse };
 
   DBIter(DBImpl* db, const Comparator* cmp, Iterator* iter, SequenceNumber s,
-         uint32_t seed)
+         uint32_t seed, RangeTombstoneSet* tombstones,
+         const SliceTransform* prefix_extractor)
       : db_(db),
         user_comparator_(cmp),
         iter_(iter),
         sequence_(s),
+        tombstones_(tombstones),
+        prefix_extractor_(prefix_extractor),
         direction_(kForward),
         valid_(false),
+        has_prefix_(false),
         rnd_(seed),
-        bytes_until_read_sampling_(RandomCompactionPeriod())
-         {
-          set_runs_num(iter->get_runs_num());
-          set_comparator(cmp);
-        } // !!!
+        bytes_until_read_sampling_(RandomCompactionPeriod()) {}
 
   DBIter(const DBIter&) = delete;
   DBIter& operator=(const DBIter&) = delete;
 
-  ~DBIter() override { delete iter_; }
+  ~DBIter() override {
+    delete iter_;
+    delete tombstones_;
+  }
   bool Valid() const override { return valid_; }
   Slice key() const override {
     assert(valid_);
     return (direction_ == kForward) ? ExtractUserKey(iter_->key()) : saved_key_;
   }
-  Slice KEY() override{
-    assert(valid_);
-    return iter_->key();
-  }
   Slice value() const override {
     assert(valid_);
     return (direction_ == kForward) ? iter_->value() : saved_value_;
@@ -92,19 +91,40 @@ class DBIter : public Iterator {
     }
   }
 
-  int Next() override;
-  void Next(Remix *my_sorted_view,size_t &index_anchor_key, size_t &segment_index) override;
+  void Next() override;
   void Prev() override;
   void Seek(const Slice& target) override;
-  int SeekToFirst() override;
+  void SeekToFirst() override;
   void SeekToLast() override;
-  const Comparator* GetComperator();
 
  private:
   void FindNextUserEntry(bool skipping, std::string* skip);
   void FindPrevUserEntry();
   bool ParseKey(ParsedInternalKey* key);
 
+  // Return the type of "ikey", counting values deleted by a range
+  // tombstone as deletions.
+  ValueType EntryType(const ParsedInternalKey& ikey) const {
+    if (ikey.type == kTypeValue && tombstones_ != nullptr &&
+        tombstones_->ShouldDelete(ikey)) {
+      return kTypeDeletion;
+    }
+    return ikey.type;
+  }
+
+  // Returns true if "user_key" is past the prefix of the last Seek().
+  bool OutOfPrefix(const Slice& user_key) const {
+    return has_prefix_ && (!prefix_extractor_->InDomain(user_key) ||
+                           prefix_extractor_->Transform(user_key) != prefix_);
+  }
+
+  // Prev() and SeekToLast() would need every table to be positioned on
+  // the keys before the prefix, which the filters cannot tell.
+  void SetReverseNotSupported() {
+    valid_ = false;
+    status_ = Status::NotSupported("reverse iteration with prefix_same_as_start");
+  }
+
 
   // 用于临时缓存user key到dst中
   inline void SaveKey(const Slice& k, std::string* dst) {
@@ -131,11 +151,15 @@ class DBIter : public Iterator {
   const Comparator* const user_comparator_; // 比较器
   Iterator* const iter_; //是一个MergingIterator
   SequenceNumber const sequence_; //DBIter只能访问到比sequence_小的kv对，这就方便了老版本（快照）数据库的遍历
+  RangeTombstoneSet* const tombstones_;  // May be nullptr
+  const SliceTransform* const prefix_extractor_;  // May be nullptr
   Status status_;
   std::string saved_key_;    // == current key when direction_==kReverse
   std::string saved_value_;  // == current raw value when direction_==kReverse
   Direction direction_;
   bool valid_;
+  bool has_prefix_;      // Are keys limited to prefix_?
+  std::string prefix_;  // Prefix of the target of the last Seek()
   Random rnd_; // ???
   size_t bytes_until_read_sampling_; // ???
 
@@ -161,7 +185,7 @@ inline bool DBIter::ParseKey(ParsedInternalKey* ikey) {
   }
 }
 
-int DBIter::Next() {
+void DBIter::Next() {
   assert(valid_);
 
   if (direction_ == kReverse) {  // Switch directions?
@@ -179,7 +203,7 @@ int DBIter::Next() {
     if (!iter_->Valid()) {
       valid_ = false;
       saved_key_.clear();
-      return 0;
+      return;
     }
     // saved_key_ already contains the key to skip past.
   } else {
@@ -188,32 +212,15 @@ int DBIter::Next() {
 
     // iter_ is pointing to current key. We can now safely move to the next to
     // avoid checking current key.
-    int index = iter_->Next();
-    if (iter_->Valid()) set_index_of_runs(index);
-    //iter_->set_index_of_runs(iter_->Next());
+    iter_->Next();
     if (!iter_->Valid()) {
       valid_ = false;
       saved_key_.clear();
-      return 0;
+      return;
     }
   }
   // 跳过 iter_key().user_key_ 更旧的版本和 deleteType 版本
   FindNextUserEntry(true, &saved_key_);
-  return get_index_of_runs();
-}
-
-// ##############
-void DBIter::Next(Remix *my_sorted_view,size_t &index_anchor_key, size_t &segment_index)  {
-  assert(valid_);
-    SaveKey(ExtractUserKey(iter_->key()), &saved_key_);
-    iter_->Next(my_sorted_view,index_anchor_key,segment_index);
-    if (!iter_->Valid()) {
-      valid_ = false;
-      saved_key_.clear();
-      return ;
-    }
-  // 跳过 iter_key().user_key_ 更旧的版本和 deleteType 版本
-  FindNextUserEntry(true, &saved_key_);
 }
 
 /**
@@ -240,8 +247,12 @@ void DBIter::FindNextUserEntry(bool skipping, std::string* skip) {
   assert(direction_ == kForward);
   do {
     ParsedInternalKey ikey;
-    if (ParseKey(&ikey) && ikey.sequence <= sequence_) { // 从iter_中解析出一个内部键放入ikey，且必须保证ikey的序列号小于或等于当前序列号
-      switch (ikey.type) {
+    const bool parsed = ParseKey(&ikey);
+    if (parsed && OutOfPrefix(ikey.user_key)) {
+      break;
+    }
+    if (parsed && ikey.sequence <= sequence_) { // 从iter_中解析出一个内部键放入ikey，且必须保证ikey的序列号小于或等于当前序列号
+      switch (EntryType(ikey)) {
         case kTypeDeletion:
           // Arrange to skip all upcoming entries for this key since
           // they are hidden by this deletion.
@@ -260,6 +271,12 @@ void DBIter::FindNextUserEntry(bool skipping, std::string* skip) {
             return;
           }
           break;
+        case kTypeRangeDeletion:
+          assert(false);  // Never yielded by internal iterators
+          break;
+        case kTypeBlobIndex:
+          assert(false);  // Resolved by NewBlobResolvingIterator()
+          break;
       }
     }
     iter_->Next();
@@ -278,6 +295,10 @@ void DBIter::FindNextUserEntry(bool skipping, std::string* skip) {
 */
 void DBIter::Prev() {
   assert(valid_);
+  if (prefix_extractor_ != nullptr) {
+    SetReverseNotSupported();
+    return;
+  }
 
   if (direction_ == kForward) {  // Switch directions?
     // iter_ is pointing at the current entry.  Scan backwards until
@@ -348,7 +369,7 @@ void DBIter::FindPrevUserEntry() {
         }
         // 根据类型，如果是Deletion则清空saved key和saved value  
         // 否则，把iter_的user key和value赋给saved key和saved value
-        value_type = ikey.type;
+        value_type = EntryType(ikey);
         if (value_type == kTypeDeletion) {
           saved_key_.clear();
           ClearSavedValue();
@@ -385,6 +406,12 @@ void DBIter::FindPrevUserEntry() {
  */
 void DBIter::Seek(const Slice& target) {
   direction_ = kForward;
+  has_prefix_ =
+      (prefix_extractor_ != nullptr && prefix_extractor_->InDomain(target));
+  if (has_prefix_) {
+    const Slice prefix = prefix_extractor_->Transform(target);
+    prefix_.assign(prefix.data(), prefix.size());
+  }
   // 清空saved value和saved key，并根据target设置saved key
   ClearSavedValue();
   saved_key_.clear();
@@ -401,35 +428,37 @@ void DBIter::Seek(const Slice& target) {
   }
 }
 
-int DBIter::SeekToFirst() {
+void DBIter::SeekToFirst() {
   direction_ = kForward;
+  has_prefix_ = false;
   ClearSavedValue();
-  set_index_of_runs(iter_->SeekToFirst());
+  iter_->SeekToFirst();
   if (iter_->Valid()) { // 也要跳过被删除的entry
     FindNextUserEntry(false, &saved_key_ /* temporary storage */);
   } else {
     valid_ = false;
   }
-  return get_index_of_runs();
 }
 
 void DBIter::SeekToLast() {
+  if (prefix_extractor_ != nullptr) {
+    SetReverseNotSupported();
+    return;
+  }
   direction_ = kReverse;
   ClearSavedValue();
   iter_->SeekToLast();
   FindPrevUserEntry();
 }
 
-const Comparator * DBIter::GetComperator() {
-  return user_comparator_;
-}
-
 }  // anonymous namespace
 
 Iterator* NewDBIterator(DBImpl* db, const Comparator* user_key_comparator,
                         Iterator* internal_iter, SequenceNumber sequence,
-                        uint32_t seed) {
-  return new DBIter(db, user_key_comparator, internal_iter, sequence, seed);
+                        uint32_t seed, RangeTombstoneSet* tombstones,
+                        const SliceTransform* prefix_extractor) {
+  return new DBIter(db, user_key_comparator, internal_iter, sequence, seed,
+                    tombstones, prefix_extractor);
 }
 
 
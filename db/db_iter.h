@@ -13,13 +13,19 @@
 namespace leveldb {
 
 class DBImpl;
+class RangeTombstoneSet;
 
 // Return a new iterator that converts internal keys (yielded by
 // "*internal_iter") that were live at the specified "sequence" number
-// into appropriate user keys.
+// into appropriate user keys.  Entries deleted by "tombstones" are
+// skipped like deleted ones.  The iterator takes ownership of
+// "tombstones", which may be nullptr.  If "prefix_extractor" is non-null,
+// a Seek() to a key in its domain only yields the keys of the same prefix,
+// and Prev() and SeekToLast() are not supported.
 Iterator* NewDBIterator(DBImpl* db, const Comparator* user_key_comparator,
                         Iterator* internal_iter, SequenceNumber sequence,
-                        uint32_t seed);
+                        uint32_t seed, RangeTombstoneSet* tombstones,
+                        const SliceTransform* prefix_extractor = nullptr);
 
 }  // namespace leveldb
 
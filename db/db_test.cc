@@ -6,6 +6,7 @@
 
 #include <atomic>
 #include <cinttypes>
+#include <memory>
 #include <string>
 
 #include "gtest/gtest.h"
@@ -16,6 +17,9 @@
 #include "leveldb/cache.h"
 #include "leveldb/env.h"
 #include "leveldb/filter_policy.h"
+#include "leveldb/rate_limiter.h"
+#include "leveldb/slice_transform.h"
+#include "leveldb/sst_file_writer.h"
 #include "leveldb/table.h"
 #include "port/port.h"
 #include "port/thread_annotations.h"
@@ -23,7 +27,6 @@
 #include "util/logging.h"
 #include "util/mutexlock.h"
 #include "util/testutil.h"
-#include "leveldb/RemixHelper.h"
 
 namespace leveldb {
 
@@ -307,6 +310,16 @@ class DBTest : public testing::Test {
       case kUncompressed:
         options.compression = kNoCompression;
         break;
+      case kConcurrentWrites:
+        options.allow_concurrent_memtable_write = true;
+        break;
+      case kPipelinedWrites:
+        options.enable_pipelined_write = true;
+        break;
+      case kParallelCompactions:
+        options.max_background_compactions = 3;
+        options.max_subcompactions = 4;
+        break;
       default:
         break;
     }
@@ -421,6 +434,12 @@ class DBTest : public testing::Test {
             case kTypeDeletion:
               result += "DEL";
               break;
+            case kTypeRangeDeletion:
+              result += "RANGEDEL";
+              break;
+            case kTypeBlobIndex:
+              result += "BLOB";
+              break;
           }
         }
         iter->Next();
@@ -466,6 +485,21 @@ class DBTest : public testing::Test {
     return result;
   }
 
+  // Return the numbers of the blob files in the DB directory.
+  std::set<uint64_t> BlobFiles() {
+    std::vector<std::string> filenames;
+    EXPECT_LEVELDB_OK(env_->GetChildren(dbname_, &filenames));
+    std::set<uint64_t> result;
+    uint64_t number;
+    FileType type;
+    for (const std::string& filename : filenames) {
+      if (ParseFileName(filename, &number, &type) && type == kBlobFile) {
+        result.insert(number);
+      }
+    }
+    return result;
+  }
+
   int CountFiles() {
     std::vector<std::string> files;
     env_->GetChildren(dbname_, &files);
@@ -563,7 +597,16 @@ class DBTest : public testing::Test {
 
  private:
   // Sequence of option configurations to try
-  enum OptionConfig { kDefault, kReuse, kFilter, kUncompressed, kEnd };
+  enum OptionConfig {
+    kDefault,
+    kReuse,
+    kFilter,
+    kUncompressed,
+    kConcurrentWrites,
+    kPipelinedWrites,
+    kParallelCompactions,
+    kEnd
+  };
 
   const FilterPolicy* filter_policy_;
   int option_config_;
@@ -638,6 +681,73 @@ TEST_F(DBTest, GetFromImmutableLayer) {
   } while (ChangeOptions());
 }
 
+TEST_F(DBTest, ImmutableMemTableQueue) {
+  Options options = CurrentOptions();
+  options.env = env_;
+  options.write_buffer_size = 100000;  // Small write buffer
+  options.max_immutable_memtables = 3;
+  Reopen(&options);
+
+  // Block the first flush, so that full memtables pile up without
+  // stalling the writer.
+  env_->delay_data_sync_.store(true, std::memory_order_release);
+  ASSERT_LEVELDB_OK(Put("k1", std::string(100000, '1')));
+  ASSERT_LEVELDB_OK(Put("k2", std::string(100000, '2')));
+  ASSERT_LEVELDB_OK(Put("k3", std::string(100000, '3')));
+  ASSERT_LEVELDB_OK(Put("k4", std::string(100000, '4')));
+  std::string property;
+  ASSERT_TRUE(db_->GetProperty("leveldb.num-immutable-memtables", &property));
+  ASSERT_EQ("3", property);
+  ASSERT_EQ(std::string(100000, '1'), Get("k1"));
+  ASSERT_EQ(std::string(100000, '3'), Get("k3"));
+  Iterator* iter = db_->NewIterator(ReadOptions());
+  std::string keys;
+  for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+    keys += iter->key().ToString() + ",";
+  }
+  ASSERT_EQ("k1,k2,k3,k4,", keys);
+  delete iter;
+  env_->delay_data_sync_.store(false, std::memory_order_release);
+
+  ASSERT_LEVELDB_OK(dbfull()->TEST_CompactMemTable());
+  ASSERT_TRUE(db_->GetProperty("leveldb.num-immutable-memtables", &property));
+  ASSERT_EQ("0", property);
+  // Memtables that waited together were flushed into one file
+  ASSERT_LE(TotalTableFiles(), 3);
+
+  Reopen(&options);
+  for (char c = '1'; c <= '4'; c++) {
+    ASSERT_EQ(std::string(100000, c), Get(std::string("k") + c));
+  }
+}
+
+TEST_F(DBTest, RateLimiter) {
+  std::string property;
+  ASSERT_FALSE(
+      db_->GetProperty("leveldb.rate-limiter-throttled-bytes", &property));
+
+  // Flushing 200KB at 1MB/s leaves the writes of the table throttled.
+  std::unique_ptr<RateLimiter> limiter(NewRateLimiter(1 << 20));
+  Options options = CurrentOptions();
+  options.compression = kNoCompression;
+  options.rate_limiter = limiter.get();
+  Reopen(&options);
+  ASSERT_LEVELDB_OK(Put("k1", std::string(100000, '1')));
+  ASSERT_LEVELDB_OK(Put("k2", std::string(100000, '2')));
+  const uint64_t logged = limiter->GetTotalBytesThrough();
+  ASSERT_GE(logged, 200000);
+  ASSERT_LEVELDB_OK(dbfull()->TEST_CompactMemTable());
+  ASSERT_GE(limiter->GetTotalBytesThrough(), logged + 200000);
+  ASSERT_TRUE(
+      db_->GetProperty("leveldb.rate-limiter-throttled-bytes", &property));
+  ASSERT_NE("0", property);
+  ASSERT_TRUE(
+      db_->GetProperty("leveldb.rate-limiter-bytes-per-second", &property));
+  ASSERT_EQ("1048576", property);
+  ASSERT_EQ(std::string(100000, '2'), Get("k2"));
+  Close();
+}
+
 TEST_F(DBTest, GetFromVersions) {
   do {
     ASSERT_LEVELDB_OK(Put("foo", "v1"));
@@ -1080,6 +1190,444 @@ static std::string Key(int i) {
   return std::string(buf);
 }
 
+TEST_F(DBTest, MultiGet) {
+  do {
+    // Spread the keys over the deeper levels, level 0 and the memtable.
+    for (int i = 0; i < 100; i++) {
+      ASSERT_LEVELDB_OK(Put(Key(i), "base" + Key(i)));
+    }
+    db_->CompactRange(nullptr, nullptr);
+    for (int i = 0; i < 100; i += 3) {
+      ASSERT_LEVELDB_OK(Put(Key(i), "l0" + Key(i)));
+    }
+    for (int i = 0; i < 100; i += 7) {
+      ASSERT_LEVELDB_OK(Delete(Key(i)));
+    }
+    dbfull()->TEST_CompactMemTable();
+    const Snapshot* snapshot = db_->GetSnapshot();
+    for (int i = 0; i < 100; i += 5) {
+      ASSERT_LEVELDB_OK(Put(Key(i), "mem" + Key(i)));
+    }
+    ASSERT_LEVELDB_OK(Delete(Key(11)));
+
+    // Ask in random order, with duplicates and missing keys.
+    std::vector<std::string> key_strings;
+    Random rnd(test::RandomSeed());
+    for (int i = 0; i < 300; i++) {
+      key_strings.push_back(Key(rnd.Uniform(120)));
+    }
+    std::vector<Slice> keys(key_strings.begin(), key_strings.end());
+
+    for (int pass = 0; pass < 2; pass++) {
+      ReadOptions options;
+      options.snapshot = (pass == 0) ? nullptr : snapshot;
+      std::vector<std::string> values;
+      std::vector<Status> statuses = db_->MultiGet(options, keys, &values);
+      ASSERT_EQ(keys.size(), statuses.size());
+      ASSERT_EQ(keys.size(), values.size());
+      for (size_t i = 0; i < keys.size(); i++) {
+        std::string expected;
+        Status s = db_->Get(options, keys[i], &expected);
+        ASSERT_EQ(s.ToString(), statuses[i].ToString()) << key_strings[i];
+        if (s.ok()) {
+          ASSERT_EQ(expected, values[i]) << key_strings[i];
+        }
+      }
+    }
+    db_->ReleaseSnapshot(snapshot);
+
+    std::vector<std::string> values;
+    ASSERT_TRUE(db_->MultiGet(ReadOptions(), {}, &values).empty());
+    ASSERT_TRUE(values.empty());
+  } while (ChangeOptions());
+}
+
+TEST_F(DBTest, DeleteRange) {
+  do {
+    for (int i = 0; i < 20; i++) {
+      ASSERT_LEVELDB_OK(Put(Key(i), "v" + Key(i)));
+    }
+    db_->CompactRange(nullptr, nullptr);
+    for (int i = 0; i < 20; i += 2) {
+      ASSERT_LEVELDB_OK(Put(Key(i), "w" + Key(i)));
+    }
+    dbfull()->TEST_CompactMemTable();
+    const Snapshot* snapshot = db_->GetSnapshot();
+    ASSERT_LEVELDB_OK(db_->DeleteRange(WriteOptions(), Key(5), Key(15)));
+    ASSERT_LEVELDB_OK(Put(Key(8), "new"));
+
+    std::string expected;
+    for (int i = 0; i < 20; i++) {
+      if (i == 8) {
+        expected += Key(i) + "->new ";
+      } else if (i < 5 || i >= 15) {
+        expected += Key(i) + "->" + (i % 2 == 0 ? "w" : "v") + Key(i) + " ";
+      }
+    }
+    for (int round = 0; round < 4; round++) {
+      ASSERT_EQ("NOT_FOUND", Get(Key(5)));
+      ASSERT_EQ("NOT_FOUND", Get(Key(14)));
+      ASSERT_EQ("new", Get(Key(8)));
+      ASSERT_EQ("v" + Key(15), Get(Key(15)));
+      ASSERT_EQ("w" + Key(4), Get(Key(4)));
+      if (snapshot != nullptr) {
+        ASSERT_EQ("w" + Key(6), Get(Key(6), snapshot));
+        ASSERT_EQ("v" + Key(7), Get(Key(7), snapshot));
+      }
+
+      std::string forward;
+      Iterator* iter = db_->NewIterator(ReadOptions());
+      for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+        forward += iter->key().ToString() + "->" + iter->value().ToString() +
+                   " ";
+      }
+      ASSERT_EQ(expected, forward);
+      std::string backward;
+      for (iter->SeekToLast(); iter->Valid(); iter->Prev()) {
+        backward = iter->key().ToString() + "->" + iter->value().ToString() +
+                   " " + backward;
+      }
+      ASSERT_EQ(expected, backward);
+      iter->Seek(Key(5));
+      ASSERT_EQ(Key(8) + "->new", IterStatus(iter));
+      iter->Next();
+      ASSERT_EQ(Key(15) + "->v" + Key(15), IterStatus(iter));
+      delete iter;
+
+      std::vector<Slice> keys = {Key(3), Key(7), Key(8)};
+      std::vector<std::string> values;
+      std::vector<Status> statuses = db_->MultiGet(ReadOptions(), keys,
+                                                   &values);
+      ASSERT_TRUE(statuses[0].ok());
+      ASSERT_TRUE(statuses[1].IsNotFound());
+      ASSERT_EQ("new", values[2]);
+
+      // Read the tombstone from the memtable, level 0, the MANIFEST after
+      // a reopen and after a full compaction.
+      if (round == 0) {
+        dbfull()->TEST_CompactMemTable();
+      } else if (round == 1) {
+        db_->ReleaseSnapshot(snapshot);
+        snapshot = nullptr;
+        Reopen();
+      } else if (round == 2) {
+        db_->CompactRange(nullptr, nullptr);
+      }
+    }
+  } while (ChangeOptions());
+}
+
+TEST_F(DBTest, DeleteRangeDropsFiles) {
+  Options options = CurrentOptions();
+  options.write_buffer_size = 100000;  // Small write buffer
+  Reopen(&options);
+
+  Random rnd(301);
+  for (int i = 0; i < 2000; i++) {
+    ASSERT_LEVELDB_OK(Put(Key(i), RandomString(&rnd, 500)));
+  }
+  ASSERT_LEVELDB_OK(Put("zzz", "last"));
+  db_->CompactRange(nullptr, nullptr);
+  const int before = TotalTableFiles();
+  ASSERT_GT(before, 3);
+  const uint64_t size_before = Size(Key(0), Key(2000));
+
+  ASSERT_LEVELDB_OK(db_->DeleteRange(WriteOptions(), Key(0), Key(2000)));
+  dbfull()->TEST_CompactMemTable();
+  // Whole files inside the deleted range are dropped without compacting.
+  for (int i = 0; i < 100 && TotalTableFiles() > 1; i++) {
+    DelayMilliseconds(10);
+  }
+  ASSERT_EQ(1, TotalTableFiles());
+  ASSERT_LT(Size(Key(0), Key(2000)), size_before);
+  ASSERT_EQ("NOT_FOUND", Get(Key(100)));
+  ASSERT_EQ("last", Get("zzz"));
+
+  // Later writes into the deleted range are visible.
+  ASSERT_LEVELDB_OK(Put(Key(100), "again"));
+  dbfull()->TEST_CompactMemTable();
+  db_->CompactRange(nullptr, nullptr);
+  Reopen(&options);
+  ASSERT_EQ("again", Get(Key(100)));
+  ASSERT_EQ("NOT_FOUND", Get(Key(101)));
+}
+
+TEST_F(DBTest, IngestExternalFile) {
+  const std::string sst = testing::TempDir() + "db_test_ingest.ldb";
+  do {
+    Options options = CurrentOptions();
+    SstFileWriter writer(options);
+
+    // A file over an empty range is moved in as is, to the last level.
+    ASSERT_LEVELDB_OK(writer.Open(sst));
+    for (int i = 0; i < 100; i++) {
+      ASSERT_LEVELDB_OK(writer.Put(Key(i), "a" + Key(i)));
+    }
+    ASSERT_LEVELDB_OK(writer.Finish());
+    ASSERT_EQ(100, writer.NumEntries());
+    IngestExternalFileOptions ingest_options;
+    ingest_options.move_files = true;
+    ASSERT_LEVELDB_OK(db_->IngestExternalFile(ingest_options, sst));
+    ASSERT_TRUE(!env_->FileExists(sst));
+    ASSERT_EQ(1, NumTableFilesAtLevel(config::kNumLevels - 1));
+    ASSERT_EQ("a" + Key(5), Get(Key(5)));
+
+    // A file over existing entries is newer than all of them, but not
+    // visible to older snapshots.
+    ASSERT_LEVELDB_OK(Put(Key(10), "mem"));
+    ASSERT_LEVELDB_OK(Put(Key(150), "mem"));
+    const Snapshot* snapshot = db_->GetSnapshot();
+    ASSERT_LEVELDB_OK(writer.Open(sst));
+    for (int i = 0; i < 200; i += 2) {
+      if (i % 10 == 0) {
+        ASSERT_LEVELDB_OK(writer.Delete(Key(i)));
+      } else {
+        ASSERT_LEVELDB_OK(writer.Put(Key(i), "b" + Key(i)));
+      }
+    }
+    ASSERT_LEVELDB_OK(writer.Finish());
+    ASSERT_LEVELDB_OK(db_->IngestExternalFile(ingest_options, sst));
+    ASSERT_TRUE(env_->FileExists(sst));  // Rewritten, so left in place
+
+    for (int round = 0; round < 2; round++) {
+      ASSERT_EQ("a" + Key(1), Get(Key(1)));
+      ASSERT_EQ("b" + Key(2), Get(Key(2)));
+      ASSERT_EQ("NOT_FOUND", Get(Key(10)));
+      ASSERT_EQ("NOT_FOUND", Get(Key(150)));
+      ASSERT_EQ("b" + Key(152), Get(Key(152)));
+      ASSERT_EQ("NOT_FOUND", Get(Key(153)));
+      if (snapshot != nullptr) {
+        ASSERT_EQ("a" + Key(2), Get(Key(2), snapshot));
+        ASSERT_EQ("mem", Get(Key(10), snapshot));
+        ASSERT_EQ("NOT_FOUND", Get(Key(152), snapshot));
+        db_->ReleaseSnapshot(snapshot);
+        snapshot = nullptr;
+      }
+
+      int count = 0;
+      Iterator* iter = db_->NewIterator(ReadOptions());
+      for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+        count++;
+      }
+      delete iter;
+      ASSERT_EQ(100 - 10 + 50 - 10, count);
+
+      Reopen();
+    }
+
+    // Later writes are newer than the file
+    ASSERT_LEVELDB_OK(Put(Key(2), "c"));
+    ASSERT_EQ("c", Get(Key(2)));
+    env_->RemoveFile(sst);
+  } while (ChangeOptions());
+}
+
+TEST_F(DBTest, IngestExternalFileUnderImmutableRangeDeletion) {
+  const std::string sst = testing::TempDir() + "db_test_ingest.ldb";
+  Options options = CurrentOptions();
+  options.env = env_;
+  options.write_buffer_size = 100000;  // Small write buffer
+  options.max_immutable_memtables = 3;
+  Reopen(&options);
+
+  SstFileWriter writer(options);
+  ASSERT_LEVELDB_OK(writer.Open(sst));
+  for (int i = 10; i < 20; i++) {
+    ASSERT_LEVELDB_OK(writer.Put(Key(i), "v" + Key(i)));
+  }
+  ASSERT_LEVELDB_OK(writer.Finish());
+
+  // Block the flush, so that the range deletion is still in an immutable
+  // memtable when the file is ingested.
+  env_->delay_data_sync_.store(true, std::memory_order_release);
+  ASSERT_LEVELDB_OK(db_->DeleteRange(WriteOptions(), Key(0), Key(100)));
+  ASSERT_LEVELDB_OK(Put("k1", std::string(100000, '1')));
+  ASSERT_LEVELDB_OK(Put("k2", std::string(100000, '2')));
+  std::string property;
+  ASSERT_TRUE(db_->GetProperty("leveldb.num-immutable-memtables", &property));
+  ASSERT_EQ("1", property);
+
+  // The ingestion writes a file too, so release the syncs once it has
+  // had time to pick the sequence number of the file.
+  env_->StartThread(
+      [](void* arg) {
+        SpecialEnv* env = reinterpret_cast<SpecialEnv*>(arg);
+        env->SleepForMicroseconds(500000);
+        env->delay_data_sync_.store(false, std::memory_order_release);
+      },
+      env_);
+  ASSERT_LEVELDB_OK(db_->IngestExternalFile(IngestExternalFileOptions(), sst));
+  ASSERT_EQ("v" + Key(15), Get(Key(15)));
+
+  ASSERT_LEVELDB_OK(dbfull()->TEST_CompactMemTable());
+  ASSERT_EQ("v" + Key(15), Get(Key(15)));
+  Reopen(&options);
+  ASSERT_EQ("v" + Key(15), Get(Key(15)));
+  ASSERT_EQ(std::string(100000, '1'), Get("k1"));
+  env_->RemoveFile(sst);
+}
+
+TEST_F(DBTest, IngestExternalFileErrors) {
+  const std::string sst = testing::TempDir() + "db_test_ingest.ldb";
+  Options options = CurrentOptions();
+  SstFileWriter writer(options);
+  ASSERT_TRUE(writer.Put("a", "v").IsInvalidArgument());
+  ASSERT_TRUE(writer.Finish().IsInvalidArgument());
+
+  // Keys must be added in order
+  ASSERT_LEVELDB_OK(writer.Open(sst));
+  ASSERT_LEVELDB_OK(writer.Put("b", "v"));
+  ASSERT_TRUE(writer.Put("b", "v").IsInvalidArgument());
+  ASSERT_TRUE(writer.Put("a", "v").IsInvalidArgument());
+  ASSERT_TRUE(writer.Open(sst).IsInvalidArgument());
+  ASSERT_LEVELDB_OK(writer.Finish());
+  ASSERT_EQ(1, writer.NumEntries());
+  ASSERT_GT(writer.FileSize(), 0);
+
+  // Empty and missing files
+  const std::string empty = testing::TempDir() + "db_test_ingest_empty.ldb";
+  ASSERT_LEVELDB_OK(writer.Open(empty));
+  ASSERT_LEVELDB_OK(writer.Finish());
+  ASSERT_TRUE(db_->IngestExternalFile(IngestExternalFileOptions(), empty)
+                  .IsInvalidArgument());
+  ASSERT_TRUE(!db_->IngestExternalFile(IngestExternalFileOptions(),
+                                       empty + ".missing")
+                   .ok());
+
+  // The DB is unaffected by the failed ingestions
+  ASSERT_LEVELDB_OK(Put("a", "w"));
+  ASSERT_LEVELDB_OK(db_->IngestExternalFile(IngestExternalFileOptions(), sst));
+  ASSERT_EQ("w", Get("a"));
+  ASSERT_EQ("v", Get("b"));
+  env_->RemoveFile(sst);
+  env_->RemoveFile(empty);
+}
+
+TEST_F(DBTest, BlobValues) {
+  do {
+    for (int remix = 0; remix < 2; remix++) {
+      Options options = CurrentOptions();
+      options.create_if_missing = true;
+      options.blob_value_threshold = 100;
+      options.use_remix = (remix == 1);
+      DestroyAndReopen(&options);
+
+      Random rnd(301);
+      std::vector<std::string> values;
+      for (int i = 0; i < 50; i++) {
+        // Every other value is large enough for a blob file
+        values.push_back(RandomString(&rnd, (i % 2 == 0) ? 1000 : 10));
+        ASSERT_LEVELDB_OK(Put(Key(i), values[i]));
+      }
+      ASSERT_LEVELDB_OK(Delete(Key(10)));
+      ASSERT_TRUE(BlobFiles().empty());
+      dbfull()->TEST_CompactMemTable();
+      ASSERT_EQ(1, BlobFiles().size());
+
+      for (int pass = 0; pass < 3; pass++) {
+        if (pass == 1) {
+          db_->CompactRange(nullptr, nullptr);
+        } else if (pass == 2) {
+          Reopen(&options);
+        }
+        ASSERT_FALSE(BlobFiles().empty());
+        for (int i = 0; i < 50; i++) {
+          ASSERT_EQ(i == 10 ? "NOT_FOUND" : values[i], Get(Key(i)));
+        }
+        std::vector<Slice> keys = {Key(3), Key(4), Key(10)};
+        std::vector<std::string> got;
+        std::vector<Status> statuses = db_->MultiGet(ReadOptions(), keys,
+                                                     &got);
+        ASSERT_LEVELDB_OK(statuses[0]);
+        ASSERT_LEVELDB_OK(statuses[1]);
+        ASSERT_TRUE(statuses[2].IsNotFound());
+        ASSERT_EQ(values[3], got[0]);
+        ASSERT_EQ(values[4], got[1]);
+
+        Iterator* iter = db_->NewIterator(ReadOptions());
+        int i = 0;
+        for (iter->SeekToFirst(); iter->Valid(); iter->Next(), i++) {
+          if (i == 10) i++;
+          ASSERT_EQ(Key(i), iter->key().ToString());
+          ASSERT_EQ(values[i], iter->value().ToString());
+        }
+        ASSERT_EQ(50, i);
+        i = 49;
+        for (iter->SeekToLast(); iter->Valid(); iter->Prev(), i--) {
+          if (i == 10) i--;
+          ASSERT_EQ(values[i], iter->value().ToString());
+        }
+        ASSERT_EQ(-1, i);
+        ASSERT_LEVELDB_OK(iter->status());
+        delete iter;
+      }
+    }
+  } while (ChangeOptions());
+}
+
+TEST_F(DBTest, BlobFilesAreCollected) {
+  Options options = CurrentOptions();
+  options.blob_value_threshold = 100;
+  options.blob_gc_age_cutoff = 0;
+  Reopen(&options);
+
+  Random rnd(301);
+  std::vector<std::string> values(100);
+  for (int i = 0; i < 100; i++) {
+    values[i] = RandomString(&rnd, 1000);
+    ASSERT_LEVELDB_OK(Put(Key(i), values[i]));
+  }
+  dbfull()->TEST_CompactMemTable();
+  const std::set<uint64_t> first = BlobFiles();
+  ASSERT_EQ(1, first.size());
+
+  // Overwriting every value leaves no reference to the first blob file
+  for (int i = 0; i < 100; i++) {
+    values[i] = RandomString(&rnd, 1000);
+    ASSERT_LEVELDB_OK(Put(Key(i), values[i]));
+  }
+  dbfull()->TEST_CompactMemTable();
+  ASSERT_EQ(2, BlobFiles().size());
+  db_->CompactRange(nullptr, nullptr);
+  std::set<uint64_t> second = BlobFiles();
+  ASSERT_EQ(1, second.size());
+  ASSERT_EQ(0, first.count(*second.begin()));
+
+  // Overwriting half of the values leaves the other half in the old file
+  for (int i = 0; i < 50; i++) {
+    values[i] = RandomString(&rnd, 1000);
+    ASSERT_LEVELDB_OK(Put(Key(i), values[i]));
+  }
+  dbfull()->TEST_CompactMemTable();
+  db_->CompactRange(nullptr, nullptr);
+  ASSERT_EQ(1, BlobFiles().count(*second.begin()));
+
+  // ... until compactions move them to a new file.  The writes to both
+  // ends of the key range make the compaction rewrite all tables.
+  options.blob_gc_age_cutoff = 1.0;
+  Reopen(&options);
+  ASSERT_LEVELDB_OK(Put(Key(0), values[0]));
+  ASSERT_LEVELDB_OK(Put(Key(99), values[99]));
+  dbfull()->TEST_CompactMemTable();
+  db_->CompactRange(nullptr, nullptr);
+  ASSERT_EQ(0, BlobFiles().count(*second.begin()));
+  for (int i = 0; i < 100; i++) {
+    ASSERT_EQ(values[i], Get(Key(i)));
+  }
+
+  // Values are moved back into the tables once blob files are disabled
+  options.blob_value_threshold = 0;
+  Reopen(&options);
+  ASSERT_LEVELDB_OK(Put(Key(0), values[0]));
+  ASSERT_LEVELDB_OK(Put(Key(99), values[99]));
+  dbfull()->TEST_CompactMemTable();
+  db_->CompactRange(nullptr, nullptr);
+  ASSERT_TRUE(BlobFiles().empty());
+  for (int i = 0; i < 100; i++) {
+    ASSERT_EQ(values[i], Get(Key(i)));
+  }
+}
+
 TEST_F(DBTest, MinorCompactionsHappen) {
   Options options = CurrentOptions();
   options.write_buffer_size = 10000;
@@ -1972,6 +2520,94 @@ TEST_F(DBTest, BloomFilter) {
   delete options.filter_policy;
 }
 
+TEST_F(DBTest, PrefixSeek) {
+  env_->count_random_reads_ = true;
+  Options options = CurrentOptions();
+  options.env = env_;
+  options.block_cache = NewLRUCache(0);  // Prevent cache hits
+  options.filter_policy = NewBloomFilterPolicy(10);
+  options.prefix_extractor = NewFixedPrefixTransform(5);
+  options.block_size = 256;      // Several blocks per table
+  options.max_file_size = 4096;  // Several tables per level
+  Reopen(&options);
+
+  // Even tenants are present, spread over a sorted level and a newer table
+  const int kTenants = 100;
+  const int kKeys = 20;
+  char buf[100];
+  for (int t = 0; t < kTenants; t += 2) {
+    for (int i = 0; i < kKeys; i++) {
+      std::snprintf(buf, sizeof(buf), "t%03d/%04d", t, i);
+      ASSERT_LEVELDB_OK(Put(buf, buf));
+    }
+  }
+  Compact("a", "z");
+  for (int t = 0; t < kTenants; t += 10) {
+    std::snprintf(buf, sizeof(buf), "t%03d/%04d", t, kKeys);
+    ASSERT_LEVELDB_OK(Put(buf, buf));
+  }
+  dbfull()->TEST_CompactMemTable();
+
+  // Prevent auto compactions triggered by seeks
+  env_->delay_data_sync_.store(true, std::memory_order_release);
+
+  ReadOptions prefix_options;
+  prefix_options.prefix_same_as_start = true;
+  Iterator* iter = db_->NewIterator(prefix_options);
+  for (int t = 0; t < kTenants; t += 2) {
+    std::snprintf(buf, sizeof(buf), "t%03d/", t);
+    const std::string prefix = buf;
+    int count = 0;
+    for (iter->Seek(prefix + "0005"); iter->Valid(); iter->Next()) {
+      ASSERT_EQ(prefix, iter->key().ToString().substr(0, 5));
+      ASSERT_EQ(iter->key(), iter->value());
+      count++;
+    }
+    ASSERT_EQ(kKeys - 5 + (t % 10 == 0 ? 1 : 0), count);
+    ASSERT_LEVELDB_OK(iter->status());
+  }
+
+  // Absent tenants are skipped by the filters
+  env_->random_read_counter_.Reset();
+  for (int t = 1; t < kTenants; t += 2) {
+    std::snprintf(buf, sizeof(buf), "t%03d/", t);
+    iter->Seek(buf);
+    ASSERT_TRUE(!iter->Valid());
+    ASSERT_LEVELDB_OK(iter->status());
+  }
+  int reads = env_->random_read_counter_.Read();
+  std::fprintf(stderr, "%d absent prefixes => %d reads\n", kTenants / 2,
+               reads);
+  ASSERT_LE(reads, kTenants / 10);
+
+  // Keys outside the domain of the extractor are not bounded
+  iter->Seek("t");
+  ASSERT_TRUE(iter->Valid());
+  ASSERT_EQ("t000/0000", iter->key().ToString());
+  iter->SeekToFirst();
+  ASSERT_TRUE(iter->Valid());
+  ASSERT_EQ("t000/0000", iter->key().ToString());
+
+  iter->Seek("t000/");
+  iter->Prev();
+  ASSERT_TRUE(!iter->Valid());
+  ASSERT_TRUE(iter->status().IsNotSupportedError());
+  delete iter;
+
+  // Without the option a seek reads past the prefix
+  iter = db_->NewIterator(ReadOptions());
+  iter->Seek("t001/");
+  ASSERT_TRUE(iter->Valid());
+  ASSERT_EQ("t002/0000", iter->key().ToString());
+  delete iter;
+
+  env_->delay_data_sync_.store(false, std::memory_order_release);
+  Close();
+  delete options.block_cache;
+  delete options.filter_policy;
+  delete options.prefix_extractor;
+}
+
 TEST_F(DBTest, LogCloseError) {
   // Regression test for bug where we could ignore log file
   // Close() error when switching to a new log file.
@@ -2096,6 +2732,198 @@ TEST_F(DBTest, MultiThreaded) {
   } while (ChangeOptions());
 }
 
+namespace {
+
+struct WriterState {
+  DB* db;
+  int id;
+  std::atomic<bool> done;
+};
+
+static void WriterThreadBody(void* arg) {
+  WriterState* state = reinterpret_cast<WriterState*>(arg);
+  char key[30];
+  for (int i = 0; i < 1000; i++) {
+    WriteBatch batch;
+    std::snprintf(key, sizeof(key), "%d.%06d.a", state->id, i);
+    batch.Put(key, key);
+    std::snprintf(key, sizeof(key), "%d.%06d.b", state->id, i);
+    batch.Put(key, key);
+    WriteOptions options;
+    options.sync = (i % 100 == 0);
+    ASSERT_LEVELDB_OK(state->db->Write(options, &batch));
+  }
+  state->done.store(true, std::memory_order_release);
+}
+
+}  // namespace
+
+TEST_F(DBTest, PipelinedConcurrentWriters) {
+  Options options = CurrentOptions();
+  options.create_if_missing = true;
+  options.write_buffer_size = 100000;  // Switch memtables while writing
+  options.allow_concurrent_memtable_write = true;
+  options.enable_pipelined_write = true;
+  DestroyAndReopen(&options);
+
+  static const int kWriters = 8;
+  WriterState state[kWriters];
+  for (int id = 0; id < kWriters; id++) {
+    state[id].db = db_;
+    state[id].id = id;
+    state[id].done.store(false, std::memory_order_release);
+    env_->StartThread(WriterThreadBody, &state[id]);
+  }
+  for (int id = 0; id < kWriters; id++) {
+    while (!state[id].done.load(std::memory_order_acquire)) {
+      DelayMilliseconds(10);
+    }
+  }
+
+  for (int pass = 0; pass < 2; pass++) {
+    char key[30];
+    for (int id = 0; id < kWriters; id++) {
+      for (int i = 0; i < 1000; i++) {
+        std::snprintf(key, sizeof(key), "%d.%06d.b", id, i);
+        ASSERT_EQ(key, Get(key));
+      }
+    }
+    Reopen(&options);
+  }
+}
+
+TEST_F(DBTest, IngestExternalFileWithConcurrentWriters) {
+  const std::string sst = testing::TempDir() + "db_test_ingest_writers.ldb";
+  for (int config = 0; config < 3; config++) {
+    Options options = CurrentOptions();
+    options.create_if_missing = true;
+    options.write_buffer_size = 100000;  // Switch memtables while writing
+    options.enable_pipelined_write = (config == 1);
+    options.allow_concurrent_memtable_write = (config == 2);
+    DestroyAndReopen(&options);
+
+    static const int kWriters = 4;
+    WriterState state[kWriters];
+    for (int id = 0; id < kWriters; id++) {
+      state[id].db = db_;
+      state[id].id = id;
+      state[id].done.store(false, std::memory_order_release);
+      env_->StartThread(WriterThreadBody, &state[id]);
+    }
+
+    // Each file covers keys the writers never touch, and overlaps the
+    // previous file so that it is rewritten behind the queued writes
+    SstFileWriter writer(options);
+    for (int round = 0; round < 20; round++) {
+      ASSERT_LEVELDB_OK(writer.Open(sst));
+      for (int i = round * 10; i < round * 10 + 20; i++) {
+        ASSERT_LEVELDB_OK(writer.Put(Key(i), "r" + NumberToString(round)));
+      }
+      ASSERT_LEVELDB_OK(writer.Finish());
+      ASSERT_LEVELDB_OK(
+          db_->IngestExternalFile(IngestExternalFileOptions(), sst));
+    }
+    for (int id = 0; id < kWriters; id++) {
+      while (!state[id].done.load(std::memory_order_acquire)) {
+        DelayMilliseconds(10);
+      }
+    }
+
+    ASSERT_EQ("r0", Get(Key(0)));
+    ASSERT_EQ("r19", Get(Key(200)));
+    ASSERT_EQ("r19", Get(Key(209)));
+    char key[30];
+    for (int id = 0; id < kWriters; id++) {
+      for (int i = 0; i < 1000; i++) {
+        std::snprintf(key, sizeof(key), "%d.%06d.a", id, i);
+        ASSERT_EQ(key, Get(key));
+      }
+    }
+    env_->RemoveFile(sst);
+  }
+}
+
+TEST_F(DBTest, ParallelCompactions) {
+  Options options = CurrentOptions();
+  options.create_if_missing = true;
+  options.write_buffer_size = 100000;  // Flush and compact while writing
+  options.max_background_compactions = 3;
+  DestroyAndReopen(&options);
+
+  static const int kWriters = 8;
+  WriterState state[kWriters];
+  for (int id = 0; id < kWriters; id++) {
+    state[id].db = db_;
+    state[id].id = id;
+    state[id].done.store(false, std::memory_order_release);
+    env_->StartThread(WriterThreadBody, &state[id]);
+  }
+  for (int id = 0; id < kWriters; id++) {
+    while (!state[id].done.load(std::memory_order_acquire)) {
+      DelayMilliseconds(10);
+    }
+  }
+  db_->CompactRange(nullptr, nullptr);
+  ASSERT_EQ(0, NumTableFilesAtLevel(0));
+
+  for (int pass = 0; pass < 2; pass++) {
+    char key[30];
+    for (int id = 0; id < kWriters; id++) {
+      for (int i = 0; i < 1000; i++) {
+        std::snprintf(key, sizeof(key), "%d.%06d.a", id, i);
+        ASSERT_EQ(key, Get(key));
+        std::snprintf(key, sizeof(key), "%d.%06d.b", id, i);
+        ASSERT_EQ(key, Get(key));
+      }
+    }
+    Reopen(&options);
+  }
+}
+
+TEST_F(DBTest, Subcompactions) {
+  Options options = CurrentOptions();
+  options.write_buffer_size = 100000;  // Many small level-0 files
+  options.max_subcompactions = 4;
+  Reopen(&options);
+
+  Random rnd(301);
+  std::vector<std::string> values;
+  for (int i = 0; i < 3000; i++) {
+    values.push_back(RandomString(&rnd, 1000));
+    ASSERT_LEVELDB_OK(Put(Key(i), values[i]));
+  }
+  dbfull()->CompactRange(nullptr, nullptr);
+  ASSERT_GT(TotalTableFiles(), 1);
+
+  // Overwrite or delete every third key, spread over all level-1 files
+  for (int i = 0; i < 3000; i += 3) {
+    if (i % 2 == 0) {
+      values[i] = RandomString(&rnd, 1000);
+      ASSERT_LEVELDB_OK(Put(Key(i), values[i]));
+    } else {
+      values[i].clear();
+      ASSERT_LEVELDB_OK(Delete(Key(i)));
+    }
+  }
+  dbfull()->CompactRange(nullptr, nullptr);
+  ASSERT_EQ(0, NumTableFilesAtLevel(0));
+
+  for (int pass = 0; pass < 2; pass++) {
+    int count = 0;
+    Iterator* iter = db_->NewIterator(ReadOptions());
+    for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+      count++;
+    }
+    ASSERT_LEVELDB_OK(iter->status());
+    delete iter;
+    ASSERT_EQ(2500, count);
+    for (int i = 0; i < 3000; i++) {
+      ASSERT_EQ(values[i].empty() ? "NOT_FOUND" : values[i], Get(Key(i)));
+    }
+    Reopen(&options);
+  }
+}
+
 namespace {
 typedef std::map<std::string, std::string> KVMap;
 }
@@ -2151,6 +2979,12 @@ class ModelDB : public DB {
         (*map_)[key.ToString()] = value.ToString();
       }
       void Delete(const Slice& key) override { map_->erase(key.ToString()); }
+      void DeleteRange(const Slice& begin, const Slice& end) override {
+        if (begin.compare(end) < 0) {
+          map_->erase(map_->lower_bound(begin.ToString()),
+                      map_->lower_bound(end.ToString()));
+        }
+      }
     };
     Handler handler;
     handler.map_ = &map_;
@@ -2168,7 +3002,7 @@ class ModelDB : public DB {
   void CompactRange(const Slice* start, const Slice* end) override {}
 
  private:
-  class ModelIter : public Iterator ,public Remix_Helper{
+  class ModelIter : public Iterator {
    public:
     ModelIter(const KVMap* map, bool owned)
         : map_(map), owned_(owned), iter_(map_->end()) {}
@@ -2176,7 +3010,7 @@ class ModelDB : public DB {
       if (owned_) delete map_;
     }
     bool Valid() const override { return iter_ != map_->end(); }
-    int SeekToFirst() override { iter_ = map_->begin(); return 0;}
+    void SeekToFirst() override { iter_ = map_->begin(); }
     void SeekToLast() override {
       if (map_->empty()) {
         iter_ = map_->end();
@@ -2187,7 +3021,7 @@ class ModelDB : public DB {
     void Seek(const Slice& k) override {
       iter_ = map_->lower_bound(k.ToString());
     }
-    int Next() override { ++iter_; return 0;}
+    void Next() override { ++iter_; }
     void Prev() override { --iter_; }
     Slice key() const override { return iter_->first; }
     Slice value() const override { return iter_->second; }
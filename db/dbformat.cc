@@ -102,7 +102,18 @@ void InternalKeyComparator::FindShortSuccessor(std::string* key) const {
   }
 }
 
-const char* InternalFilterPolicy::Name() const { return user_policy_->Name(); }
+InternalFilterPolicy::InternalFilterPolicy(
+    const FilterPolicy* p, const SliceTransform* prefix_extractor)
+    : user_policy_(p), prefix_extractor_(prefix_extractor) {
+  if (user_policy_ != nullptr && prefix_extractor_ != nullptr) {
+    name_ = std::string(user_policy_->Name()) + ".prefix." +
+            prefix_extractor_->Name();
+  }
+}
+
+const char* InternalFilterPolicy::Name() const {
+  return name_.empty() ? user_policy_->Name() : name_.c_str();
+}
 
 void InternalFilterPolicy::CreateFilter(const Slice* keys, int n,
                                         std::string* dst) const {
@@ -113,7 +124,22 @@ void InternalFilterPolicy::CreateFilter(const Slice* keys, int n,
     mkey[i] = ExtractUserKey(keys[i]);
     // TODO(sanjay): Suppress dups?
   }
-  user_policy_->CreateFilter(keys, n, dst);
+  if (prefix_extractor_ == nullptr) {
+    user_policy_->CreateFilter(keys, n, dst);
+    return;
+  }
+
+  // The keys of a prefix are adjacent, so each prefix is added once.
+  std::vector<Slice> all(keys, keys + n);
+  for (int i = 0; i < n; i++) {
+    if (prefix_extractor_->InDomain(keys[i])) {
+      const Slice prefix = prefix_extractor_->Transform(keys[i]);
+      if (all.size() == static_cast<size_t>(n) || all.back() != prefix) {
+        all.push_back(prefix);
+      }
+    }
+  }
+  user_policy_->CreateFilter(all.data(), static_cast<int>(all.size()), dst);
 }
 
 bool InternalFilterPolicy::KeyMayMatch(const Slice& key, const Slice& f) const {
@@ -25,7 +25,9 @@ enum FileType {
   kDescriptorFile,
   kCurrentFile,
   kTempFile,
-  kInfoLogFile  // Either the current one, or an old one
+  kInfoLogFile,  // Either the current one, or an old one
+  kRemixFile,
+  kBlobFile
 };
 
 // Return the name of the log file with the specified number
@@ -78,6 +80,15 @@ std::string LockFileName(const std::string& dbname);
 // The result will be prefixed with "dbname".
 std::string TempFileName(const std::string& dbname, uint64_t number);
 
+// Return the name of the persisted REMIX view with the specified number
+// in the db named by "dbname".  The result will be prefixed with
+// "dbname".
+std::string RemixFileName(const std::string& dbname, uint64_t number);
+
+// Return the name of the blob file with the specified number in the db
+// named by "dbname".  The result will be prefixed with "dbname".
+std::string BlobFileName(const std::string& dbname, uint64_t number);
+
 // Return the name of the info log file for "dbname".
 std::string InfoLogFileName(const std::string& dbname);
 
@@ -32,6 +32,8 @@ TEST(FileNameTest, Parse) {
       {"MANIFEST-7", 7, kDescriptorFile},
       {"LOG", 0, kInfoLogFile},
       {"LOG.old", 0, kInfoLogFile},
+      {"42.remix", 42, kRemixFile},
+      {"43.blob", 43, kBlobFile},
       {"18446744073709551615.log", 18446744073709551615ull, kLogFile},
   };
   for (int i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
@@ -111,6 +113,18 @@ TEST(FileNameTest, Construction) {
   ASSERT_EQ(999, number);
   ASSERT_EQ(kTempFile, type);
 
+  fname = RemixFileName("bar", 300);
+  ASSERT_EQ("bar/", std::string(fname.data(), 4));
+  ASSERT_TRUE(ParseFileName(fname.c_str() + 4, &number, &type));
+  ASSERT_EQ(300, number);
+  ASSERT_EQ(kRemixFile, type);
+
+  fname = BlobFileName("bar", 301);
+  ASSERT_EQ("bar/", std::string(fname.data(), 4));
+  ASSERT_TRUE(ParseFileName(fname.c_str() + 4, &number, &type));
+  ASSERT_EQ(301, number);
+  ASSERT_EQ(kBlobFile, type);
+
   fname = InfoLogFileName("foo");
   ASSERT_EQ("foo/", std::string(fname.data(), 4));
   ASSERT_TRUE(ParseFileName(fname.c_str() + 4, &number, &type));
@@ -16,8 +16,6 @@
 #include "leveldb/env.h"
 #include "leveldb/iterator.h"
 #include "util/coding.h"
-#include "leveldb/RemixHelper.h"
-#include "leveldb/Remix.h"
 
 namespace leveldb {
 // 获取Interkey，跳表中存放的是memtable中的一整个entry，该函数要从data中提取出interkey及逆行比较
@@ -29,12 +27,27 @@ static Slice GetLengthPrefixedSlice(const char* data) {
 }
 
 MemTable::MemTable(const InternalKeyComparator& comparator)
-    : comparator_(comparator), refs_(0), table_(comparator_, &arena_) {}
+    : comparator_(comparator),
+      refs_(0),
+      table_(comparator_, &arena_),
+      range_tombstones_(comparator_, &arena_) {}
 
 MemTable::~MemTable() { assert(refs_ == 0); }
 
 size_t MemTable::ApproximateMemoryUsage() { return arena_.MemoryUsage(); }
 
+bool MemTable::IsEmpty() const {
+  Table::Iterator iter(&table_);
+  iter.SeekToFirst();
+  return !iter.Valid() && !HasRangeTombstones();
+}
+
+bool MemTable::HasRangeTombstones() const {
+  Table::Iterator iter(&range_tombstones_);
+  iter.SeekToFirst();
+  return iter.Valid();
+}
+
 int MemTable::KeyComparator::operator()(const char* aptr,
                                         const char* bptr) const {
   // Internal keys are encoded as length-prefixed strings.
@@ -64,22 +77,9 @@ class MemTableIterator : public Iterator {
 
   bool Valid() const override { return iter_.Valid(); }
   void Seek(const Slice& k) override { iter_.Seek(EncodeKey(&tmp_, k)); }
-  int SeekToFirst() override { iter_.SeekToFirst(); return 0;}
+  void SeekToFirst() override { iter_.SeekToFirst(); }
   void SeekToLast() override { iter_.SeekToLast(); }
-  int Next() override { iter_.Next();  return 0;}
-  void Next(Remix* my_sorted_view,size_t &index_anchor_key, size_t &segment_index)override{
-    iter_.Next();
-    Segment *seg = &my_sorted_view->segments[index_anchor_key];
-    //int index;
-    if(segment_index+1 < seg->size){
-      //index = seg->Run_Selectors[segment_index+1];
-      segment_index++;
-    }
-    else if(index_anchor_key + 1 < my_sorted_view->segment_size){
-      //index = my_sorted_view->segments[index_anchor_key+1].Run_Selectors[0];
-      index_anchor_key++;
-    }
-  }
+  void Next() override { iter_.Next(); }
   void Prev() override { iter_.Prev(); }
   Slice key() const override { return GetLengthPrefixedSlice(iter_.key()); }
   Slice value() const override {
@@ -96,8 +96,25 @@ class MemTableIterator : public Iterator {
 
 Iterator* MemTable::NewIterator() { return new MemTableIterator(&table_); }
 
+Iterator* MemTable::NewRangeTombstoneIterator() {
+  return new MemTableIterator(&range_tombstones_);
+}
+
 void MemTable::Add(SequenceNumber s, ValueType type, const Slice& key,
                    const Slice& value) {
+  Table* table = (type == kTypeRangeDeletion) ? &range_tombstones_ : &table_;
+  table->Insert(NewEntry(s, type, key, value, false));
+}
+
+void MemTable::AddConcurrently(SequenceNumber s, ValueType type,
+                               const Slice& key, const Slice& value) {
+  Table* table = (type == kTypeRangeDeletion) ? &range_tombstones_ : &table_;
+  table->InsertConcurrently(NewEntry(s, type, key, value, true));
+}
+
+const char* MemTable::NewEntry(SequenceNumber s, ValueType type,
+                               const Slice& key, const Slice& value,
+                               bool concurrent) {
   // Format of an entry is concatenation of:
   //  key_size     : varint32 of internal_key.size()
   //  key bytes    : char[internal_key.size()]
@@ -110,7 +127,8 @@ void MemTable::Add(SequenceNumber s, ValueType type, const Slice& key,
   const size_t encoded_len = VarintLength(internal_key_size) +
                              internal_key_size + VarintLength(val_size) +
                              val_size;
-  char* buf = arena_.Allocate(encoded_len);
+  char* buf = concurrent ? arena_.AllocateConcurrently(encoded_len)
+                         : arena_.Allocate(encoded_len);
   char* p = EncodeVarint32(buf, internal_key_size);
   std::memcpy(p, key.data(), key_size);
   p += key_size;
@@ -119,10 +137,11 @@ void MemTable::Add(SequenceNumber s, ValueType type, const Slice& key,
   p = EncodeVarint32(p, val_size);
   std::memcpy(p, value.data(), val_size);
   assert(p + val_size == buf + encoded_len);
-  table_.Insert(buf);
+  return buf;
 }
 
-bool MemTable::Get(const LookupKey& key, std::string* value, Status* s) {
+bool MemTable::Get(const LookupKey& key, std::string* value, Status* s,
+                   SequenceNumber deleted_before) {
   // 取出key
   Slice memkey = key.memtable_key();
   Table::Iterator iter(&table_);
@@ -146,6 +165,10 @@ bool MemTable::Get(const LookupKey& key, std::string* value, Status* s) {
             Slice(key_ptr, key_length - 8), key.user_key()) == 0) {  // 这里主要是因为，seek（）找到的可能不是key值，所以需要再次检查
       // Correct user key
       const uint64_t tag = DecodeFixed64(key_ptr + key_length - 8);
+      if ((tag >> 8) < deleted_before) {
+        *s = Status::NotFound(Slice());
+        return true;
+      }
       switch (static_cast<ValueType>(tag & 0xff)) {
         case kTypeValue: {  // 如果ValueType为增加一个键-值对，则取出值并且返回true
           Slice v = GetLengthPrefixedSlice(key_ptr + key_length);
@@ -155,6 +178,12 @@ bool MemTable::Get(const LookupKey& key, std::string* value, Status* s) {
         case kTypeDeletion:  // 如果为删除一个键值对，则将状态赋值为NotFound
           *s = Status::NotFound(Slice());
           return true;
+        case kTypeRangeDeletion:
+          break;  // Never in table_
+        case kTypeBlobIndex:
+          // Values only move to blob files when tables are written
+          *s = Status::Corruption("blob index in memtable");
+          return true;
       }
     }
   }
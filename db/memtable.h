@@ -43,6 +43,10 @@ class MemTable {
   // data structure. It is safe to call when MemTable is being modified.
   size_t ApproximateMemoryUsage();
 
+  // Returns true iff no entry has been added.  It is safe to call when
+  // MemTable is being modified.
+  bool IsEmpty() const;
+
   // Return an iterator that yields the contents of the memtable.
   //
   // The caller must ensure that the underlying MemTable remains live
@@ -51,17 +55,37 @@ class MemTable {
   // db/format.{h,cc} module.
   Iterator* NewIterator();
 
+  // Return an iterator over the range tombstones of the memtable, which
+  // NewIterator() leaves out.  Its keys are internal keys holding the
+  // begin key of each tombstone and its values the end keys.
+  Iterator* NewRangeTombstoneIterator();
+
+  // Returns true iff a range tombstone has been added.  It is safe to call
+  // when MemTable is being modified.
+  bool HasRangeTombstones() const;
+
   // Add an entry into memtable that maps key to value at the
   // specified sequence number and with the specified type.
-  // Typically value will be empty if type==kTypeDeletion.
+  // Typically value will be empty if type==kTypeDeletion.  For
+  // type==kTypeRangeDeletion, key and value are the begin and end of the
+  // deleted range.
   void Add(SequenceNumber seq, ValueType type, const Slice& key,
            const Slice& value);
 
+  // Like Add(), but may be called by several threads at once.
+  // REQUIRES: no Add() call runs concurrently.
+  void AddConcurrently(SequenceNumber seq, ValueType type, const Slice& key,
+                       const Slice& value);
+
   // If memtable contains a value for key, store it in *value and return true.
   // If memtable contains a deletion for key, store a NotFound() error
   // in *status and return true.
   // Else, return false.
-  bool Get(const LookupKey& key, std::string* value, Status* s);
+  //
+  // Entries older than "deleted_before" are treated as deletions, since a
+  // range tombstone with that sequence number covers the key.
+  bool Get(const LookupKey& key, std::string* value, Status* s,
+           SequenceNumber deleted_before);
 
  private:
   friend class MemTableIterator;
@@ -77,10 +101,15 @@ class MemTable {
 
   ~MemTable();  // Private since only Unref() should be used to delete it
 
+  // Encode an entry for Add() or AddConcurrently() into the arena.
+  const char* NewEntry(SequenceNumber s, ValueType type, const Slice& key,
+                       const Slice& value, bool concurrent);
+
   KeyComparator comparator_;
   int refs_;
   Arena arena_;
   Table table_;
+  Table range_tombstones_;
 };
 
 }  // namespace leveldb
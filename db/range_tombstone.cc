@@ -0,0 +1,87 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "db/range_tombstone.h"
+
+#include <algorithm>
+
+#include "leveldb/comparator.h"
+#include "leveldb/iterator.h"
+
+namespace leveldb {
+
+RangeTombstoneSet::RangeTombstoneSet(const Comparator* ucmp,
+                                     SequenceNumber snapshot)
+    : ucmp_(ucmp), snapshot_(snapshot), finished_(false) {}
+
+void RangeTombstoneSet::Add(const Slice& begin, const Slice& end,
+                            SequenceNumber sequence) {
+  assert(!finished_);
+  if (sequence <= snapshot_ && ucmp_->Compare(begin, end) < 0) {
+    tombstones_.emplace_back(begin, end, sequence);
+  }
+}
+
+void RangeTombstoneSet::AddAll(Iterator* iter) {
+  for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+    ParsedInternalKey ikey;
+    if (ParseInternalKey(iter->key(), &ikey)) {
+      Add(ikey.user_key, iter->value(), ikey.sequence);
+    }
+  }
+}
+
+void RangeTombstoneSet::Finish() {
+  assert(!finished_);
+  finished_ = true;
+  if (tombstones_.empty()) {
+    return;
+  }
+
+  const Comparator* ucmp = ucmp_;
+  auto less = [ucmp](const std::string& a, const std::string& b) {
+    return ucmp->Compare(a, b) < 0;
+  };
+  for (const RangeTombstone& t : tombstones_) {
+    points_.push_back(t.begin);
+    points_.push_back(t.end);
+  }
+  std::sort(points_.begin(), points_.end(), less);
+  points_.erase(std::unique(points_.begin(), points_.end(),
+                            [ucmp](const std::string& a, const std::string& b) {
+                              return ucmp->Compare(a, b) == 0;
+                            }),
+                points_.end());
+
+  sequences_.assign(points_.size() - 1, 0);
+  for (const RangeTombstone& t : tombstones_) {
+    size_t i = std::lower_bound(points_.begin(), points_.end(), t.begin, less) -
+               points_.begin();
+    for (; ucmp_->Compare(points_[i], t.end) < 0; i++) {
+      sequences_[i] = std::max(sequences_[i], t.sequence);
+    }
+  }
+}
+
+SequenceNumber RangeTombstoneSet::MaxCoveringSequence(
+    const Slice& user_key) const {
+  assert(finished_);
+  // Find the last point at or before "user_key"
+  size_t left = 0;
+  size_t right = points_.size();
+  while (left < right) {
+    const size_t mid = (left + right) / 2;
+    if (ucmp_->Compare(points_[mid], user_key) <= 0) {
+      left = mid + 1;
+    } else {
+      right = mid;
+    }
+  }
+  if (left == 0 || left == points_.size()) {
+    return 0;  // Before the first or at or after the last point
+  }
+  return sequences_[left - 1];
+}
+
+}  // namespace leveldb
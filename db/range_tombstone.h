@@ -0,0 +1,87 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+//
+// DB::DeleteRange() writes a range tombstone, which deletes every entry of
+// the keys in [begin, end) that is older than the tombstone.  Tombstones
+// stay in the MemTable until it is flushed, and then in the MANIFEST until
+// no table file holds an entry they cover.  Reads collect the tombstones
+// visible to their snapshot into a RangeTombstoneSet.
+
+#ifndef STORAGE_LEVELDB_DB_RANGE_TOMBSTONE_H_
+#define STORAGE_LEVELDB_DB_RANGE_TOMBSTONE_H_
+
+#include <string>
+#include <vector>
+
+#include "db/dbformat.h"
+
+namespace leveldb {
+
+class Iterator;
+
+struct RangeTombstone {
+  RangeTombstone() : sequence(0) {}
+  RangeTombstone(const Slice& b, const Slice& e, SequenceNumber s)
+      : begin(b.ToString()), end(e.ToString()), sequence(s) {}
+
+  std::string begin;        // First deleted key
+  std::string end;          // Keys at or after "end" are not deleted
+  SequenceNumber sequence;  // Entries older than this are deleted
+};
+
+// The range tombstones that a read at some snapshot must honour, split
+// into non-overlapping fragments so that a key is checked with one binary
+// search.
+class RangeTombstoneSet {
+ public:
+  RangeTombstoneSet(const Comparator* ucmp, SequenceNumber snapshot);
+
+  RangeTombstoneSet(const RangeTombstoneSet&) = delete;
+  RangeTombstoneSet& operator=(const RangeTombstoneSet&) = delete;
+
+  // Add a tombstone.  Tombstones newer than the snapshot and empty ranges
+  // are ignored.
+  // REQUIRES: Finish() has not been called
+  void Add(const Slice& begin, const Slice& end, SequenceNumber sequence);
+
+  // Add the tombstones yielded by "iter", whose keys are internal keys
+  // holding the begin key and sequence and whose values are the end keys
+  // (see MemTable::NewRangeTombstoneIterator()).
+  // REQUIRES: Finish() has not been called
+  void AddAll(Iterator* iter);
+
+  // Split the tombstones into fragments.
+  // REQUIRES: Finish() has not been called
+  void Finish();
+
+  // Returns true iff no tombstone was added.
+  bool empty() const { return tombstones_.empty(); }
+
+  // Return the sequence number of the newest tombstone covering
+  // "user_key", or zero if there is none.  Entries of "user_key" with
+  // smaller sequence numbers are deleted.
+  // REQUIRES: Finish() has been called
+  SequenceNumber MaxCoveringSequence(const Slice& user_key) const;
+
+  // Returns true iff "key" is deleted by a tombstone.
+  // REQUIRES: Finish() has been called
+  bool ShouldDelete(const ParsedInternalKey& key) const {
+    return MaxCoveringSequence(key.user_key) > key.sequence;
+  }
+
+ private:
+  const Comparator* const ucmp_;
+  const SequenceNumber snapshot_;
+  std::vector<RangeTombstone> tombstones_;
+  bool finished_;
+
+  // Fragment i covers [points_[i], points_[i + 1]) and deletes the entries
+  // older than sequences_[i].
+  std::vector<std::string> points_;
+  std::vector<SequenceNumber> sequences_;
+};
+
+}  // namespace leveldb
+
+#endif  // STORAGE_LEVELDB_DB_RANGE_TOMBSTONE_H_
@@ -0,0 +1,67 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "db/range_tombstone.h"
+
+#include "leveldb/comparator.h"
+#include "gtest/gtest.h"
+
+namespace leveldb {
+
+TEST(RangeTombstoneSetTest, Empty) {
+  RangeTombstoneSet set(BytewiseComparator(), kMaxSequenceNumber);
+  ASSERT_TRUE(set.empty());
+  set.Finish();
+  ASSERT_EQ(0, set.MaxCoveringSequence("a"));
+}
+
+TEST(RangeTombstoneSetTest, Single) {
+  RangeTombstoneSet set(BytewiseComparator(), kMaxSequenceNumber);
+  set.Add("b", "d", 10);
+  ASSERT_FALSE(set.empty());
+  set.Finish();
+  ASSERT_EQ(0, set.MaxCoveringSequence("a"));
+  ASSERT_EQ(10, set.MaxCoveringSequence("b"));
+  ASSERT_EQ(10, set.MaxCoveringSequence("c"));
+  ASSERT_EQ(10, set.MaxCoveringSequence("cz"));
+  ASSERT_EQ(0, set.MaxCoveringSequence("d"));
+  ASSERT_EQ(0, set.MaxCoveringSequence("e"));
+
+  ASSERT_TRUE(set.ShouldDelete(ParsedInternalKey("c", 9, kTypeValue)));
+  ASSERT_FALSE(set.ShouldDelete(ParsedInternalKey("c", 10, kTypeValue)));
+  ASSERT_FALSE(set.ShouldDelete(ParsedInternalKey("c", 11, kTypeValue)));
+  ASSERT_FALSE(set.ShouldDelete(ParsedInternalKey("d", 1, kTypeValue)));
+}
+
+TEST(RangeTombstoneSetTest, Overlapping) {
+  RangeTombstoneSet set(BytewiseComparator(), kMaxSequenceNumber);
+  set.Add("a", "e", 5);
+  set.Add("c", "g", 20);
+  set.Add("d", "f", 7);
+  set.Add("x", "z", 3);
+  set.Finish();
+  ASSERT_EQ(5, set.MaxCoveringSequence("a"));
+  ASSERT_EQ(5, set.MaxCoveringSequence("b"));
+  ASSERT_EQ(20, set.MaxCoveringSequence("c"));
+  ASSERT_EQ(20, set.MaxCoveringSequence("d"));
+  ASSERT_EQ(20, set.MaxCoveringSequence("f"));
+  ASSERT_EQ(0, set.MaxCoveringSequence("g"));
+  ASSERT_EQ(0, set.MaxCoveringSequence("w"));
+  ASSERT_EQ(3, set.MaxCoveringSequence("y"));
+  ASSERT_EQ(0, set.MaxCoveringSequence("z"));
+}
+
+TEST(RangeTombstoneSetTest, Snapshot) {
+  RangeTombstoneSet set(BytewiseComparator(), 10);
+  set.Add("a", "c", 11);
+  set.Add("b", "d", 8);
+  set.Add("e", "e", 5);  // Empty range
+  set.Finish();
+  ASSERT_EQ(0, set.MaxCoveringSequence("a"));
+  ASSERT_EQ(8, set.MaxCoveringSequence("b"));
+  ASSERT_EQ(8, set.MaxCoveringSequence("c"));
+  ASSERT_EQ(0, set.MaxCoveringSequence("e"));
+}
+
+}  // namespace leveldb
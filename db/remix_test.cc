@@ -0,0 +1,733 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "leveldb/Remix.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "db/db_impl.h"
+#include "db/filename.h"
+#include "db/remix_view.h"
+#include "leveldb/comparator.h"
+#include "leveldb/db.h"
+#include "leveldb/env.h"
+#include "leveldb/iterator.h"
+#include "util/logging.h"
+#include "util/random.h"
+#include "util/testutil.h"
+
+namespace leveldb {
+
+// Counts the key comparisons made through it.
+class CountingComparator : public Comparator {
+ public:
+  CountingComparator() : count_(0) {}
+
+  const char* Name() const override { return base_->Name(); }
+  int Compare(const Slice& a, const Slice& b) const override {
+    count_.fetch_add(1, std::memory_order_relaxed);
+    return base_->Compare(a, b);
+  }
+  void FindShortestSeparator(std::string* start,
+                             const Slice& limit) const override {
+    base_->FindShortestSeparator(start, limit);
+  }
+  void FindShortSuccessor(std::string* key) const override {
+    base_->FindShortSuccessor(key);
+  }
+
+  int count() const { return count_.load(std::memory_order_relaxed); }
+
+ private:
+  const Comparator* const base_ = BytewiseComparator();
+  mutable std::atomic<int> count_;
+};
+
+static std::string Key(int i) {
+  char buf[100];
+  std::snprintf(buf, sizeof(buf), "key%06d", i);
+  return std::string(buf);
+}
+
+class RemixTest : public testing::Test {
+ public:
+  RemixTest() : env_(Env::Default()), db_(nullptr) {
+    options_.create_if_missing = true;
+    options_.block_size = 256;
+    dbname_ = testing::TempDir() + "remix_test";
+    DestroyDB(dbname_, Options());
+    Reopen();
+  }
+
+  ~RemixTest() {
+    delete db_;
+    DestroyDB(dbname_, Options());
+  }
+
+  DBImpl* dbfull() const { return reinterpret_cast<DBImpl*>(db_); }
+
+  void Reopen() {
+    delete db_;
+    db_ = nullptr;
+    ASSERT_LEVELDB_OK(DB::Open(options_, dbname_, &db_));
+  }
+
+  // Write several overlapping generations of keys so that the tables form
+  // multiple sorted runs holding overwritten and deleted entries.
+  void FillRuns(int num, int rounds) {
+    for (int r = 0; r < rounds; r++) {
+      for (int i = r; i < num; i += r + 1) {
+        std::string value = "v" + std::to_string(r) + "_" + Key(i);
+        ASSERT_LEVELDB_OK(db_->Put(WriteOptions(), Key(i), value));
+      }
+      for (int i = 0; i < num; i += 7 + r) {
+        ASSERT_LEVELDB_OK(db_->Delete(WriteOptions(), Key(i + r)));
+      }
+      ASSERT_LEVELDB_OK(dbfull()->TEST_CompactMemTable());
+      if (r == 0) {
+        dbfull()->TEST_CompactRange(0, nullptr, nullptr);
+      }
+    }
+  }
+
+  int NumTableFilesAtLevel(int level) {
+    std::string property;
+    EXPECT_TRUE(db_->GetProperty(
+        "leveldb.num-files-at-level" + std::to_string(level), &property));
+    return std::stoi(property);
+  }
+
+  std::vector<std::string> RemixFiles() {
+    std::vector<std::string> filenames, result;
+    env_->GetChildren(dbname_, &filenames);
+    uint64_t number;
+    FileType type;
+    for (const std::string& f : filenames) {
+      if (ParseFileName(f, &number, &type) && type == kRemixFile) {
+        result.push_back(f);
+      }
+    }
+    return result;
+  }
+
+  // Check that the view yields the same entries as a DB iterator for full
+  // scans in both directions and for short scans from many start keys.
+  void CheckMatchesDB(Remix* remix, int num) {
+    ASSERT_LEVELDB_OK(remix->status());
+    Iterator* expected = db_->NewIterator(ReadOptions());
+    Iterator* actual = remix->NewIterator();
+
+    int count = 0;
+    expected->SeekToFirst();
+    for (actual->SeekToFirst(); actual->Valid(); actual->Next()) {
+      ASSERT_TRUE(expected->Valid());
+      ASSERT_EQ(expected->key().ToString(), actual->key().ToString());
+      ASSERT_EQ(expected->value().ToString(), actual->value().ToString());
+      expected->Next();
+      count++;
+    }
+    ASSERT_FALSE(expected->Valid());
+    ASSERT_LEVELDB_OK(actual->status());
+
+    expected->SeekToLast();
+    for (actual->SeekToLast(); actual->Valid(); actual->Prev()) {
+      ASSERT_TRUE(expected->Valid());
+      ASSERT_EQ(expected->key().ToString(), actual->key().ToString());
+      ASSERT_EQ(expected->value().ToString(), actual->value().ToString());
+      expected->Prev();
+      count--;
+    }
+    ASSERT_FALSE(expected->Valid());
+    ASSERT_EQ(0, count);
+    ASSERT_LEVELDB_OK(actual->status());
+
+    // Short scans forward, then backward past the start key
+    for (int i = 0; i <= num; i += 13) {
+      std::string target = Key(i);
+      expected->Seek(target);
+      actual->Seek(target);
+      int steps = 0;
+      for (; steps < 10 && expected->Valid(); steps++) {
+        ASSERT_TRUE(actual->Valid()) << target;
+        ASSERT_EQ(expected->key().ToString(), actual->key().ToString());
+        ASSERT_EQ(expected->value().ToString(), actual->value().ToString());
+        expected->Next();
+        actual->Next();
+      }
+      if (!expected->Valid()) {
+        ASSERT_FALSE(actual->Valid()) << target;
+        continue;
+      }
+      for (int j = 0; j < steps + 5 && expected->Valid(); j++) {
+        expected->Prev();
+        actual->Prev();
+        if (!expected->Valid()) break;
+        ASSERT_TRUE(actual->Valid()) << target;
+        ASSERT_EQ(expected->key().ToString(), actual->key().ToString());
+        ASSERT_EQ(expected->value().ToString(), actual->value().ToString());
+      }
+      if (!expected->Valid()) {
+        ASSERT_FALSE(actual->Valid()) << target;
+      }
+    }
+    ASSERT_LEVELDB_OK(actual->status());
+    delete actual;
+    delete expected;
+  }
+
+  Env* env_;
+  Options options_;
+  std::string dbname_;
+  DB* db_;
+};
+
+TEST_F(RemixTest, Empty) {
+  Remix remix(db_);
+  ASSERT_LEVELDB_OK(remix.status());
+  Iterator* iter = remix.NewIterator();
+  iter->SeekToFirst();
+  ASSERT_FALSE(iter->Valid());
+  iter->SeekToLast();
+  ASSERT_FALSE(iter->Valid());
+  iter->Seek("a");
+  ASSERT_FALSE(iter->Valid());
+  ASSERT_LEVELDB_OK(iter->status());
+  delete iter;
+}
+
+TEST_F(RemixTest, MatchesDBIterator) {
+  const int kNum = 2000;
+  FillRuns(kNum, 4);
+  for (int segment_size : {1, 3, 16, 100}) {
+    Remix remix(db_, segment_size);
+    CheckMatchesDB(&remix, kNum);
+  }
+}
+
+TEST_F(RemixTest, SeekAmongSharedPrefixes) {
+  // Keys that are prefixes of each other, share more than eight bytes or
+  // hold zero and 0xff bytes exercise ties between anchor prefixes.
+  Random rnd(301);
+  const char kAlphabet[] = {'\0', 'a', 'b', '\xff'};
+  auto random_key = [&]() {
+    std::string key(rnd.Uniform(13), 'a');
+    for (size_t i = 0; i < key.size(); i++) {
+      if (rnd.OneIn(4)) key[i] = kAlphabet[rnd.Uniform(4)];
+    }
+    return key;
+  };
+  for (int r = 0; r < 3; r++) {
+    for (int i = 0; i < 500; i++) {
+      ASSERT_LEVELDB_OK(db_->Put(WriteOptions(), random_key(), Key(i)));
+    }
+    ASSERT_LEVELDB_OK(dbfull()->TEST_CompactMemTable());
+  }
+
+  for (int segment_size : {1, 4, 32}) {
+    Remix remix(db_, segment_size);
+    ASSERT_LEVELDB_OK(remix.status());
+    Iterator* expected = db_->NewIterator(ReadOptions());
+    Iterator* actual = remix.NewIterator();
+    for (int i = 0; i < 1000; i++) {
+      std::string target = random_key();
+      expected->Seek(target);
+      actual->Seek(target);
+      ASSERT_EQ(expected->Valid(), actual->Valid()) << EscapeString(target);
+      if (expected->Valid()) {
+        ASSERT_EQ(expected->key().ToString(), actual->key().ToString());
+      }
+    }
+    ASSERT_LEVELDB_OK(actual->status());
+    delete actual;
+    delete expected;
+  }
+}
+
+TEST_F(RemixTest, ParallelBuild) {
+  options_.remix_build_threads = 4;
+  Reopen();
+  // Large values spread the last level over several table files
+  const int kNum = 8000;
+  Random rnd(301);
+  std::string value;
+  for (int i = 0; i < kNum; i++) {
+    test::RandomString(&rnd, 1000, &value);
+    ASSERT_LEVELDB_OK(db_->Put(WriteOptions(), Key(i), value));
+  }
+  db_->CompactRange(nullptr, nullptr);
+  int widest = 0;
+  for (int level = 0; level < config::kNumLevels; level++) {
+    widest = std::max(widest, NumTableFilesAtLevel(level));
+  }
+  ASSERT_GT(widest, 2);
+  FillRuns(kNum, 3);
+
+  for (int segment_size : {1, 7, 64}) {
+    Remix remix(db_, segment_size);
+    CheckMatchesDB(&remix, kNum);
+  }
+}
+
+TEST_F(RemixTest, PersistedAcrossReopen) {
+  const int kNum = 1000;
+  FillRuns(kNum, 3);
+  {
+    Remix remix(db_, 8);
+    CheckMatchesDB(&remix, kNum);
+  }
+  std::vector<std::string> files = RemixFiles();
+  ASSERT_EQ(1, files.size());
+
+  // The reopened DB serves the persisted view instead of building a new one
+  Reopen();
+  {
+    Remix remix(db_, 8);
+    CheckMatchesDB(&remix, kNum);
+  }
+  ASSERT_EQ(files, RemixFiles());
+}
+
+TEST_F(RemixTest, StaleViewIsRebuilt) {
+  const int kNum = 1000;
+  FillRuns(kNum, 2);
+  {
+    Remix remix(db_, 8);
+    CheckMatchesDB(&remix, kNum);
+  }
+  std::vector<std::string> old_files = RemixFiles();
+  ASSERT_EQ(1, old_files.size());
+
+  for (int i = 0; i < kNum; i += 3) {
+    ASSERT_LEVELDB_OK(db_->Put(WriteOptions(), Key(i), "new"));
+  }
+  ASSERT_LEVELDB_OK(dbfull()->TEST_CompactMemTable());
+  Reopen();
+  {
+    Remix remix(db_, 8);
+    CheckMatchesDB(&remix, kNum);
+  }
+  std::vector<std::string> new_files = RemixFiles();
+  ASSERT_EQ(1, new_files.size());
+  ASSERT_NE(old_files, new_files);
+}
+
+TEST_F(RemixTest, CorruptedViewIsRebuilt) {
+  const int kNum = 1000;
+  FillRuns(kNum, 2);
+  {
+    Remix remix(db_, 8);
+  }
+  std::vector<std::string> files = RemixFiles();
+  ASSERT_EQ(1, files.size());
+  delete db_;
+  db_ = nullptr;
+
+  std::string fname = dbname_ + "/" + files[0];
+  std::string contents;
+  ASSERT_LEVELDB_OK(ReadFileToString(env_, fname, &contents));
+  contents[contents.size() / 2] ^= 0x80;
+  ASSERT_LEVELDB_OK(WriteStringToFile(env_, contents, fname));
+
+  Reopen();
+  Remix remix(db_, 8);
+  CheckMatchesDB(&remix, kNum);
+}
+
+TEST_F(RemixTest, UpdatedAfterFlushAndCompaction) {
+  const int kNum = 1000;
+  FillRuns(kNum, 2);
+  {
+    Remix remix(db_, 8);
+    CheckMatchesDB(&remix, kNum);
+  }
+  const std::vector<std::string> files = RemixFiles();
+  ASSERT_EQ(1, files.size());
+
+  for (int r = 0; r < 3; r++) {
+    for (int i = r * 100; i < kNum; i += 5) {
+      ASSERT_LEVELDB_OK(
+          db_->Put(WriteOptions(), Key(i), "update" + std::to_string(r)));
+    }
+    ASSERT_LEVELDB_OK(db_->Delete(WriteOptions(), Key(r * 7 + 1)));
+    ASSERT_LEVELDB_OK(dbfull()->TEST_CompactMemTable());
+    if (r == 1) {
+      dbfull()->TEST_CompactRange(0, nullptr, nullptr);
+    }
+
+    // The view was maintained by the background thread, so no new view is
+    // built and persisted.
+    Remix remix(db_, 8);
+    CheckMatchesDB(&remix, kNum);
+    ASSERT_EQ(files, RemixFiles());
+  }
+
+  // Keys outside the range of the old view land in new leading and
+  // trailing segments.
+  ASSERT_LEVELDB_OK(db_->Put(WriteOptions(), "a", "first"));
+  ASSERT_LEVELDB_OK(db_->Put(WriteOptions(), "z", "last"));
+  ASSERT_LEVELDB_OK(dbfull()->TEST_CompactMemTable());
+  {
+    Remix remix(db_, 8);
+    CheckMatchesDB(&remix, kNum);
+  }
+  ASSERT_EQ(files, RemixFiles());
+
+  // The maintained view is persisted when the DB is closed.
+  Reopen();
+  const std::vector<std::string> new_files = RemixFiles();
+  ASSERT_EQ(1, new_files.size());
+  ASSERT_NE(files, new_files);
+  {
+    Remix remix(db_, 8);
+    CheckMatchesDB(&remix, kNum);
+  }
+  ASSERT_EQ(new_files, RemixFiles());
+}
+
+TEST_F(RemixTest, OverwritesAtSegmentBoundaries) {
+  // With one entry per segment, an updated view reuses the segment of the
+  // older version right after each flushed overwrite, so the flag marking
+  // that entry as shadowed must be recomputed.
+  const int kNum = 200;
+  FillRuns(kNum, 2);
+  {
+    Remix remix(db_, 1);
+    CheckMatchesDB(&remix, kNum);
+  }
+  for (int r = 0; r < 4; r++) {
+    ASSERT_LEVELDB_OK(db_->Put(WriteOptions(), Key(r * 37 + 5), "new"));
+    ASSERT_LEVELDB_OK(dbfull()->TEST_CompactMemTable());
+    Remix remix(db_, 1);
+    CheckMatchesDB(&remix, kNum);
+  }
+}
+
+TEST_F(RemixTest, AdaptiveSegments) {
+  options_.use_remix = true;
+  options_.remix_segment_size = 16;
+  Reopen();
+  const int kNum = 4000;
+  FillRuns(kNum, 2);
+  RemixView* view;
+  ASSERT_LEVELDB_OK(dbfull()->GetRemixView(16, &view));
+  const size_t budget = view->ApproximateMemoryUsage();
+  dbfull()->ReleaseRemixView(view);
+  options_.remix_memory_budget = budget;
+  Reopen();
+
+  // Short scans from the first tenth of the keys only
+  const std::string hot_limit = Key(kNum / 10);
+  Random rnd(301);
+  Iterator* iter = db_->NewIterator(ReadOptions());
+  for (int i = 0; i < 2000; i++) {
+    iter->Seek(Key(rnd.Uniform(kNum / 10)));
+    ASSERT_TRUE(iter->Valid());
+    iter->Next();
+  }
+  delete iter;
+
+  // Overwrite the first and last keys so that every segment is rebuilt
+  ASSERT_LEVELDB_OK(db_->Put(WriteOptions(), Key(0), "first"));
+  ASSERT_LEVELDB_OK(db_->Put(WriteOptions(), Key(kNum - 1), "last"));
+  ASSERT_LEVELDB_OK(dbfull()->TEST_CompactMemTable());
+  ASSERT_LEVELDB_OK(dbfull()->GetRemixView(16, &view));
+  ASSERT_LE(view->ApproximateMemoryUsage(), budget + budget / 10);
+
+  // Debug lines read "'<user key>' @ <seq> : <type> [<entries>]"
+  int hot_segments = 0, hot_entries = 0, cold_segments = 0, cold_entries = 0;
+  std::istringstream lines(view->DebugString());
+  std::string line;
+  std::getline(lines, line);  // Header
+  while (std::getline(lines, line)) {
+    const std::string user_key = line.substr(1, line.find('\'', 1) - 1);
+    const int entries = std::stoi(line.substr(line.rfind('[') + 1));
+    if (user_key < hot_limit) {
+      hot_segments++;
+      hot_entries += entries;
+    } else {
+      cold_segments++;
+      cold_entries += entries;
+    }
+  }
+  dbfull()->ReleaseRemixView(view);
+  ASSERT_GT(hot_segments, 0);
+  ASSERT_GT(cold_segments, 0);
+  ASSERT_LT(hot_entries / hot_segments * 4, cold_entries / cold_segments);
+
+  Remix remix(db_, 16);
+  CheckMatchesDB(&remix, kNum);
+}
+
+TEST_F(RemixTest, MemoryBudget) {
+  std::string usage;
+  ASSERT_TRUE(db_->GetProperty("leveldb.remix-memory-usage", &usage));
+  ASSERT_EQ("0", usage);
+
+  options_.use_remix = true;
+  options_.remix_segment_size = 4;
+  Reopen();
+  const int kNum = 2000;
+  FillRuns(kNum, 3);
+  RemixView* view;
+  ASSERT_LEVELDB_OK(dbfull()->GetRemixView(4, &view));
+  const size_t full = view->ApproximateMemoryUsage();
+  dbfull()->ReleaseRemixView(view);
+  usage.clear();
+  ASSERT_TRUE(db_->GetProperty("leveldb.remix-memory-usage", &usage));
+  ASSERT_EQ(std::to_string(full), usage);
+
+  // The persisted view is shrunk into a smaller budget when it is loaded,
+  // and kept there as it is updated.
+  options_.remix_memory_budget = full / 2;
+  Reopen();
+  for (int r = 0; r < 3; r++) {
+    usage.clear();
+    ASSERT_TRUE(db_->GetProperty("leveldb.remix-memory-usage", &usage));
+    ASSERT_LE(std::stoull(usage), full / 2);
+    {
+      Remix remix(db_, 4);
+      CheckMatchesDB(&remix, kNum);
+    }
+    for (int i = r; i < kNum; i += 3) {
+      ASSERT_LEVELDB_OK(db_->Put(WriteOptions(), Key(i), "new"));
+    }
+    ASSERT_LEVELDB_OK(dbfull()->TEST_CompactMemTable());
+    ASSERT_LEVELDB_OK(dbfull()->GetRemixView(4, &view));
+    dbfull()->ReleaseRemixView(view);
+  }
+
+  // A budget that cannot be met leaves the longest possible segments
+  options_.remix_memory_budget = 1;
+  Reopen();
+  Remix remix(db_, 4);
+  CheckMatchesDB(&remix, kNum);
+}
+
+TEST_F(RemixTest, CompactSegments) {
+  const int kNum = 20000;
+  const std::string value(100, 'x');
+  size_t data_size = 0;
+  for (int r = 0; r < 3; r++) {
+    for (int i = r; i < kNum; i += 3) {
+      ASSERT_LEVELDB_OK(db_->Put(WriteOptions(), Key(i), value));
+      data_size += Key(i).size() + value.size();
+    }
+    ASSERT_LEVELDB_OK(dbfull()->TEST_CompactMemTable());
+  }
+
+  RemixView* view;
+  ASSERT_LEVELDB_OK(dbfull()->GetRemixView(32, &view));
+  ASSERT_EQ((kNum + 31) / 32, view->NumSegments());
+  // About one anchor, one byte per entry and one offset per run for every
+  // 32 entries.
+  ASSERT_LT(view->ApproximateMemoryUsage(), data_size / 10);
+  dbfull()->ReleaseRemixView(view);
+}
+
+namespace {
+
+struct ReaderState {
+  Remix* remix;
+  const Snapshot* snapshot;
+  const std::map<std::string, std::string>* expected;
+  std::atomic<int> errors;
+  std::atomic<int> done;
+};
+
+void ReaderBody(void* arg) {
+  ReaderState* state = reinterpret_cast<ReaderState*>(arg);
+  ReadOptions options;
+  options.snapshot = state->snapshot;
+  for (int round = 0; round < 20; round++) {
+    Iterator* iter = state->remix->NewIterator(options);
+    auto it = state->expected->begin();
+    for (iter->SeekToFirst(); iter->Valid(); iter->Next(), ++it) {
+      if (it == state->expected->end() || iter->key() != it->first ||
+          iter->value() != it->second) {
+        state->errors.fetch_add(1);
+        break;
+      }
+    }
+    if (iter->Valid() || it != state->expected->end() ||
+        !iter->status().ok()) {
+      state->errors.fetch_add(1);
+    }
+    int n = 0;
+    for (const auto& kv : *state->expected) {
+      if (n++ % 37 != 0) continue;
+      iter->Seek(kv.first);
+      if (!iter->Valid() || iter->key() != kv.first ||
+          iter->value() != kv.second) {
+        state->errors.fetch_add(1);
+      }
+    }
+    delete iter;
+  }
+  state->done.fetch_add(1);
+}
+
+}  // namespace
+
+TEST_F(RemixTest, ConcurrentSnapshotReaders) {
+  const int kNum = 1000;
+  const int kNumThreads = 4;
+  FillRuns(kNum, 3);
+  const Snapshot* snapshot = db_->GetSnapshot();
+  std::map<std::string, std::string> expected;
+  {
+    ReadOptions options;
+    options.snapshot = snapshot;
+    Iterator* iter = db_->NewIterator(options);
+    for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+      expected[iter->key().ToString()] = iter->value().ToString();
+    }
+    delete iter;
+  }
+
+  Remix remix(db_, 8);
+  ASSERT_LEVELDB_OK(remix.status());
+  ReaderState state;
+  state.remix = &remix;
+  state.snapshot = snapshot;
+  state.expected = &expected;
+  state.errors.store(0);
+  state.done.store(0);
+  for (int i = 0; i < kNumThreads; i++) {
+    env_->StartThread(ReaderBody, &state);
+  }
+
+  // Overwrite everything while the readers run.  The flushes and
+  // compactions replace the tables the view was built from.
+  for (int r = 0; r < 3; r++) {
+    for (int i = 0; i < kNum; i++) {
+      ASSERT_LEVELDB_OK(db_->Put(WriteOptions(), Key(i), "after"));
+    }
+    ASSERT_LEVELDB_OK(dbfull()->TEST_CompactMemTable());
+  }
+  dbfull()->TEST_CompactRange(0, nullptr, nullptr);
+  while (state.done.load() < kNumThreads) {
+    env_->SleepForMicroseconds(10000);
+  }
+  ASSERT_EQ(0, state.errors.load());
+
+  // A view of the new tables still honors the old snapshot
+  state.done.store(0);
+  Remix new_remix(db_, 8);
+  state.remix = &new_remix;
+  ReaderBody(&state);
+  ASSERT_EQ(0, state.errors.load());
+  db_->ReleaseSnapshot(snapshot);
+  CheckMatchesDB(&new_remix, kNum);
+}
+
+TEST_F(RemixTest, DBIteratorUsesView) {
+  CountingComparator cmp;
+  options_.comparator = &cmp;
+  options_.use_remix = true;
+  options_.remix_segment_size = 16;
+  Reopen();
+  // Few enough level-0 files that no compaction runs during the scans
+  const int kNum = 2000;
+  FillRuns(kNum, 3);
+  RemixView* view;
+  // Wait for the background thread to bring the view up to date
+  ASSERT_LEVELDB_OK(dbfull()->GetRemixView(16, &view));
+  dbfull()->ReleaseRemixView(view);
+
+  auto scan = [&](std::string* contents) {
+    const int start = cmp.count();
+    Iterator* iter = db_->NewIterator(ReadOptions());
+    for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+      contents->append(iter->key().ToString());
+      contents->append(iter->value().ToString());
+    }
+    EXPECT_LEVELDB_OK(iter->status());
+    delete iter;
+    return cmp.count() - start;
+  };
+
+  // New entries in the memtable are merged with the view
+  ASSERT_LEVELDB_OK(db_->Put(WriteOptions(), "z", "last"));
+  ASSERT_LEVELDB_OK(db_->Delete(WriteOptions(), Key(10)));
+  ASSERT_LEVELDB_OK(db_->Put(WriteOptions(), Key(11), "new"));
+  std::string hybrid;
+  const int hybrid_compares = scan(&hybrid);
+  ASSERT_EQ("zlast", hybrid.substr(hybrid.size() - 5));
+  ASSERT_EQ(std::string::npos, hybrid.find(Key(10)));
+  ASSERT_NE(std::string::npos, hybrid.find(Key(11) + "new"));
+
+  // Once they are flushed the scan uses the view alone and skips older
+  // versions and tombstones without comparing keys; only the cursors
+  // compare a few index keys when they first leave their starting blocks.
+  ASSERT_LEVELDB_OK(dbfull()->TEST_CompactMemTable());
+  ASSERT_LEVELDB_OK(dbfull()->GetRemixView(16, &view));
+  dbfull()->ReleaseRemixView(view);
+  std::string viewed;
+  const int view_compares = scan(&viewed);
+  ASSERT_EQ(hybrid, viewed);
+  ASSERT_LT(view_compares * 20, kNum);
+
+  // Without the view the scan merges the tables by comparing keys
+  options_.use_remix = false;
+  Reopen();
+  std::string merged;
+  const int merged_compares = scan(&merged);
+  ASSERT_EQ(merged, viewed);
+  ASSERT_LT(hybrid_compares * 2, merged_compares);
+  ASSERT_LT(view_compares * 2, merged_compares);
+
+  // The maintained view is persisted at close and loaded on open
+  options_.use_remix = true;
+  Reopen();
+  std::string reopened;
+  ASSERT_LT(scan(&reopened) * 2, merged_compares);
+  ASSERT_EQ(merged, reopened);
+  ASSERT_EQ(1, RemixFiles().size());
+
+  delete db_;
+  db_ = nullptr;
+}
+
+TEST_F(RemixTest, ViewBuiltOnOpenIsUsed) {
+  CountingComparator cmp;
+  options_.comparator = &cmp;
+  Reopen();
+  const int kNum = 2000;
+  FillRuns(kNum, 3);
+  ASSERT_TRUE(RemixFiles().empty());
+
+  auto scan = [&]() {
+    const int start = cmp.count();
+    Iterator* iter = db_->NewIterator(ReadOptions());
+    int count = 0;
+    for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+      count++;
+    }
+    EXPECT_LEVELDB_OK(iter->status());
+    EXPECT_GT(count, 0);
+    delete iter;
+    return cmp.count() - start;
+  };
+  const int merged_compares = scan();
+
+  // The view that the open builds and records in the MANIFEST serves the
+  // first iterators already.
+  options_.use_remix = true;
+  options_.remix_segment_size = 16;
+  Reopen();
+  ASSERT_EQ(1, RemixFiles().size());
+  ASSERT_LT(scan() * 20, merged_compares);
+
+  delete db_;
+  db_ = nullptr;
+}
+
+}  // namespace leveldb
@@ -0,0 +1,1242 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "db/remix_view.h"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <thread>
+#include <utility>
+
+#include "db/table_cache.h"
+#include "leveldb/comparator.h"
+#include "leveldb/iterator.h"
+#include "util/coding.h"
+#include "util/crc32c.h"
+#include "util/logging.h"
+
+namespace leveldb {
+
+// File format of a persisted view:
+//    magic:          fixed64
+//    format version: fixed32
+//    segment size:   varint32
+//    runs:           varint32 count, then per run
+//                      level, file count (varint32), file numbers (varint64)
+//    segments:       varint64 count, then per segment
+//                      anchor (length prefixed)
+//                      per run: file index, entry index, block offset,
+//                               block size (varint32/32/64/64)
+//                      selector count (varint32), one byte per selector
+//                      holding the run index and the entry flags
+//    checksum:       fixed32 masked crc32c of everything above
+static const uint64_t kRemixMagicNumber = 0x52454d4958564945ull;
+static const uint32_t kRemixFormatVersion = 3;
+
+// Returns the first eight bytes of the user key of "ikey" as a big-endian
+// integer padded with zeros.  Under the bytewise order a smaller prefix
+// means a smaller key, and keys with equal prefixes must be compared.
+static uint64_t AnchorPrefix(const Slice& ikey) {
+  const Slice user_key = ExtractUserKey(ikey);
+  uint64_t prefix = 0;
+  for (size_t i = 0; i < sizeof(prefix); i++) {
+    prefix <<= 8;
+    if (i < user_key.size()) {
+      prefix |= static_cast<uint8_t>(user_key[i]);
+    }
+  }
+  return prefix;
+}
+
+RemixView::RemixView(TableCache* table_cache,
+                     const InternalKeyComparator* icmp, Version* version,
+                     int segment_size)
+    : table_cache_(table_cache),
+      icmp_(icmp),
+      version_(version),
+      segment_size_(segment_size),
+      refs_(0),
+      use_prefixes_(icmp->user_comparator() == BytewiseComparator()),
+      memory_budget_(0) {
+  for (HeatRange& range : heat_) {
+    range.seeks.store(0, std::memory_order_relaxed);
+    range.steps.store(0, std::memory_order_relaxed);
+  }
+}
+
+RemixView::~RemixView() {
+  assert(refs_ == 0);
+  if (version_ != nullptr) {
+    version_->Unref();
+  }
+}
+
+Status RemixView::Build(TableCache* table_cache,
+                        const InternalKeyComparator* icmp, Version* version,
+                        int segment_size, int threads, RemixView** result) {
+  *result = nullptr;
+  if (segment_size <= 0) {
+    return Status::InvalidArgument("REMIX segment size must be positive");
+  }
+  RemixView* view = new RemixView(table_cache, icmp, version, segment_size);
+  version->GetSortedRuns(&view->runs_);
+
+  // Split the key space at the file boundaries of the run with the most
+  // files, which is normally the last level.
+  std::vector<Slice> bounds;
+  const SortedRun* widest = nullptr;
+  for (const SortedRun& run : view->runs_) {
+    if (widest == nullptr || run.files.size() > widest->files.size()) {
+      widest = &run;
+    }
+  }
+  if (widest != nullptr && threads > 1) {
+    const size_t partitions = std::min<size_t>(threads, widest->files.size());
+    for (size_t i = 1; i < partitions; i++) {
+      const size_t f = i * widest->files.size() / partitions;
+      bounds.push_back(widest->files[f]->smallest.Encode());
+    }
+  }
+
+  Status s;
+  if (bounds.empty()) {
+    s = view->AppendSegments(nullptr, nullptr);
+  } else {
+    s = view->AppendPartitions(bounds);
+  }
+  if (!s.ok()) {
+    view->version_ = nullptr;  // Leave the reference with the caller
+    delete view;
+    return s;
+  }
+  view->ShrinkToFit();
+  *result = view;
+  return s;
+}
+
+RunPosition* RemixView::AddSegment(const Slice& anchor) {
+  anchor_starts_.push_back(anchor_data_.size());
+  anchor_data_.append(anchor.data(), anchor.size());
+  if (use_prefixes_) {
+    anchor_prefixes_.push_back(AnchorPrefix(anchor));
+  }
+  selector_starts_.push_back(selectors_.size());
+  offsets_.resize(offsets_.size() + runs_.size());
+  return &offsets_[offsets_.size() - runs_.size()];
+}
+
+// shrink_to_fit() is only a request, which libstdc++ ignores when built
+// without exceptions, so copy the contents into an exactly sized buffer.
+template <typename T>
+static void ReleaseSpareCapacity(T* container) {
+  if (container->capacity() > container->size()) {
+    T(container->begin(), container->end()).swap(*container);
+  }
+}
+
+void RemixView::ShrinkToFit() {
+  ReleaseSpareCapacity(&anchor_data_);
+  ReleaseSpareCapacity(&anchor_starts_);
+  ReleaseSpareCapacity(&anchor_prefixes_);
+  ReleaseSpareCapacity(&selector_starts_);
+  ReleaseSpareCapacity(&selectors_);
+  ReleaseSpareCapacity(&offsets_);
+
+  prefix_index_.clear();
+  const std::vector<uint64_t>* level = &anchor_prefixes_;
+  while (level->size() > kPrefixFanout) {
+    std::vector<uint64_t> parent;
+    parent.reserve((level->size() + kPrefixFanout - 1) / kPrefixFanout);
+    for (size_t i = 0; i < level->size(); i += kPrefixFanout) {
+      parent.push_back((*level)[i]);
+    }
+    prefix_index_.push_back(std::move(parent));
+    level = &prefix_index_.back();
+  }
+}
+
+size_t RemixView::CountPrefixesBelow(uint64_t prefix) const {
+  // All prefixes before the node searched on each level are less than
+  // "prefix", and all after it are not.  The node of the next level
+  // starts at the last prefix found to be less.
+  size_t node = 0;
+  size_t count = 0;
+  for (size_t l = prefix_index_.size() + 1; l-- > 0;) {
+    const std::vector<uint64_t>& level =
+        (l == 0) ? anchor_prefixes_ : prefix_index_[l - 1];
+    const size_t begin = node * kPrefixFanout;
+    const size_t end = std::min(begin + kPrefixFanout, level.size());
+    // Counting without branches lets the compiler compare the node's
+    // prefixes with vector instructions.
+    size_t less = 0;
+    for (size_t i = begin; i < end; i++) {
+      less += (level[i] < prefix);
+    }
+    count = begin + less;
+    node = (count == 0) ? 0 : count - 1;
+  }
+  return count;
+}
+
+bool RemixView::SetMemoryBudget(size_t bytes) {
+  memory_budget_ = bytes;
+  return FitToBudget();
+}
+
+bool RemixView::FitToBudget() {
+  if (memory_budget_ == 0 || ApproximateMemoryUsage() <= memory_budget_) {
+    return false;
+  }
+  // Dropping the anchor of segment k merges its selectors into segment
+  // k - 1, since the selectors of both are adjacent.  Each pass drops the
+  // anchors whose merged segment stays within "limit" entries, starting
+  // with the densest ranges, and doubles the limit until the view fits.
+  const size_t per_anchor =
+      runs_.size() * sizeof(RunPosition) + 2 * sizeof(size_t) +
+      (use_prefixes_ ? sizeof(uint64_t) : 0);
+  size_t excess = ApproximateMemoryUsage() - memory_budget_;
+  bool merged = false;
+  for (size_t limit = 2; excess > 0 && limit <= kMaxSegmentSize &&
+                         NumSegments() > 1;
+       limit *= 2) {
+    std::string anchor_data;
+    std::vector<size_t> anchor_starts, selector_starts;
+    std::vector<uint64_t> anchor_prefixes;
+    std::vector<RunPosition> offsets;
+    const size_t n = runs_.size();
+    for (size_t k = 0; k < NumSegments(); k++) {
+      if (k > 0 && excess > 0 &&
+          SelectorEnd(k) - selector_starts.back() <= limit) {
+        // Merge into the previous kept segment
+        const size_t freed = per_anchor + Anchor(k).size();
+        excess = (excess > freed) ? excess - freed : 0;
+        merged = true;
+        continue;
+      }
+      anchor_starts.push_back(anchor_data.size());
+      anchor_data.append(Anchor(k).data(), Anchor(k).size());
+      if (use_prefixes_) {
+        anchor_prefixes.push_back(anchor_prefixes_[k]);
+      }
+      selector_starts.push_back(SelectorBegin(k));
+      offsets.insert(offsets.end(), Offsets(k), Offsets(k) + n);
+    }
+    anchor_data_.swap(anchor_data);
+    anchor_starts_.swap(anchor_starts);
+    anchor_prefixes_.swap(anchor_prefixes);
+    selector_starts_.swap(selector_starts);
+    offsets_.swap(offsets);
+  }
+  ShrinkToFit();
+  return merged;
+}
+
+size_t RemixView::ApproximateMemoryUsage() const {
+  size_t usage = sizeof(*this) + anchor_data_.capacity() +
+                 selectors_.capacity() +
+                 (anchor_starts_.capacity() + selector_starts_.capacity()) *
+                     sizeof(size_t) +
+                 anchor_prefixes_.capacity() * sizeof(uint64_t) +
+                 offsets_.capacity() * sizeof(RunPosition);
+  for (const std::vector<uint64_t>& level : prefix_index_) {
+    usage += sizeof(level) + level.capacity() * sizeof(uint64_t);
+  }
+  for (const SortedRun& run : runs_) {
+    usage += sizeof(run) + run.files.capacity() * sizeof(FileMetaData*);
+  }
+  return usage;
+}
+
+Status RemixView::AppendPartitions(const std::vector<Slice>& bounds) {
+  // Partition i covers [bounds[i-1], bounds[i]) and is built into its own
+  // view over the same runs, then appended to this one.
+  const size_t n = bounds.size() + 1;
+  std::vector<RemixView*> parts(n);
+  std::vector<Status> status(n);
+  std::vector<std::thread> workers;
+  for (size_t i = 0; i < n; i++) {
+    parts[i] = new RemixView(table_cache_, icmp_, nullptr, segment_size_);
+    parts[i]->runs_ = runs_;
+    parts[i]->plan_starts_ = plan_starts_;
+    parts[i]->plan_sizes_ = plan_sizes_;
+  }
+  for (size_t i = 0; i < n; i++) {
+    const Slice* start = (i == 0) ? nullptr : &bounds[i - 1];
+    const Slice* limit = (i + 1 == n) ? nullptr : &bounds[i];
+    workers.emplace_back([&parts, &status, i, start, limit]() {
+      status[i] = parts[i]->AppendSegments(start, limit);
+    });
+  }
+  Status s;
+  for (size_t i = 0; i < n; i++) {
+    workers[i].join();
+    if (s.ok()) {
+      s = status[i];
+    }
+    if (s.ok()) {
+      Append(*parts[i]);
+    }
+    delete parts[i];
+  }
+  return s;
+}
+
+void RemixView::Append(const RemixView& other) {
+  assert(other.runs_.size() == runs_.size());
+  const size_t anchor_base = anchor_data_.size();
+  const size_t selector_base = selectors_.size();
+  anchor_data_.append(other.anchor_data_);
+  for (size_t start : other.anchor_starts_) {
+    anchor_starts_.push_back(anchor_base + start);
+  }
+  anchor_prefixes_.insert(anchor_prefixes_.end(),
+                          other.anchor_prefixes_.begin(),
+                          other.anchor_prefixes_.end());
+  for (size_t start : other.selector_starts_) {
+    selector_starts_.push_back(selector_base + start);
+  }
+  selectors_.insert(selectors_.end(), other.selectors_.begin(),
+                    other.selectors_.end());
+  offsets_.insert(offsets_.end(), other.offsets_.begin(),
+                  other.offsets_.end());
+}
+
+Status RemixView::AppendSegments(const Slice* start, const Slice* limit) {
+  const int n = runs_.size();
+  if (runs_.size() > kMaxRuns) {
+    return Status::NotSupported("too many sorted runs for a REMIX view");
+  }
+  // The build reads every table once; keep it out of the block cache.
+  ReadOptions options;
+  options.fill_cache = false;
+  std::vector<RunCursor*> cursors(n);
+  for (int i = 0; i < n; i++) {
+    cursors[i] = new RunCursor(table_cache_, icmp_, &runs_[i], options);
+    if (start == nullptr) {
+      cursors[i]->SeekToFirst();
+    } else {
+      cursors[i]->Seek(*start);
+    }
+  }
+
+  const Comparator* ucmp = icmp_->user_comparator();
+  std::string prev_user_key;
+  bool has_prev = false;
+  Status s;
+  size_t segment_entries = 0;
+  size_t target = 0;  // Start a segment at once
+  while (true) {
+    int smallest = -1;
+    for (int i = 0; i < n; i++) {
+      if (cursors[i]->Valid() &&
+          (smallest < 0 ||
+           icmp_->Compare(cursors[i]->key(), cursors[smallest]->key()) < 0)) {
+        smallest = i;
+      }
+    }
+    if (smallest < 0 ||
+        (limit != nullptr &&
+         icmp_->Compare(cursors[smallest]->key(), *limit) >= 0)) {
+      break;
+    }
+    const Slice key = cursors[smallest]->key();
+    ParsedInternalKey parsed;
+    if (!ParseInternalKey(key, &parsed)) {
+      s = Status::Corruption("bad internal key in REMIX run");
+      break;
+    }
+    uint8_t selector = static_cast<uint8_t>(smallest);
+    if (parsed.type == kTypeDeletion) {
+      selector |= kDeletionFlag;
+    }
+    bool shadowed = false;
+    if (has_prev) {
+      shadowed = ucmp->Compare(parsed.user_key, prev_user_key) == 0;
+    } else if (start != nullptr) {
+      // Newer versions may precede "start"
+      s = HasNewerVersion(key, &shadowed);
+      if (!s.ok()) {
+        break;
+      }
+    }
+    if (shadowed) {
+      selector |= kShadowedFlag;
+    }
+    prev_user_key.assign(parsed.user_key.data(), parsed.user_key.size());
+    has_prev = true;
+
+    if (segment_entries == target) {
+      target = SegmentSizeAt(key);
+      RunPosition* offsets = AddSegment(key);
+      for (int i = 0; i < n; i++) {
+        cursors[i]->GetPosition(&offsets[i]);
+      }
+      segment_entries = 0;
+    }
+    selectors_.push_back(selector);
+    segment_entries++;
+    cursors[smallest]->Next();
+  }
+
+  for (int i = 0; i < n; i++) {
+    if (s.ok()) {
+      s = cursors[i]->status();
+    }
+    delete cursors[i];
+  }
+  return s;
+}
+
+size_t RemixView::SegmentSizeAt(const Slice& ikey) const {
+  if (plan_starts_.empty()) {
+    return segment_size_;
+  }
+  // Find the last range starting at or before ikey
+  size_t left = 0;
+  size_t right = plan_starts_.size();
+  while (left < right) {
+    size_t mid = (left + right) / 2;
+    if (icmp_->Compare(plan_starts_[mid], ikey) <= 0) {
+      left = mid + 1;
+    } else {
+      right = mid;
+    }
+  }
+  return plan_sizes_[(left == 0) ? 0 : left - 1];
+}
+
+void RemixView::PlanSegments(RemixView* next) const {
+  next->memory_budget_ = memory_budget_;
+  const size_t num_segments = NumSegments();
+  if (memory_budget_ == 0 || num_segments == 0) {
+    return;
+  }
+  uint64_t total_seeks = 0;
+  for (const HeatRange& range : heat_) {
+    total_seeks += range.seeks.load(std::memory_order_relaxed);
+  }
+  if (total_seeks == 0) {
+    // Nothing new was learned about the workload
+    next->plan_starts_ = plan_starts_;
+    next->plan_sizes_ = plan_sizes_;
+    return;
+  }
+
+  // Range r holds n[r] entries and costs c[r] bytes per anchor, so with
+  // s[r] entries per segment it takes n[r] * c[r] / s[r] bytes.  A seek
+  // scans about s[r] / 2 entries of its segment, which matters less the
+  // longer the scan that follows it.  Minimizing sum(w[r] * s[r]) for
+  // seek weights w[r] within the budget gives
+  //   s[r] = sqrt(n[r] * c[r] / w[r]) * sum(sqrt(n * c * w)) / budget.
+  const double base = segment_size_;
+  const size_t fixed = sizeof(*this) + selectors_.size();
+  const double budget = (memory_budget_ > fixed) ? memory_budget_ - fixed : 1;
+  std::vector<size_t> firsts;
+  std::vector<double> dense_bytes, weights;  // dense_bytes[r] = n[r] * c[r]
+  double sum = 0;
+  for (size_t r = 0; r < static_cast<size_t>(kHeatRanges); r++) {
+    // Segments k of range r are those with k * kHeatRanges / num_segments
+    // equal to r, as in RecordScan().
+    const size_t first = (r * num_segments + kHeatRanges - 1) / kHeatRanges;
+    const size_t limit =
+        ((r + 1) * num_segments + kHeatRanges - 1) / kHeatRanges;
+    if (first >= limit) {
+      continue;
+    }
+    const size_t anchor_end = (limit < num_segments) ? anchor_starts_[limit]
+                                                     : anchor_data_.size();
+    const size_t entries =
+        ((limit < num_segments) ? SelectorBegin(limit) : selectors_.size()) -
+        SelectorBegin(first);
+    const double anchor_cost =
+        static_cast<double>(anchor_end - anchor_starts_[first]) /
+            (limit - first) +
+        next->runs_.size() * sizeof(RunPosition) + 2 * sizeof(size_t) +
+        sizeof(uint64_t);
+    const double seeks = heat_[r].seeks.load(std::memory_order_relaxed);
+    const double steps = heat_[r].steps.load(std::memory_order_relaxed);
+    const double scan = (seeks > 0) ? steps / seeks : 0;
+    const double weight = (seeks + 1) * base / (base + scan);
+    firsts.push_back(first);
+    dense_bytes.push_back(entries * anchor_cost);
+    weights.push_back(weight);
+    sum += std::sqrt(entries * anchor_cost * weight);
+  }
+  for (size_t i = 0; i < firsts.size(); i++) {
+    const double size =
+        std::sqrt(dense_bytes[i] / weights[i]) * sum / budget;
+    next->plan_starts_.push_back(Anchor(firsts[i]).ToString());
+    next->plan_sizes_.push_back(static_cast<size_t>(std::max(
+        1.0, std::min<double>(std::ceil(size), kMaxSegmentSize))));
+  }
+}
+
+Status RemixView::HasNewerVersion(const Slice& ikey, bool* result) const {
+  *result = false;
+  ReadOptions options;
+  options.fill_cache = false;
+  const InternalKey newest(ExtractUserKey(ikey), kMaxSequenceNumber,
+                           kValueTypeForSeek);
+  for (const SortedRun& run : runs_) {
+    RunCursor cursor(table_cache_, icmp_, &run, options);
+    cursor.Seek(newest.Encode());
+    if (!cursor.status().ok()) {
+      return cursor.status();
+    }
+    if (cursor.Valid() && icmp_->Compare(cursor.key(), ikey) < 0) {
+      *result = true;
+      break;
+    }
+  }
+  return Status::OK();
+}
+
+namespace {
+
+// Identifies a sorted run across versions: a level-0 file, or a level.
+typedef std::pair<int, uint64_t> RunId;
+
+RunId IdOf(const SortedRun& run) {
+  return RunId(run.level, run.level == 0 ? run.files[0]->number : 0);
+}
+
+bool SamePosition(const RunPosition& a, const RunPosition& b) {
+  return a.file_index == b.file_index && a.block_offset == b.block_offset &&
+         a.entry_index == b.entry_index;
+}
+
+}  // namespace
+
+Status RemixView::Update(Version* version, RemixView** result) const {
+  *result = nullptr;
+  RemixView* view = new RemixView(table_cache_, icmp_, version, segment_size_);
+  version->GetSortedRuns(&view->runs_);
+  PlanSegments(view);
+  const std::vector<SortedRun>& new_runs = view->runs_;
+  const int old_n = runs_.size();
+  const int new_n = new_runs.size();
+  if (new_runs.size() > kMaxRuns) {
+    view->version_ = nullptr;  // Leave the reference with the caller
+    delete view;
+    return Status::NotSupported("too many sorted runs for a REMIX view");
+  }
+
+  // Match runs by identity, and remember where every file of the new
+  // runs lives.
+  std::vector<int> old_to_new(old_n, -1);
+  std::vector<int> new_to_old(new_n, -1);
+  std::map<RunId, int> new_run_index;
+  for (int j = 0; j < new_n; j++) {
+    new_run_index[IdOf(new_runs[j])] = j;
+  }
+  for (int i = 0; i < old_n; i++) {
+    auto it = new_run_index.find(IdOf(runs_[i]));
+    if (it != new_run_index.end()) {
+      old_to_new[i] = it->second;
+      new_to_old[it->second] = i;
+    }
+  }
+  std::map<uint64_t, std::pair<int, uint32_t>> new_files, old_files;
+  for (int j = 0; j < new_n; j++) {
+    for (size_t k = 0; k < new_runs[j].files.size(); k++) {
+      new_files[new_runs[j].files[k]->number] = std::make_pair(j, k);
+    }
+  }
+  for (int i = 0; i < old_n; i++) {
+    for (size_t k = 0; k < runs_[i].files.size(); k++) {
+      old_files[runs_[i].files[k]->number] = std::make_pair(old_to_new[i], k);
+    }
+  }
+
+  // [lo, hi] covers every file that was added, removed or moved to
+  // another run.  Entries outside of it are unchanged.
+  const FileMetaData* lo = nullptr;
+  const FileMetaData* hi = nullptr;
+  auto extend = [&](const FileMetaData* f) {
+    if (lo == nullptr || icmp_->Compare(f->smallest, lo->smallest) < 0) {
+      lo = f;
+    }
+    if (hi == nullptr || icmp_->Compare(f->largest, hi->largest) > 0) {
+      hi = f;
+    }
+  };
+  for (int i = 0; i < old_n; i++) {
+    for (const FileMetaData* f : runs_[i].files) {
+      auto it = new_files.find(f->number);
+      if (it == new_files.end() || it->second.first != old_to_new[i]) {
+        extend(f);
+      }
+    }
+  }
+  for (int j = 0; j < new_n; j++) {
+    for (const FileMetaData* f : new_runs[j].files) {
+      auto it = old_files.find(f->number);
+      if (it == old_files.end() || it->second.first != j) {
+        extend(f);
+      }
+    }
+  }
+
+  const size_t num_segments = NumSegments();
+  Status s;
+  if (num_segments == 0) {
+    s = view->AppendSegments(nullptr, nullptr);
+    if (!s.ok()) {
+      view->version_ = nullptr;
+      delete view;
+      return s;
+    }
+    *result = view;
+    return s;
+  }
+
+  // Segments [0, first) end before lo and segments [last, num_segments)
+  // start after hi; everything in between is rebuilt.
+  // If no file changed, every segment is remapped like the ones past hi.
+  size_t first = 0;
+  size_t last = 0;
+  if (lo != nullptr) {
+    const Slice lo_key = lo->smallest.Encode();
+    const Slice hi_key = hi->largest.Encode();
+    first = 0;
+    while (first + 1 < num_segments &&
+           icmp_->Compare(Anchor(first + 1), lo_key) <= 0) {
+      first++;
+    }
+    last = first;
+    while (last < num_segments && icmp_->Compare(Anchor(last), hi_key) <= 0) {
+      last++;
+    }
+  }
+
+  // Translate a position in old run "i" to the same entry in its new run.
+  auto remap = [&](int i, const RunPosition& pos, RunPosition* out) {
+    const int j = old_to_new[i];
+    *out = pos;
+    if (pos.file_index >= runs_[i].files.size()) {
+      out->file_index = new_runs[j].files.size();
+      return true;
+    }
+    auto it = new_files.find(runs_[i].files[pos.file_index]->number);
+    if (it == new_files.end() || it->second.first != j) {
+      return false;
+    }
+    out->file_index = it->second.second;
+    return true;
+  };
+
+  auto copy_selectors = [&](size_t k) {
+    for (size_t p = SelectorBegin(k); p < SelectorEnd(k); p++) {
+      const int j = old_to_new[selectors_[p] & kRunMask];
+      if (j < 0) {
+        return false;
+      }
+      view->selectors_.push_back(static_cast<uint8_t>(j) |
+                                 (selectors_[p] & ~kRunMask));
+    }
+    return true;
+  };
+
+  // Below lo, a run whose position at an anchor is already at or past lo
+  // (i.e. equals its position at lo) now continues at the new first entry
+  // at or past lo; other positions are untouched.
+  std::vector<RunPosition> old_at_lo(old_n), new_at_lo(new_n);
+  if (first > 0) {
+    ReadOptions options;
+    options.fill_cache = false;
+    const Slice lo_key = lo->smallest.Encode();
+    for (int i = 0; i < old_n && s.ok(); i++) {
+      RunCursor cursor(table_cache_, icmp_, &runs_[i], options);
+      cursor.Seek(lo_key);
+      cursor.GetPosition(&old_at_lo[i]);
+      s = cursor.status();
+    }
+    for (int j = 0; j < new_n && s.ok(); j++) {
+      RunCursor cursor(table_cache_, icmp_, &new_runs[j], options);
+      cursor.Seek(lo_key);
+      cursor.GetPosition(&new_at_lo[j]);
+      s = cursor.status();
+    }
+  }
+
+  bool reusable = s.ok();
+  for (size_t k = 0; reusable && k < first; k++) {
+    const RunPosition* old_offsets = Offsets(k);
+    RunPosition* offsets = view->AddSegment(Anchor(k));
+    for (int j = 0; j < new_n && reusable; j++) {
+      const int i = new_to_old[j];
+      if (i < 0 || SamePosition(old_offsets[i], old_at_lo[i])) {
+        offsets[j] = new_at_lo[j];
+      } else {
+        reusable = remap(i, old_offsets[i], &offsets[j]);
+      }
+    }
+    reusable = reusable && copy_selectors(k);
+  }
+
+  if (reusable && first < last) {
+    Slice start, limit;
+    if (first > 0) start = Anchor(first);
+    if (last < num_segments) limit = Anchor(last);
+    s = view->AppendSegments(first > 0 ? &start : nullptr,
+                             last < num_segments ? &limit : nullptr);
+    reusable = s.ok();
+  }
+
+  // The first entry after hi may have gained or lost a newer version
+  const bool recheck_after_hi = (lo != nullptr && last < num_segments);
+  const size_t after_hi = view->selectors_.size();
+  bool shadowed_after_hi = false;
+  if (reusable && recheck_after_hi) {
+    s = view->HasNewerVersion(Anchor(last), &shadowed_after_hi);
+    reusable = s.ok();
+  }
+
+  // Above hi every position is past the changed files.
+  for (size_t k = last; reusable && k < num_segments; k++) {
+    const RunPosition* old_offsets = Offsets(k);
+    RunPosition* offsets = view->AddSegment(Anchor(k));
+    for (int j = 0; j < new_n && reusable; j++) {
+      const int i = new_to_old[j];
+      if (i < 0) {
+        offsets[j].file_index = new_runs[j].files.size();
+      } else {
+        reusable = remap(i, old_offsets[i], &offsets[j]);
+      }
+    }
+    reusable = reusable && copy_selectors(k);
+  }
+  if (reusable && recheck_after_hi) {
+    uint8_t& selector = view->selectors_[after_hi];
+    selector = shadowed_after_hi ? (selector | kShadowedFlag)
+                                 : (selector & ~kShadowedFlag);
+  }
+
+  if (s.ok() && !reusable) {
+    // Only possible if this view does not describe its own version
+    s = Status::Corruption("REMIX view cannot be updated");
+  }
+  if (!s.ok()) {
+    view->version_ = nullptr;  // Leave the reference with the caller
+    delete view;
+    return s;
+  }
+  view->ShrinkToFit();
+  view->FitToBudget();
+  *result = view;
+  return s;
+}
+
+void RemixView::EncodeTo(std::string* dst) const {
+  const size_t start = dst->size();
+  PutFixed64(dst, kRemixMagicNumber);
+  PutFixed32(dst, kRemixFormatVersion);
+  PutVarint32(dst, segment_size_);
+  PutVarint32(dst, runs_.size());
+  for (const SortedRun& run : runs_) {
+    PutVarint32(dst, run.level);
+    PutVarint32(dst, run.files.size());
+    for (const FileMetaData* f : run.files) {
+      PutVarint64(dst, f->number);
+    }
+  }
+  PutVarint64(dst, NumSegments());
+  for (size_t i = 0; i < NumSegments(); i++) {
+    PutLengthPrefixedSlice(dst, Anchor(i));
+    const RunPosition* offsets = Offsets(i);
+    for (size_t r = 0; r < runs_.size(); r++) {
+      PutVarint32(dst, offsets[r].file_index);
+      PutVarint32(dst, offsets[r].entry_index);
+      PutVarint64(dst, offsets[r].block_offset);
+      PutVarint64(dst, offsets[r].block_size);
+    }
+    PutVarint32(dst, SelectorEnd(i) - SelectorBegin(i));
+    dst->append(reinterpret_cast<const char*>(&selectors_[SelectorBegin(i)]),
+                SelectorEnd(i) - SelectorBegin(i));
+  }
+  const uint32_t crc = crc32c::Value(dst->data() + start, dst->size() - start);
+  PutFixed32(dst, crc32c::Mask(crc));
+}
+
+Status RemixView::Decode(TableCache* table_cache,
+                         const InternalKeyComparator* icmp, Version* version,
+                         int segment_size, const Slice& contents,
+                         RemixView** result) {
+  *result = nullptr;
+  if (contents.size() < 12 + 4) {
+    return Status::Corruption("REMIX file too short");
+  }
+  const size_t body_size = contents.size() - 4;
+  const uint32_t expected = crc32c::Unmask(DecodeFixed32(contents.data() +
+                                                          body_size));
+  if (crc32c::Value(contents.data(), body_size) != expected) {
+    return Status::Corruption("REMIX file checksum mismatch");
+  }
+  Slice input(contents.data(), body_size);
+  if (DecodeFixed64(input.data()) != kRemixMagicNumber) {
+    return Status::Corruption("not a REMIX file (bad magic number)");
+  }
+  if (DecodeFixed32(input.data() + 8) != kRemixFormatVersion) {
+    return Status::NotSupported("unknown REMIX file format version");
+  }
+  input.remove_prefix(12);
+
+  uint32_t stored_segment_size, num_runs;
+  if (!GetVarint32(&input, &stored_segment_size) ||
+      !GetVarint32(&input, &num_runs)) {
+    return Status::Corruption("bad REMIX file header");
+  }
+  if (stored_segment_size != static_cast<uint32_t>(segment_size)) {
+    return Status::InvalidArgument("REMIX view has another segment size");
+  }
+
+  // The view is only usable if it indexes exactly the runs of "version"
+  std::vector<SortedRun> runs;
+  version->GetSortedRuns(&runs);
+  if (num_runs != runs.size()) {
+    return Status::InvalidArgument("REMIX view is stale");
+  }
+  for (const SortedRun& run : runs) {
+    uint32_t level, num_files;
+    if (!GetVarint32(&input, &level) || !GetVarint32(&input, &num_files)) {
+      return Status::Corruption("bad REMIX run list");
+    }
+    if (level != static_cast<uint32_t>(run.level) ||
+        num_files != run.files.size()) {
+      return Status::InvalidArgument("REMIX view is stale");
+    }
+    for (const FileMetaData* f : run.files) {
+      uint64_t number;
+      if (!GetVarint64(&input, &number)) {
+        return Status::Corruption("bad REMIX run list");
+      }
+      if (number != f->number) {
+        return Status::InvalidArgument("REMIX view is stale");
+      }
+    }
+  }
+
+  RemixView* view = new RemixView(table_cache, icmp, version, segment_size);
+  view->runs_.swap(runs);
+  const char* msg = nullptr;
+  uint64_t num_segments;
+  if (!GetVarint64(&input, &num_segments)) {
+    msg = "segment count";
+  } else if (num_runs > kMaxRuns) {
+    msg = "run count";
+  }
+  for (uint64_t i = 0; msg == nullptr && i < num_segments; i++) {
+    Slice anchor;
+    if (!GetLengthPrefixedSlice(&input, &anchor)) {
+      msg = "anchor key";
+      break;
+    }
+    RunPosition* offsets = view->AddSegment(anchor);
+    for (uint32_t r = 0; r < num_runs; r++) {
+      RunPosition& pos = offsets[r];
+      if (!GetVarint32(&input, &pos.file_index) ||
+          !GetVarint32(&input, &pos.entry_index) ||
+          !GetVarint64(&input, &pos.block_offset) ||
+          !GetVarint64(&input, &pos.block_size) ||
+          pos.file_index > view->runs_[r].files.size()) {
+        msg = "cursor offset";
+        break;
+      }
+    }
+    uint32_t num_selectors;
+    if (msg != nullptr || !GetVarint32(&input, &num_selectors) ||
+        num_selectors == 0 ||
+        num_selectors > static_cast<uint32_t>(kMaxSegmentSize) ||
+        num_selectors > input.size()) {
+      msg = (msg != nullptr) ? msg : "selector count";
+      break;
+    }
+    for (uint32_t j = 0; j < num_selectors; j++) {
+      const uint8_t selector = static_cast<uint8_t>(input[j]);
+      if ((selector & kRunMask) >= num_runs) {
+        msg = "run selector";
+        break;
+      }
+      view->selectors_.push_back(selector);
+    }
+    input.remove_prefix(num_selectors);
+  }
+  if (msg == nullptr && !input.empty()) {
+    msg = "trailing bytes";
+  }
+  if (msg != nullptr) {
+    view->version_ = nullptr;  // Leave the reference with the caller
+    delete view;
+    return Status::Corruption("bad REMIX file", msg);
+  }
+  view->ShrinkToFit();
+  *result = view;
+  return Status::OK();
+}
+
+void RemixView::SetVersion(Version* v) {
+  assert(Matches(v));
+  v->Ref();
+  if (version_ != nullptr) {
+    version_->Unref();
+  }
+  version_ = v;
+}
+
+bool RemixView::Matches(Version* v) const {
+  std::vector<SortedRun> runs;
+  v->GetSortedRuns(&runs);
+  if (runs.size() != runs_.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < runs.size(); i++) {
+    if (runs[i].level != runs_[i].level ||
+        runs[i].files.size() != runs_[i].files.size()) {
+      return false;
+    }
+    for (size_t j = 0; j < runs[i].files.size(); j++) {
+      if (runs[i].files[j]->number != runs_[i].files[j]->number) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+size_t RemixView::FindSegment(const Slice& ikey) const {
+  size_t left = 0;
+  size_t right = NumSegments();
+  if (use_prefixes_) {
+    // Narrow the search to the anchors sharing the prefix of ikey, using
+    // the prefix index instead of touching the anchor keys.
+    const uint64_t prefix = AnchorPrefix(ikey);
+    left = CountPrefixesBelow(prefix);
+    right = (prefix == ~uint64_t{0}) ? NumSegments()
+                                     : CountPrefixesBelow(prefix + 1);
+  }
+
+  // Binary search for the first anchor > ikey
+  while (left < right) {
+    size_t mid = (left + right) / 2;
+    if (icmp_->Compare(Anchor(mid), ikey) <= 0) {
+      left = mid + 1;
+    } else {
+      right = mid;
+    }
+  }
+  return (left == 0) ? 0 : left - 1;
+}
+
+std::string RemixView::DebugString() const {
+  std::string r;
+  r.append("runs: ");
+  AppendNumberTo(&r, runs_.size());
+  r.append(" segments: ");
+  AppendNumberTo(&r, NumSegments());
+  r.push_back('\n');
+  for (size_t i = 0; i < NumSegments(); i++) {
+    ParsedInternalKey ikey;
+    if (ParseInternalKey(Anchor(i), &ikey)) {
+      r.append(ikey.DebugString());
+    } else {
+      r.append("(bad)");
+      r.append(EscapeString(Anchor(i)));
+    }
+    r.append(" [");
+    AppendNumberTo(&r, SelectorEnd(i) - SelectorBegin(i));
+    r.append("]\n");
+  }
+  return r;
+}
+
+// Iterates the internal entries of a RemixView.  One RunCursor is kept per
+// run.  A positioned cursor rests on the first entry of its run at or
+// after the current entry, so moving either way only steps the cursor of
+// the run that the neighbouring selector names.  A cursor is positioned
+// the first time it is needed after a seek, from the cursor offsets of
+// the current segment.
+class RemixIterator : public Iterator {
+ public:
+  RemixIterator(RemixView* view, const ReadOptions& options)
+      : view_(view),
+        options_(options),
+        cursors_(view->runs_.size(), nullptr),
+        positioned_(view->runs_.size(), false),
+        segment_(0),
+        index_(0),
+        run_(-1),
+        scanning_(false),
+        seek_segment_(0),
+        steps_(0) {}
+
+  RemixIterator(const RemixIterator&) = delete;
+  RemixIterator& operator=(const RemixIterator&) = delete;
+
+  ~RemixIterator() override {
+    FinishScan();
+    for (RunCursor* cursor : cursors_) {
+      delete cursor;
+    }
+  }
+
+  bool Valid() const override { return run_ >= 0; }
+
+  void SeekToFirst() override {
+    FinishScan();
+    Reset(0, 0);
+  }
+
+  void SeekToLast() override {
+    FinishScan();
+    const size_t num_segments = view_->NumSegments();
+    if (num_segments == 0) {
+      Reset(0, 0);
+    } else {
+      Reset(num_segments - 1, view_->selectors_.size() - 1);
+    }
+  }
+
+  void Seek(const Slice& target) override {
+    FinishScan();
+    const size_t segment = view_->FindSegment(target);
+    Reset(segment, segment < view_->NumSegments()
+                       ? view_->SelectorBegin(segment)
+                       : 0);
+    while (Valid() && view_->icmp_->Compare(key(), target) < 0) {
+      Next();
+    }
+    if (view_->memory_budget_ > 0 && segment < view_->NumSegments()) {
+      scanning_ = true;
+      seek_segment_ = segment;
+      steps_ = 0;
+    }
+  }
+
+  void Next() override {
+    assert(Valid());
+    steps_++;
+    cursors_[run_]->Next();
+    if (++index_ == view_->SelectorEnd(segment_)) {
+      segment_++;
+    }
+    PositionCurrentRun();
+  }
+
+  void Prev() override {
+    assert(Valid());
+    steps_++;
+    if (index_ == 0) {
+      run_ = -1;
+      return;
+    }
+    if (index_ == view_->SelectorBegin(segment_)) {
+      segment_--;
+    }
+    index_--;
+    run_ = view_->selectors_[index_] & RemixView::kRunMask;
+    // The cursor rests on the first entry of its run after index_, and
+    // the entry just before that one is the entry at index_.
+    if (positioned_[run_] && cursors_[run_]->Valid()) {
+      cursors_[run_]->Prev();
+    } else {
+      positioned_[run_] = false;
+    }
+    PositionCurrentRun();
+  }
+
+  Slice key() const override {
+    assert(Valid());
+    return cursors_[run_]->key();
+  }
+
+  Slice value() const override {
+    assert(Valid());
+    return cursors_[run_]->value();
+  }
+
+  // Returns true iff the current entry is the newest entry of its user key
+  // and not a tombstone.
+  bool IsVisible() const {
+    assert(Valid());
+    return (view_->selectors_[index_] &
+            (RemixView::kDeletionFlag | RemixView::kShadowedFlag)) == 0;
+  }
+
+  Status status() const override {
+    if (!status_.ok()) {
+      return status_;
+    }
+    for (RunCursor* cursor : cursors_) {
+      if (cursor != nullptr && !cursor->status().ok()) {
+        return cursor->status();
+      }
+    }
+    return Status::OK();
+  }
+
+ private:
+  // Report the moves since the last Seek() for sizing future segments.
+  void FinishScan() {
+    if (scanning_) {
+      view_->RecordScan(seek_segment_, steps_);
+      scanning_ = false;
+    }
+  }
+
+  // Move to entry "index" of "segment", forgetting all cursor positions.
+  void Reset(size_t segment, size_t index) {
+    segment_ = segment;
+    index_ = index;
+    positioned_.assign(positioned_.size(), false);
+    PositionCurrentRun();
+  }
+
+  // Make run_ the run selected at index_ and make sure its cursor is
+  // positioned on the entry at index_.
+  void PositionCurrentRun() {
+    if (segment_ >= view_->NumSegments()) {
+      run_ = -1;
+      return;
+    }
+    run_ = view_->selectors_[index_] & RemixView::kRunMask;
+    if (!positioned_[run_]) {
+      if (cursors_[run_] == nullptr) {
+        cursors_[run_] = new RunCursor(view_->table_cache_, view_->icmp_,
+                                       &view_->runs_[run_], options_);
+      }
+      RunCursor* cursor = cursors_[run_];
+      cursor->SeekToPosition(view_->Offsets(segment_)[run_]);
+      // Skip the entries of the run that precede index_ in the segment
+      for (size_t i = view_->SelectorBegin(segment_);
+           i < index_ && cursor->Valid(); i++) {
+        if ((view_->selectors_[i] & RemixView::kRunMask) == run_) {
+          cursor->Next();
+        }
+      }
+      positioned_[run_] = true;
+    }
+    if (!cursors_[run_]->Valid()) {
+      if (status_.ok() && cursors_[run_]->status().ok()) {
+        status_ = Status::Corruption("REMIX view is out of sync with tables");
+      }
+      run_ = -1;
+    }
+  }
+
+  RemixView* const view_;
+  const ReadOptions options_;
+  std::vector<RunCursor*> cursors_;
+  std::vector<bool> positioned_;
+  size_t segment_;  // Segment holding index_
+  size_t index_;  // Index of the current entry in view_->selectors_
+  int run_;  // Run holding the current entry, or -1 if not valid
+  Status status_;
+
+  bool scanning_;  // Whether the moves since a Seek() are being counted
+  size_t seek_segment_;
+  uint64_t steps_;
+};
+
+// Iterates the user entries of a RemixView that are visible to a read
+// which sees every entry of the view.  Shadowed entries and tombstones are
+// skipped by their selector flags alone.
+class RemixScanIterator : public Iterator {
+ public:
+  RemixScanIterator(RemixView* view, const ReadOptions& options)
+      : table_cache_(view->table_cache_),
+        options_(options),
+        iter_(view, options),
+        value_resolved_(false) {}
+
+  RemixScanIterator(const RemixScanIterator&) = delete;
+  RemixScanIterator& operator=(const RemixScanIterator&) = delete;
+
+  ~RemixScanIterator() override = default;
+
+  bool Valid() const override { return iter_.Valid(); }
+
+  void SeekToFirst() override {
+    iter_.SeekToFirst();
+    SkipForward();
+  }
+
+  void SeekToLast() override {
+    iter_.SeekToLast();
+    SkipBackward();
+  }
+
+  void Seek(const Slice& target) override {
+    const InternalKey ikey(target, kMaxSequenceNumber, kValueTypeForSeek);
+    iter_.Seek(ikey.Encode());
+    SkipForward();
+  }
+
+  void Next() override {
+    iter_.Next();
+    SkipForward();
+  }
+
+  void Prev() override {
+    iter_.Prev();
+    SkipBackward();
+  }
+
+  Slice key() const override { return ExtractUserKey(iter_.key()); }
+
+  Slice value() const override {
+    const Slice ikey = iter_.key();
+    if (ExtractValueType(ikey) != kTypeBlobIndex) {
+      return iter_.value();
+    }
+    if (!value_resolved_) {
+      Status s = table_cache_->GetBlob(options_, iter_.value(), &value_);
+      if (!s.ok()) {
+        value_.clear();
+        if (status_.ok()) {
+          status_ = s;
+        }
+      }
+      value_resolved_ = true;
+    }
+    return value_;
+  }
+
+  Status status() const override {
+    return status_.ok() ? iter_.status() : status_;
+  }
+
+ private:
+  void SkipForward() {
+    value_resolved_ = false;
+    while (iter_.Valid() && !iter_.IsVisible()) {
+      iter_.Next();
+    }
+  }
+
+  void SkipBackward() {
+    value_resolved_ = false;
+    while (iter_.Valid() && !iter_.IsVisible()) {
+      iter_.Prev();
+    }
+  }
+
+  TableCache* const table_cache_;
+  const ReadOptions options_;
+  RemixIterator iter_;
+  // Value of the current entry if it is kept in a blob file
+  mutable std::string value_;
+  mutable bool value_resolved_;
+  mutable Status status_;
+};
+
+Iterator* RemixView::NewIterator(const ReadOptions& options) {
+  return new RemixIterator(this, options);
+}
+
+Iterator* RemixView::NewScanIterator(const ReadOptions& options) {
+  return new RemixScanIterator(this, options);
+}
+
+}  // namespace leveldb
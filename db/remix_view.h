@@ -0,0 +1,256 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+//
+// A RemixView is a REMIX sorted view over the sorted runs (level-0 files
+// and levels > 0) of one Version.  The internal entries of all runs are
+// divided into segments of at most segment_size() entries.  Each segment
+// records its first key (the anchor), the position of every run at the
+// anchor, and one run selector per entry naming the run that holds the
+// entry.  A seek binary-searches the anchors and then replays the
+// selectors, so iterating the view never compares keys across runs.
+// Selectors also flag tombstones and entries that are older versions of
+// the preceding user key, which lets scans skip them without parsing.
+
+#ifndef STORAGE_LEVELDB_DB_REMIX_VIEW_H_
+#define STORAGE_LEVELDB_DB_REMIX_VIEW_H_
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "db/dbformat.h"
+#include "db/run_cursor.h"
+#include "db/version_set.h"
+
+namespace leveldb {
+
+class Iterator;
+class TableCache;
+
+class RemixView {
+ public:
+  // Build a view of "version" by merging its sorted runs once.  Up to
+  // "threads" threads merge disjoint key ranges split at table file
+  // boundaries.  The caller must hold a reference to "version"; on success
+  // the view takes over that reference, otherwise it stays with the caller.
+  static Status Build(TableCache* table_cache,
+                      const InternalKeyComparator* icmp, Version* version,
+                      int segment_size, int threads, RemixView** result);
+
+  // Decode a view of "version" that was persisted by EncodeTo().  Returns a
+  // non-OK status if "contents" is corrupted or describes other sorted runs
+  // or another segment size.  Takes over the caller's reference to
+  // "version" on success, like Build().
+  static Status Decode(TableCache* table_cache,
+                       const InternalKeyComparator* icmp, Version* version,
+                       int segment_size, const Slice& contents,
+                       RemixView** result);
+
+  // Build a view of "version" from this view.  Only the segments that
+  // overlap the key range of the table files added or removed since this
+  // view's version are rebuilt; the other segments are reused with their
+  // run selectors and cursor offsets remapped to the new sorted runs.
+  // Takes over the caller's reference to "version" on success, like Build().
+  Status Update(Version* version, RemixView** result) const;
+
+  RemixView(const RemixView&) = delete;
+  RemixView& operator=(const RemixView&) = delete;
+
+  // Append the persistent form of the view to *dst.
+  void EncodeTo(std::string* dst) const;
+
+  // Returns true iff the view indexes exactly the table files of "v".
+  bool Matches(Version* v) const;
+
+  // Make "v", which holds the same table files, the version of the view,
+  // so that edits that do not change the files, like recording a REMIX
+  // file, keep the view current.
+  // REQUIRES: Matches(v), and the DB mutex is held.
+  void SetVersion(Version* v);
+
+  // Size the segments that views derived from this one by Update() rebuild
+  // so that the view takes about "bytes" of memory, giving the key ranges
+  // that see the most seeks per scanned entry the shortest segments.  Zero
+  // keeps every segment at segment_size() entries.  If the view is already
+  // larger, its shortest segments are merged until it fits; returns true
+  // iff that changed the view.
+  // REQUIRES: no iterator over the view exists yet.
+  bool SetMemoryBudget(size_t bytes);
+
+  // Increase reference count.
+  void Ref() { ++refs_; }
+
+  // Drop reference count.  Delete if no more references exist.
+  // REQUIRES: the DB mutex is held, since the view releases its Version.
+  void Unref() {
+    --refs_;
+    assert(refs_ >= 0);
+    if (refs_ <= 0) {
+      delete this;
+    }
+  }
+
+  int segment_size() const { return segment_size_; }
+  Version* version() const { return version_; }
+  size_t NumSegments() const { return anchor_starts_.size(); }
+
+  // Returns the number of bytes of memory held by the view.
+  size_t ApproximateMemoryUsage() const;
+
+  // Return an iterator over the internal entries of the view.  The view
+  // must outlive the iterator.
+  Iterator* NewIterator(const ReadOptions& options);
+
+  // Return an iterator over the user keys of the view whose newest entry
+  // is a value, as seen by a read that sees every entry of the view.
+  // Next() and Prev() skip the other entries by their selector flags
+  // without comparing or parsing keys.  The view must outlive the iterator.
+  Iterator* NewScanIterator(const ReadOptions& options);
+
+  // Return a human readable string listing the anchors of the view.
+  std::string DebugString() const;
+
+ private:
+  friend class RemixIterator;
+  friend class RemixScanIterator;
+
+  // Run selectors are stored in one byte each: the run index in the low
+  // bits and two flags describing the entry.
+  static const size_t kMaxRuns = 64;
+  static const uint8_t kRunMask = 0x3f;
+  static const uint8_t kDeletionFlag = 0x40;  // Entry is a tombstone
+  static const uint8_t kShadowedFlag = 0x80;  // Older version of a user key
+
+  // Upper bound on the entries of one segment
+  static const int kMaxSegmentSize = 1 << 16;
+
+  // Prefixes per node of prefix_index_, which fill one cache line
+  static const size_t kPrefixFanout = 8;
+
+  // Seeks are sampled for this many key ranges of equally many segments.
+  static const int kHeatRanges = 64;
+
+  struct HeatRange {
+    std::atomic<uint32_t> seeks;
+    std::atomic<uint64_t> steps;  // Entries visited after those seeks
+  };
+
+  RemixView(TableCache* table_cache, const InternalKeyComparator* icmp,
+            Version* version, int segment_size);
+  ~RemixView();  // Private since only Unref() should be used to delete it
+
+  // Return the index of the last segment whose anchor is <= ikey, or 0 if
+  // there is none.
+  size_t FindSegment(const Slice& ikey) const;
+
+  Slice Anchor(size_t segment) const {
+    const size_t limit = (segment + 1 < anchor_starts_.size())
+                             ? anchor_starts_[segment + 1]
+                             : anchor_data_.size();
+    return Slice(anchor_data_.data() + anchor_starts_[segment],
+                 limit - anchor_starts_[segment]);
+  }
+
+  // Selectors of "segment" are selectors_[SelectorBegin, SelectorEnd)
+  size_t SelectorBegin(size_t segment) const {
+    return selector_starts_[segment];
+  }
+  size_t SelectorEnd(size_t segment) const {
+    return (segment + 1 < selector_starts_.size())
+               ? selector_starts_[segment + 1]
+               : selectors_.size();
+  }
+
+  // Position of every run at the anchor of "segment"
+  const RunPosition* Offsets(size_t segment) const {
+    return &offsets_[segment * runs_.size()];
+  }
+
+  // Start a new segment at "anchor" and return its run positions, which
+  // are valid until the next call.
+  RunPosition* AddSegment(const Slice& anchor);
+
+  // Release the spare capacity left by building the segments, and build
+  // prefix_index_ over the final anchors.
+  void ShrinkToFit();
+
+  // Returns the number of anchor prefixes less than "prefix", searching
+  // prefix_index_ from its root down to anchor_prefixes_.
+  size_t CountPrefixesBelow(uint64_t prefix) const;
+
+  // Merge adjacent segments, shortest first, until the view fits in
+  // memory_budget_ or no more segments can be merged.  Returns true iff
+  // any segment was merged.
+  bool FitToBudget();
+
+  // Merge the runs from "start" (nullptr for the first entry) up to but
+  // excluding "limit" (nullptr for no limit) into new segments.
+  Status AppendSegments(const Slice* start, const Slice* limit);
+
+  // Sets *result to whether some run holds a newer entry for the user key
+  // of "ikey", i.e. whether an entry at "ikey" is shadowed.
+  Status HasNewerVersion(const Slice& ikey, bool* result) const;
+
+  // Returns the number of entries per segment planned for the key range
+  // holding "ikey".
+  size_t SegmentSizeAt(const Slice& ikey) const;
+
+  // Set the segment sizes of "next", a view of other runs derived from
+  // this one, from the seeks sampled on this view and the memory budget.
+  void PlanSegments(RemixView* next) const;
+
+  // Account for a seek into "segment" followed by "steps" moves.
+  void RecordScan(size_t segment, uint64_t steps) {
+    HeatRange& range = heat_[segment * kHeatRanges / NumSegments()];
+    range.seeks.fetch_add(1, std::memory_order_relaxed);
+    range.steps.fetch_add(steps, std::memory_order_relaxed);
+  }
+
+  // Like AppendSegments(nullptr, nullptr), but merges the key ranges
+  // between the sorted "bounds" on separate threads.
+  Status AppendPartitions(const std::vector<Slice>& bounds);
+
+  // Append the segments of "other", which covers the same runs and only
+  // keys after those of this view.
+  void Append(const RemixView& other);
+
+  TableCache* const table_cache_;
+  const InternalKeyComparator* const icmp_;
+  Version* version_;
+  const int segment_size_;
+  int refs_;
+
+  // If the user keys are ordered bytewise, anchor_prefixes_ holds the first
+  // bytes of every anchor so that FindSegment() compares full anchors only
+  // when the prefixes tie.  prefix_index_ is a static B-tree over them:
+  // level i holds every kPrefixFanout-th prefix of level i - 1, level 0
+  // being anchor_prefixes_, so a search reads one node of kPrefixFanout
+  // adjacent prefixes per level instead of probing all over the array.
+  const bool use_prefixes_;
+
+  size_t memory_budget_;
+  HeatRange heat_[kHeatRanges];
+
+  // Segments of key ranges starting at plan_starts_[i] hold plan_sizes_[i]
+  // entries; without a plan they hold segment_size_ entries.
+  std::vector<std::string> plan_starts_;
+  std::vector<size_t> plan_sizes_;
+
+  std::vector<SortedRun> runs_;
+
+  // Segments are kept in flat arrays instead of one object per segment,
+  // so that the view costs a few bytes per entry.
+  std::string anchor_data_;  // Anchor keys of all segments, back to back
+  std::vector<size_t> anchor_starts_;
+  std::vector<uint64_t> anchor_prefixes_;
+  std::vector<std::vector<uint64_t>> prefix_index_;  // Levels 1 and up
+  std::vector<size_t> selector_starts_;
+  std::vector<uint8_t> selectors_;  // Run holding each entry
+  std::vector<RunPosition> offsets_;  // runs_.size() entries per segment
+};
+
+}  // namespace leveldb
+
+#endif  // STORAGE_LEVELDB_DB_REMIX_VIEW_H_
@@ -24,6 +24,7 @@
 //   Store per-table metadata (smallest, largest, largest-seq#, ...)
 //   in the table's meta section to speed up ScanTable.
 
+#include "db/blob_file.h"
 #include "db/builder.h"
 #include "db/db_impl.h"
 #include "db/dbformat.h"
@@ -48,7 +49,7 @@ class Repairer {
       : dbname_(dbname),
         env_(options.env),
         icmp_(options.comparator),
-        ipolicy_(options.filter_policy),
+        ipolicy_(options.filter_policy, options.prefix_extractor),
         options_(SanitizeOptions(dbname, &icmp_, &ipolicy_, options)),
         owns_info_log_(options_.info_log != options.info_log),
         owns_cache_(options_.block_cache != options.block_cache),
@@ -258,6 +259,7 @@ class Repairer {
     Iterator* iter = NewTableIterator(t.meta);
     bool empty = true;
     ParsedInternalKey parsed;
+    std::set<uint64_t> blob_files;
     t.max_sequence = 0;
     for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
       Slice key = iter->key();
@@ -276,7 +278,12 @@ class Repairer {
       if (parsed.sequence > t.max_sequence) {
         t.max_sequence = parsed.sequence;
       }
+      BlobIndex blob;
+      if (parsed.type == kTypeBlobIndex && blob.DecodeFrom(iter->value())) {
+        blob_files.insert(blob.file_number);
+      }
     }
+    t.meta.blob_files.assign(blob_files.begin(), blob_files.end());
     if (!iter->status().ok()) {
       status = iter->status();
     }
@@ -368,8 +375,7 @@ class Repairer {
     for (size_t i = 0; i < tables_.size(); i++) {
       // TODO(opt): separate out into multiple levels
       const TableInfo& t = tables_[i];
-      edit_.AddFile(0, t.meta.number, t.meta.file_size, t.meta.smallest,
-                    t.meta.largest);
+      edit_.AddFile(0, t.meta);
     }
 
     // std::fprintf(stderr,
@@ -0,0 +1,311 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "db/run_cursor.h"
+
+#include "db/table_cache.h"
+#include "leveldb/iterator.h"
+#include "leveldb/table.h"
+#include "table/format.h"
+
+namespace leveldb {
+
+RunCursor::RunCursor(TableCache* table_cache, const InternalKeyComparator* icmp,
+                     const SortedRun* run, const ReadOptions& options)
+    : table_cache_(table_cache),
+      icmp_(icmp),
+      run_(run),
+      options_(options),
+      file_index_(run->files.size()),
+      table_(nullptr),
+      table_handle_(nullptr),
+      index_iter_(nullptr),
+      index_synced_(false),
+      data_iter_(nullptr),
+      block_offset_(0),
+      block_size_(0),
+      entry_index_(0) {}
+
+RunCursor::~RunCursor() {
+  ClearDataBlock();
+  CloseFile();
+}
+
+bool RunCursor::Valid() const {
+  return data_iter_ != nullptr && data_iter_->Valid();
+}
+
+Slice RunCursor::key() const {
+  assert(Valid());
+  return data_iter_->key();
+}
+
+Slice RunCursor::value() const {
+  assert(Valid());
+  return data_iter_->value();
+}
+
+Status RunCursor::status() const {
+  if (!status_.ok()) {
+    return status_;
+  } else if (data_iter_ != nullptr && !data_iter_->status().ok()) {
+    return data_iter_->status();
+  } else if (index_iter_ != nullptr && !index_iter_->status().ok()) {
+    return index_iter_->status();
+  }
+  return Status::OK();
+}
+
+// Make "file_index" the current file.  Returns false if it is past the
+// end of the run or the table could not be opened.
+bool RunCursor::OpenFile(uint32_t file_index) {
+  if (file_index == file_index_ && table_ != nullptr) {
+    return true;
+  }
+  ClearDataBlock();
+  CloseFile();
+  if (file_index >= run_->files.size()) {
+    return false;
+  }
+  file_index_ = file_index;
+  const FileMetaData* f = run_->files[file_index];
+  Status s = table_cache_->GetTable(f->number, f->file_size, &table_,
+                                    &table_handle_);
+  if (!s.ok()) {
+    SaveError(s);
+    return false;
+  }
+  index_iter_ = table_->NewIndexIterator();
+  index_synced_ = false;
+  return true;
+}
+
+void RunCursor::CloseFile() {
+  delete index_iter_;
+  index_iter_ = nullptr;
+  if (table_handle_ != nullptr) {
+    table_cache_->Release(table_handle_);
+    table_handle_ = nullptr;
+  }
+  table_ = nullptr;
+  file_index_ = run_->files.size();
+}
+
+void RunCursor::SetDataBlock(const Slice& handle_value) {
+  ClearDataBlock();
+  BlockHandle handle;
+  Slice input = handle_value;
+  Status s = handle.DecodeFrom(&input);
+  if (!s.ok()) {
+    SaveError(s);
+    return;
+  }
+  block_offset_ = handle.offset();
+  block_size_ = handle.size();
+  data_iter_ = Table::BlockReader(table_, options_, handle_value);
+}
+
+void RunCursor::ClearDataBlock() {
+  if (data_iter_ != nullptr) {
+    SaveError(data_iter_->status());
+    delete data_iter_;
+    data_iter_ = nullptr;
+  }
+}
+
+// Position index_iter_ at the current data block.  Clobbers the position
+// of data_iter_, so only called once the block has been exhausted.
+void RunCursor::SyncIndex() {
+  if (index_synced_) {
+    return;
+  }
+  index_synced_ = true;
+  data_iter_->SeekToFirst();
+  if (data_iter_->Valid()) {
+    // Every index key separates its block from the next one, so any key
+    // of the block lands on the block's own index entry.
+    index_iter_->Seek(data_iter_->key());
+    return;
+  }
+  for (index_iter_->SeekToFirst(); index_iter_->Valid(); index_iter_->Next()) {
+    BlockHandle handle;
+    Slice input = index_iter_->value();
+    if (handle.DecodeFrom(&input).ok() && handle.offset() == block_offset_) {
+      break;
+    }
+  }
+}
+
+void RunCursor::SkipEmptyDataBlocksForward() {
+  while (data_iter_ == nullptr || !data_iter_->Valid()) {
+    if (file_index_ >= run_->files.size()) {
+      ClearDataBlock();
+      return;
+    }
+    if (table_ != nullptr) {
+      if (data_iter_ != nullptr) {
+        SyncIndex();
+        index_iter_->Next();
+      }
+      if (index_iter_->Valid()) {
+        SetDataBlock(index_iter_->value());
+        index_synced_ = true;
+        entry_index_ = 0;
+        if (data_iter_ != nullptr) {
+          data_iter_->SeekToFirst();
+          continue;
+        }
+      }
+    }
+    // Move to the first block of the next file
+    if (OpenFile(file_index_ + 1)) {
+      index_iter_->SeekToFirst();
+    }
+  }
+}
+
+void RunCursor::SkipEmptyDataBlocksBackward() {
+  while (data_iter_ == nullptr || !data_iter_->Valid()) {
+    if (file_index_ >= run_->files.size()) {
+      ClearDataBlock();
+      return;
+    }
+    if (table_ != nullptr) {
+      if (data_iter_ != nullptr) {
+        SyncIndex();
+        index_iter_->Prev();
+      }
+      if (index_iter_->Valid()) {
+        SetDataBlock(index_iter_->value());
+        index_synced_ = true;
+        if (data_iter_ != nullptr) {
+          uint32_t n = 0;
+          for (data_iter_->SeekToFirst(); data_iter_->Valid();
+               data_iter_->Next()) {
+            n++;
+          }
+          data_iter_->SeekToLast();
+          entry_index_ = (n > 0) ? n - 1 : 0;
+          continue;
+        }
+      }
+    }
+    // Move to the last block of the previous file
+    if (file_index_ == 0) {
+      CloseFile();
+    } else {
+      if (OpenFile(file_index_ - 1)) {
+        index_iter_->SeekToLast();
+      }
+    }
+  }
+}
+
+void RunCursor::SeekToFirst() {
+  ClearDataBlock();
+  if (OpenFile(0)) {
+    index_iter_->SeekToFirst();
+  }
+  SkipEmptyDataBlocksForward();
+}
+
+void RunCursor::SeekToLast() {
+  ClearDataBlock();
+  if (run_->files.empty()) {
+    return;
+  }
+  if (OpenFile(run_->files.size() - 1)) {
+    index_iter_->SeekToLast();
+  }
+  SkipEmptyDataBlocksBackward();
+}
+
+void RunCursor::Seek(const Slice& target) {
+  ClearDataBlock();
+  uint32_t file_index = 0;
+  if (run_->level > 0) {
+    file_index = FindFile(*icmp_, run_->files, target);
+  }
+  if (OpenFile(file_index)) {
+    index_iter_->Seek(target);
+    if (index_iter_->Valid()) {
+      SetDataBlock(index_iter_->value());
+      index_synced_ = true;
+      entry_index_ = 0;
+      if (data_iter_ != nullptr) {
+        // Count entries on the way so that the position stays known
+        for (data_iter_->SeekToFirst();
+             data_iter_->Valid() &&
+             icmp_->Compare(data_iter_->key(), target) < 0;
+             data_iter_->Next()) {
+          entry_index_++;
+        }
+      }
+    }
+  }
+  SkipEmptyDataBlocksForward();
+}
+
+void RunCursor::SeekToPosition(const RunPosition& pos) {
+  if (pos.file_index >= run_->files.size()) {
+    ClearDataBlock();
+    CloseFile();
+    return;
+  }
+  if (pos.file_index != file_index_ || data_iter_ == nullptr ||
+      pos.block_offset != block_offset_) {
+    ClearDataBlock();
+    if (!OpenFile(pos.file_index)) {
+      return;
+    }
+    BlockHandle handle;
+    handle.set_offset(pos.block_offset);
+    handle.set_size(pos.block_size);
+    std::string handle_value;
+    handle.EncodeTo(&handle_value);
+    SetDataBlock(handle_value);
+    index_synced_ = false;
+    if (data_iter_ == nullptr) {
+      return;
+    }
+  }
+  data_iter_->SeekToFirst();
+  for (uint32_t i = 0; i < pos.entry_index && data_iter_->Valid(); i++) {
+    data_iter_->Next();
+  }
+  entry_index_ = pos.entry_index;
+  if (!data_iter_->Valid() && data_iter_->status().ok()) {
+    SaveError(Status::Corruption("bad position in sorted run"));
+  }
+}
+
+void RunCursor::Next() {
+  assert(Valid());
+  data_iter_->Next();
+  entry_index_++;
+  SkipEmptyDataBlocksForward();
+}
+
+void RunCursor::Prev() {
+  assert(Valid());
+  data_iter_->Prev();
+  entry_index_--;
+  SkipEmptyDataBlocksBackward();
+}
+
+void RunCursor::GetPosition(RunPosition* pos) const {
+  if (Valid()) {
+    pos->file_index = file_index_;
+    pos->block_offset = block_offset_;
+    pos->block_size = block_size_;
+    pos->entry_index = entry_index_;
+  } else {
+    pos->file_index = run_->files.size();
+    pos->block_offset = 0;
+    pos->block_size = 0;
+    pos->entry_index = 0;
+  }
+}
+
+}  // namespace leveldb
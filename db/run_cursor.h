@@ -0,0 +1,106 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#ifndef STORAGE_LEVELDB_DB_RUN_CURSOR_H_
+#define STORAGE_LEVELDB_DB_RUN_CURSOR_H_
+
+#include <cstdint>
+
+#include "db/dbformat.h"
+#include "db/version_set.h"
+#include "leveldb/cache.h"
+#include "leveldb/options.h"
+
+namespace leveldb {
+
+class Iterator;
+class Table;
+class TableCache;
+
+// The physical location of an entry inside a sorted run: the index of
+// the table file within the run, the extent of the data block holding the
+// entry, and the index of the entry within that block.  A position with
+// file_index == run.files.size() is past the end of the run.
+struct RunPosition {
+  RunPosition() : file_index(0), entry_index(0), block_offset(0),
+                  block_size(0) {}
+
+  uint32_t file_index;
+  uint32_t entry_index;
+  uint64_t block_offset;
+  uint64_t block_size;
+};
+
+// A RunCursor walks the internal entries of one sorted run.  Unlike the
+// concatenating iterator built by Version::AddIterators(), it can report
+// its physical position and jump back to a recorded position without
+// comparing any keys, which is what REMIX segments store per run.
+//
+// The SortedRun must remain live while the cursor is in use.
+class RunCursor {
+ public:
+  RunCursor(TableCache* table_cache, const InternalKeyComparator* icmp,
+            const SortedRun* run, const ReadOptions& options);
+
+  RunCursor(const RunCursor&) = delete;
+  RunCursor& operator=(const RunCursor&) = delete;
+
+  ~RunCursor();
+
+  bool Valid() const;
+  void SeekToFirst();
+  void SeekToLast();
+  // Position at the first entry at or past internal key "target".
+  void Seek(const Slice& target);
+  // Position at a location previously returned by GetPosition().
+  void SeekToPosition(const RunPosition& pos);
+  void Next();
+  void Prev();
+
+  // REQUIRES: Valid()
+  Slice key() const;
+  Slice value() const;
+
+  Status status() const;
+
+  // Store the current location in "*pos".  If the cursor is not valid,
+  // stores the past-the-end position.
+  void GetPosition(RunPosition* pos) const;
+
+ private:
+  void SaveError(const Status& s) {
+    if (status_.ok() && !s.ok()) status_ = s;
+  }
+  bool OpenFile(uint32_t file_index);
+  void CloseFile();
+  void SetDataBlock(const Slice& handle_value);
+  void ClearDataBlock();
+  void SyncIndex();
+  void SkipEmptyDataBlocksForward();
+  void SkipEmptyDataBlocksBackward();
+
+  TableCache* const table_cache_;
+  const InternalKeyComparator* const icmp_;
+  const SortedRun* const run_;
+  const ReadOptions options_;
+
+  // Currently open file, or file_index_ == run_->files.size() if none
+  uint32_t file_index_;
+  Table* table_;
+  Cache::Handle* table_handle_;
+  Iterator* index_iter_;
+  // True iff index_iter_ is positioned at the current data block.  After
+  // SeekToPosition() the index is positioned lazily on a block change.
+  bool index_synced_;
+
+  Iterator* data_iter_;
+  uint64_t block_offset_;
+  uint64_t block_size_;
+  uint32_t entry_index_;
+  Status status_;
+};
+
+}  // namespace leveldb
+
+#endif  // STORAGE_LEVELDB_DB_RUN_CURSOR_H_
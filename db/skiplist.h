@@ -8,10 +8,12 @@
 // Thread safety
 // -------------
 //
-// Writes require external synchronization, most likely a mutex.
-// Reads require a guarantee that the SkipList will not be destroyed
-// while the read is in progress.  Apart from that, reads progress
-// without any internal locking or synchronization.
+// Writes require external synchronization, most likely a mutex, except
+// that InsertConcurrently() may be called by several threads at once as
+// long as no Insert() runs at the same time.  Reads require a guarantee
+// that the SkipList will not be destroyed while the read is in progress.
+// Apart from that, reads progress without any internal locking or
+// synchronization.
 //
 // Invariants:
 //
@@ -30,10 +32,11 @@
 #include <atomic>
 #include <cassert>
 #include <cstdlib>
+#include <functional>
+#include <thread>
 
 #include "util/arena.h"
 #include "util/random.h"
-#include "leveldb/RemixHelper.h"
 
 namespace leveldb {
 
@@ -55,11 +58,16 @@ class SkipList {
   // REQUIRES: nothing that compares equal to key is currently in the list.
   void Insert(const Key& key);
 
+  // Like Insert(), but safe to call from several threads at once.  Nodes
+  // are linked with compare-and-swap, so inserts into different parts of
+  // the list do not wait for each other.
+  void InsertConcurrently(const Key& key);
+
   // Returns true iff an entry that compares equal to key is in the list.
   bool Contains(const Key& key) const;
 
   // Iteration over the contents of a skip list
-  class Iterator : public Remix_Helper {
+  class Iterator {
    public:
     // Initialize an iterator over the specified list.
     // The returned iterator is not valid.
@@ -74,7 +82,7 @@ class SkipList {
 
     // Advances to the next position.
     // REQUIRES: Valid()
-    int Next();
+    void Next();
 
     // Advances to the previous position.
     // REQUIRES: Valid()
@@ -85,7 +93,7 @@ class SkipList {
 
     // Position at the first entry in list.
     // Final state of iterator is Valid() iff list is not empty.
-    int SeekToFirst();
+    void SeekToFirst();
 
     // Position at the last entry in list.
     // Final state of iterator is Valid() iff list is not empty.
@@ -105,7 +113,9 @@ class SkipList {
   }
 
   Node* NewNode(const Key& key, int height);
+  Node* NewNodeConcurrently(const Key& key, int height);
   int RandomHeight();
+  int ConcurrentRandomHeight();
   bool Equal(const Key& a, const Key& b) const { return (compare_(a, b) == 0); }
 
   // Return true if key is greater than the data stored in "n"
@@ -135,6 +145,11 @@ class SkipList {
   // Return head_ if list is empty.
   Node* FindLast() const;
 
+  // Starting at "before", whose key is < key, find the nodes at "level"
+  // between which key belongs.
+  void FindSpliceForLevel(const Key& key, Node* before, int level,
+                          Node** out_prev, Node** out_next) const;
+
   // Immutable after construction
   Comparator const compare_;
   Arena* const arena_;  // Arena used for allocations of nodes
@@ -181,6 +196,15 @@ struct SkipList<Key, Comparator>::Node {
     next_[n].store(x, std::memory_order_relaxed);
   }
 
+  // Link "x" at level n iff the link still points to "expected".  Like
+  // SetNext(), publishes a fully initialized "x" on success.
+  bool CASNext(int n, Node* expected, Node* x) {
+    assert(n >= 0);
+    return next_[n].compare_exchange_strong(expected, x,
+                                            std::memory_order_release,
+                                            std::memory_order_relaxed);
+  }
+
  private:
   // Array of length equal to the node height.  next_[0] is lowest level link.
   std::atomic<Node*> next_[1];
@@ -194,6 +218,15 @@ typename SkipList<Key, Comparator>::Node* SkipList<Key, Comparator>::NewNode(
   // new 强制使用指定内存进行对象构造
   return new (node_memory) Node(key);
 }
+
+template <typename Key, class Comparator>
+typename SkipList<Key, Comparator>::Node*
+SkipList<Key, Comparator>::NewNodeConcurrently(const Key& key, int height) {
+  char* const node_memory = arena_->AllocateConcurrently(
+      sizeof(Node) + sizeof(std::atomic<Node*>) * (height - 1));
+  return new (node_memory) Node(key);
+}
+
 // 返回给定跳表的迭代器
 template <typename Key, class Comparator>
 inline SkipList<Key, Comparator>::Iterator::Iterator(const SkipList* list) {
@@ -213,10 +246,9 @@ inline const Key& SkipList<Key, Comparator>::Iterator::key() const {
 }
 
 template <typename Key, class Comparator>
-inline int SkipList<Key, Comparator>::Iterator::Next() {
+inline void SkipList<Key, Comparator>::Iterator::Next() {
   assert(Valid());
   node_ = node_->Next(0);
-  return 0;
 }
 
 template <typename Key, class Comparator>
@@ -240,9 +272,8 @@ inline void SkipList<Key, Comparator>::Iterator::Seek(const Key& target) {
 }
 
 template <typename Key, class Comparator>
-inline int SkipList<Key, Comparator>::Iterator::SeekToFirst() {
+inline void SkipList<Key, Comparator>::Iterator::SeekToFirst() {
   node_ = list_->head_->Next(0);
-  return 0;
 }
 
 template <typename Key, class Comparator>
@@ -270,6 +301,20 @@ int SkipList<Key, Comparator>::RandomHeight() {
   return height;
 }
 
+template <typename Key, class Comparator>
+int SkipList<Key, Comparator>::ConcurrentRandomHeight() {
+  // rnd_ belongs to Insert(), so concurrent inserts draw from a generator
+  // of their own thread.
+  static thread_local Random rnd(static_cast<uint32_t>(
+      std::hash<std::thread::id>()(std::this_thread::get_id())));
+  static const unsigned int kBranching = 4;
+  int height = 1;
+  while (height < kMaxHeight && rnd.OneIn(kBranching)) {
+    height++;
+  }
+  return height;
+}
+
 template <typename Key, class Comparator>
 bool SkipList<Key, Comparator>::KeyIsAfterNode(const Key& key, Node* n) const {
   // null n is considered infinite
@@ -345,6 +390,23 @@ typename SkipList<Key, Comparator>::Node* SkipList<Key, Comparator>::FindLast()
   }
 }
 
+template <typename Key, class Comparator>
+void SkipList<Key, Comparator>::FindSpliceForLevel(const Key& key,
+                                                   Node* before, int level,
+                                                   Node** out_prev,
+                                                   Node** out_next) const {
+  while (true) {
+    Node* next = before->Next(level);
+    if (KeyIsAfterNode(key, next)) {
+      before = next;
+    } else {
+      *out_prev = before;
+      *out_next = next;
+      return;
+    }
+  }
+}
+
 template <typename Key, class Comparator>
 SkipList<Key, Comparator>::SkipList(Comparator cmp, Arena* arena)
     : compare_(cmp),
@@ -399,6 +461,45 @@ void SkipList<Key, Comparator>::Insert(const Key& key) {
     prev[i]->SetNext(i, x);
   }
 }
+template <typename Key, class Comparator>
+void SkipList<Key, Comparator>::InsertConcurrently(const Key& key) {
+  const int height = ConcurrentRandomHeight();
+
+  // Raise max_height_ first, so that the search below covers every level
+  // of the new node.  Readers cope with the new levels of head_ still being
+  // nullptr, as in Insert().
+  int max_height = GetMaxHeight();
+  while (height > max_height) {
+    if (max_height_.compare_exchange_weak(max_height, height,
+                                          std::memory_order_relaxed)) {
+      max_height = height;
+      break;
+    }
+  }
+
+  Node* prev[kMaxHeight];
+  Node* next[kMaxHeight];
+  Node* before = head_;
+  for (int level = max_height - 1; level >= 0; level--) {
+    FindSpliceForLevel(key, before, level, &prev[level], &next[level]);
+    before = prev[level];
+  }
+  assert(next[0] == nullptr || !Equal(key, next[0]->key));
+
+  // Link the node bottom-up, so that it is reachable at level 0 as soon as
+  // it is reachable at all.  If another insert changed a link since the
+  // search, search that level again from the stale predecessor, which
+  // still sorts before key since nodes are never removed.
+  Node* x = NewNodeConcurrently(key, height);
+  for (int i = 0; i < height; i++) {
+    while (true) {
+      x->NoBarrier_SetNext(i, next[i]);
+      if (prev[i]->CASNext(i, next[i], x)) break;
+      FindSpliceForLevel(key, prev[i], i, &prev[i], &next[i]);
+    }
+  }
+}
+
 // 当且仅当跳表中有和给定 key 判等的节点才返回真.
 template <typename Key, class Comparator>
 bool SkipList<Key, Comparator>::Contains(const Key& key) const {
@@ -6,6 +6,8 @@
 
 #include <atomic>
 #include <set>
+#include <thread>
+#include <vector>
 
 #include "gtest/gtest.h"
 #include "leveldb/env.h"
@@ -281,6 +283,55 @@ class ConcurrentTest {
   }
 };
 
+// Several threads insert interleaved keys while a reader checks that every
+// scan sees a sorted list.
+TEST(SkipTest, ConcurrentInserts) {
+  static const int kThreads = 4;
+  static const int kPerThread = 20000;
+  Arena arena;
+  Comparator cmp;
+  SkipList<Key, Comparator> list(cmp, &arena);
+
+  std::atomic<bool> done(false);
+  std::thread reader([&list, &done]() {
+    while (!done.load(std::memory_order_acquire)) {
+      SkipList<Key, Comparator>::Iterator iter(&list);
+      iter.SeekToFirst();
+      if (!iter.Valid()) continue;
+      Key last = iter.key();
+      for (iter.Next(); iter.Valid(); iter.Next()) {
+        ASSERT_LT(last, iter.key());
+        last = iter.key();
+      }
+    }
+  });
+  std::vector<std::thread> writers;
+  for (int t = 0; t < kThreads; t++) {
+    writers.emplace_back([&list, t]() {
+      for (int i = 0; i < kPerThread; i++) {
+        // 7919 is coprime with kPerThread, so this visits every i once
+        const Key k = (static_cast<Key>(i) * 7919 % kPerThread) * kThreads + t;
+        list.InsertConcurrently(k);
+      }
+    });
+  }
+  for (auto& writer : writers) {
+    writer.join();
+  }
+  done.store(true, std::memory_order_release);
+  reader.join();
+
+  SkipList<Key, Comparator>::Iterator iter(&list);
+  iter.SeekToFirst();
+  for (Key k = 0; k < kThreads * kPerThread; k++) {
+    ASSERT_TRUE(iter.Valid());
+    ASSERT_EQ(k, iter.key());
+    ASSERT_TRUE(list.Contains(k));
+    iter.Next();
+  }
+  ASSERT_TRUE(!iter.Valid());
+}
+
 // Needed when building in C++11 mode.
 constexpr uint32_t ConcurrentTest::K;
 
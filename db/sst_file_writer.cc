@@ -0,0 +1,125 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "leveldb/sst_file_writer.h"
+
+#include "db/dbformat.h"
+#include "leveldb/comparator.h"
+#include "leveldb/env.h"
+#include "leveldb/table_builder.h"
+
+namespace leveldb {
+
+// The entries are stored with internal keys of sequence number zero, which
+// DB::IngestExternalFile() replaces if they must be newer than others.
+struct SstFileWriter::Rep {
+  explicit Rep(const Options& opt)
+      : internal_comparator(opt.comparator),
+        internal_filter_policy(opt.filter_policy, opt.prefix_extractor),
+        options(opt),
+        file(nullptr),
+        builder(nullptr),
+        num_entries(0),
+        file_size(0) {
+    options.comparator = &internal_comparator;
+    options.filter_policy =
+        (opt.filter_policy != nullptr) ? &internal_filter_policy : nullptr;
+    // The limiter throttles the background writes of a DB only
+    options.rate_limiter = nullptr;
+  }
+
+  const InternalKeyComparator internal_comparator;
+  const InternalFilterPolicy internal_filter_policy;
+  Options options;
+  WritableFile* file;
+  TableBuilder* builder;
+  std::string last_key;  // User key of the last entry
+  std::string ikey;      // Scratch space for internal keys
+  uint64_t num_entries;
+  uint64_t file_size;
+};
+
+SstFileWriter::SstFileWriter(const Options& options)
+    : rep_(new Rep(options)) {}
+
+SstFileWriter::~SstFileWriter() {
+  if (rep_->builder != nullptr) {
+    rep_->builder->Abandon();
+    delete rep_->builder;
+  }
+  delete rep_->file;
+  delete rep_;
+}
+
+Status SstFileWriter::Open(const std::string& fname) {
+  Rep* r = rep_;
+  if (r->builder != nullptr) {
+    return Status::InvalidArgument("a file is already being written");
+  }
+  delete r->file;
+  r->file = nullptr;
+  Status s = r->options.env->NewWritableFile(fname, &r->file);
+  if (s.ok()) {
+    r->builder = new TableBuilder(r->options, r->file);
+    r->num_entries = 0;
+    r->file_size = 0;
+  }
+  return s;
+}
+
+Status SstFileWriter::Put(const Slice& key, const Slice& value) {
+  return Add(key, value, false);
+}
+
+Status SstFileWriter::Delete(const Slice& key) {
+  return Add(key, Slice(), true);
+}
+
+Status SstFileWriter::Add(const Slice& key, const Slice& value,
+                          bool deletion) {
+  Rep* r = rep_;
+  if (r->builder == nullptr) {
+    return Status::InvalidArgument("no file is being written");
+  }
+  if (r->num_entries > 0 &&
+      r->internal_comparator.user_comparator()->Compare(key, r->last_key) <=
+          0) {
+    return Status::InvalidArgument("keys must be added in increasing order",
+                                   key);
+  }
+  const ValueType type = deletion ? kTypeDeletion : kTypeValue;
+  r->ikey.clear();
+  AppendInternalKey(&r->ikey, ParsedInternalKey(key, 0, type));
+  r->builder->Add(r->ikey, value);
+  r->last_key.assign(key.data(), key.size());
+  r->num_entries++;
+  r->file_size = r->builder->FileSize();
+  return r->builder->status();
+}
+
+Status SstFileWriter::Finish() {
+  Rep* r = rep_;
+  if (r->builder == nullptr) {
+    return Status::InvalidArgument("no file is being written");
+  }
+  Status s = r->builder->Finish();
+  r->file_size = r->builder->FileSize();
+  delete r->builder;
+  r->builder = nullptr;
+  if (s.ok()) {
+    s = r->file->Sync();
+  }
+  if (s.ok()) {
+    s = r->file->Close();
+  }
+  delete r->file;
+  r->file = nullptr;
+  return s;
+}
+
+uint64_t SstFileWriter::NumEntries() const { return rep_->num_entries; }
+
+uint64_t SstFileWriter::FileSize() const { return rep_->file_size; }
+
+}  // namespace leveldb
@@ -20,8 +20,10 @@
 
 #include "db/table_cache.h"
 
+#include "db/blob_file.h"
 #include "db/filename.h"
 #include "leveldb/env.h"
+#include "leveldb/slice_transform.h"
 #include "leveldb/table.h"
 #include "util/coding.h"
 
@@ -40,12 +42,88 @@ static void DeleteEntry(const Slice& key, void* value) {
   delete tf;
 }
 
+static void DeleteBlobFile(const Slice& key, void* value) {
+  delete reinterpret_cast<RandomAccessFile*>(value);
+}
+
 static void UnrefEntry(void* arg1, void* arg2) {
   Cache* cache = reinterpret_cast<Cache*>(arg1);
   Cache::Handle* h = reinterpret_cast<Cache::Handle*>(arg2);
   cache->Release(h);
 }
 
+namespace {
+
+// Skips the seeks into a table whose filters hold no entry with the prefix
+// of the target.  The keys of the prefix after the target would be in the
+// blocks that the seek reads, so they are not skipped.
+class PrefixSeekIterator : public Iterator {
+ public:
+  PrefixSeekIterator(Iterator* iter, const Table* table,
+                     const SliceTransform* prefix_extractor)
+      : iter_(iter),
+        table_(table),
+        prefix_extractor_(prefix_extractor),
+        skipped_(false) {}
+
+  PrefixSeekIterator(const PrefixSeekIterator&) = delete;
+  PrefixSeekIterator& operator=(const PrefixSeekIterator&) = delete;
+
+  ~PrefixSeekIterator() override { delete iter_; }
+
+  bool Valid() const override { return !skipped_ && iter_->Valid(); }
+  void SeekToFirst() override {
+    skipped_ = false;
+    iter_->SeekToFirst();
+  }
+  void SeekToLast() override {
+    skipped_ = false;
+    iter_->SeekToLast();
+  }
+  void Seek(const Slice& target) override {
+    const Slice user_key = ExtractUserKey(target);
+    if (prefix_extractor_->InDomain(user_key)) {
+      filter_key_.clear();
+      AppendInternalKey(&filter_key_,
+                        ParsedInternalKey(prefix_extractor_->Transform(user_key),
+                                          kMaxSequenceNumber,
+                                          kValueTypeForSeek));
+      if (!table_->SeekMayMatch(target, filter_key_)) {
+        skipped_ = true;
+        return;
+      }
+    }
+    skipped_ = false;
+    iter_->Seek(target);
+  }
+  void Next() override {
+    assert(Valid());
+    iter_->Next();
+  }
+  void Prev() override {
+    assert(Valid());
+    iter_->Prev();
+  }
+  Slice key() const override {
+    assert(Valid());
+    return iter_->key();
+  }
+  Slice value() const override {
+    assert(Valid());
+    return iter_->value();
+  }
+  Status status() const override { return iter_->status(); }
+
+ private:
+  Iterator* const iter_;
+  const Table* const table_;
+  const SliceTransform* const prefix_extractor_;
+  std::string filter_key_;  // Internal key of the prefix of the last target
+  bool skipped_;
+};
+
+}  // namespace
+
 TableCache::TableCache(const std::string& dbname, const Options& options,
                        int entries)
     : env_(options.env),
@@ -118,6 +196,10 @@ Iterator* TableCache::NewIterator(const ReadOptions& options,
   // 查找SSTable就需要调用table类的NewIterator来构造迭代器
   Iterator* result = table->NewIterator(options);
   result->RegisterCleanup(&UnrefEntry, cache_, handle);
+  if (options.prefix_same_as_start && options_.prefix_extractor != nullptr &&
+      options_.filter_policy != nullptr) {
+    result = new PrefixSeekIterator(result, table, options_.prefix_extractor);
+  }
   if (tableptr != nullptr) { 
     *tableptr = table;
   }
@@ -139,6 +221,66 @@ Status TableCache::Get(const ReadOptions& options, uint64_t file_number,
   return s;
 }
 
+Status TableCache::MultiGet(const ReadOptions& options, uint64_t file_number,
+                            uint64_t file_size, int n, const Slice* keys,
+                            void* const* args,
+                            void (*handle_result)(void*, const Slice&,
+                                                  const Slice&)) {
+  Cache::Handle* handle = nullptr;
+  Status s = FindTable(file_number, file_size, &handle);
+  if (s.ok()) {
+    Table* t = reinterpret_cast<TableAndFile*>(cache_->Value(handle))->table;
+    s = t->InternalMultiGet(options, n, keys, args, handle_result);
+    cache_->Release(handle);
+  }
+  return s;
+}
+
+Status TableCache::GetTable(uint64_t file_number, uint64_t file_size,
+                            Table** tableptr, Cache::Handle** handle) {
+  *tableptr = nullptr;
+  Status s = FindTable(file_number, file_size, handle);
+  if (s.ok()) {
+    *tableptr = reinterpret_cast<TableAndFile*>(cache_->Value(*handle))->table;
+  }
+  return s;
+}
+
+void TableCache::Release(Cache::Handle* handle) { cache_->Release(handle); }
+
+Status TableCache::FindBlobFile(uint64_t file_number, Cache::Handle** handle) {
+  Status s;
+  char buf[sizeof(file_number)];
+  EncodeFixed64(buf, file_number);
+  Slice key(buf, sizeof(buf));
+  *handle = cache_->Lookup(key);
+  if (*handle == nullptr) {
+    RandomAccessFile* file = nullptr;
+    s = env_->NewRandomAccessFile(BlobFileName(dbname_, file_number), &file);
+    if (s.ok()) {
+      *handle = cache_->Insert(key, file, 1, &DeleteBlobFile);
+    }
+  }
+  return s;
+}
+
+Status TableCache::GetBlob(const ReadOptions& options, const Slice& blob_index,
+                           std::string* value) {
+  BlobIndex index;
+  if (!index.DecodeFrom(blob_index)) {
+    return Status::Corruption("bad blob index");
+  }
+  Cache::Handle* handle = nullptr;
+  Status s = FindBlobFile(index.file_number, &handle);
+  if (s.ok()) {
+    RandomAccessFile* file =
+        reinterpret_cast<RandomAccessFile*>(cache_->Value(handle));
+    s = ReadBlob(file, index, options.verify_checksums, value);
+    cache_->Release(handle);
+  }
+  return s;
+}
+
 void TableCache::Evict(uint64_t file_number) {
   char buf[sizeof(file_number)];
   EncodeFixed64(buf, file_number);
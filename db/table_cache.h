@@ -37,7 +37,9 @@ class TableCache {
   ~TableCache();
 
   // Return an iterator for the specified file number (the corresponding
-  // file length must be exactly "file_size" bytes).  If "tableptr" is
+  // file length must be exactly "file_size" bytes).  With
+  // options.prefix_same_as_start, a Seek() that the filters show to find
+  // no entry of the prefix of its target leaves the iterator invalid.  If "tableptr" is
   // non-null, also sets "*tableptr" to point to the Table object
   // underlying the returned iterator, or to nullptr if no Table object
   // underlies the returned iterator.  The returned "*tableptr" object is owned
@@ -57,7 +59,28 @@ class TableCache {
              uint64_t file_size, const Slice& k, void* arg,
              void (*handle_result)(void*, const Slice&, const Slice&));
 
-  // Evict any entry for the specified file number
+  // Like Get() for each of the "n" sorted internal keys in "keys", calling
+  // (*handle_result)(args[i], ...) for the entry found for keys[i].
+  Status MultiGet(const ReadOptions& options, uint64_t file_number,
+                  uint64_t file_size, int n, const Slice* keys,
+                  void* const* args,
+                  void (*handle_result)(void*, const Slice&, const Slice&));
+
+  // Store in "*tableptr" the Table for the specified file number and pin
+  // it in the cache.  On success the caller must pass "*handle" to
+  // Release() once it is done with the table.
+  Status GetTable(uint64_t file_number, uint64_t file_size, Table** tableptr,
+                  Cache::Handle** handle);
+
+  // Unpin a table returned by GetTable().
+  void Release(Cache::Handle* handle);
+
+  // Read the value that the encoded BlobIndex "blob_index" refers to into
+  // *value.  The blob files are kept open in the same cache as the tables.
+  Status GetBlob(const ReadOptions& options, const Slice& blob_index,
+                 std::string* value);
+
+  // Evict any entry for the specified table or blob file number
   void Evict(uint64_t file_number);
 
  private:
@@ -69,6 +92,8 @@ class TableCache {
    */
   Status FindTable(uint64_t file_number, uint64_t file_size, Cache::Handle**);
 
+  Status FindBlobFile(uint64_t file_number, Cache::Handle**);
+
   Env* const env_;  // 与环境操作有关的变量
   const std::string dbname_; // 数据库的名字
   const Options& options_; // 操作参数，里边有对block——cache的设置
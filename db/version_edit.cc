@@ -21,7 +21,12 @@ enum Tag {
   kDeletedFile = 6,
   kNewFile = 7,
   // 8 was used for large value refs
-  kPrevLogNumber = 9
+  kPrevLogNumber = 9,
+  kRemixFile = 10,
+  kRangeTombstone = 11,
+  kDeletedRangeTombstone = 12,
+  kNewFileWithSequences = 13,
+  kNewFileWithBlobs = 14
 };
 
 void VersionEdit::Clear() {
@@ -30,14 +35,18 @@ void VersionEdit::Clear() {
   prev_log_number_ = 0;
   last_sequence_ = 0;
   next_file_number_ = 0;
+  remix_file_number_ = 0;
   has_comparator_ = false;
   has_log_number_ = false;
   has_prev_log_number_ = false;
   has_next_file_number_ = false;
   has_last_sequence_ = false;
+  has_remix_file_number_ = false;
   compact_pointers_.clear();
   deleted_files_.clear();
   new_files_.clear();
+  new_range_tombstones_.clear();
+  deleted_range_tombstones_.clear();
 }
 
 void VersionEdit::EncodeTo(std::string* dst) const {
@@ -61,6 +70,10 @@ void VersionEdit::EncodeTo(std::string* dst) const {
     PutVarint32(dst, kLastSequence);
     PutVarint64(dst, last_sequence_);
   }
+  if (has_remix_file_number_) {
+    PutVarint32(dst, kRemixFile);
+    PutVarint64(dst, remix_file_number_);
+  }
 
   for (size_t i = 0; i < compact_pointers_.size(); i++) {
     PutVarint32(dst, kCompactPointer);
@@ -76,12 +89,40 @@ void VersionEdit::EncodeTo(std::string* dst) const {
 
   for (size_t i = 0; i < new_files_.size(); i++) {
     const FileMetaData& f = new_files_[i].second;
-    PutVarint32(dst, kNewFile);
+    // Files without sequence bounds or blob references keep the old format.
+    const bool has_blobs = !f.blob_files.empty();
+    const bool has_sequences = has_blobs || f.smallest_sequence != 0 ||
+                               f.largest_sequence != kMaxSequenceNumber;
+    PutVarint32(dst, has_blobs       ? kNewFileWithBlobs
+                     : has_sequences ? kNewFileWithSequences
+                                     : kNewFile);
     PutVarint32(dst, new_files_[i].first);  // level
     PutVarint64(dst, f.number);
     PutVarint64(dst, f.file_size);
     PutLengthPrefixedSlice(dst, f.smallest.Encode());
     PutLengthPrefixedSlice(dst, f.largest.Encode());
+    if (has_sequences) {
+      PutVarint64(dst, f.smallest_sequence);
+      PutVarint64(dst, f.largest_sequence);
+    }
+    if (has_blobs) {
+      PutVarint32(dst, static_cast<uint32_t>(f.blob_files.size()));
+      for (uint64_t blob : f.blob_files) {
+        PutVarint64(dst, blob);
+      }
+    }
+  }
+
+  for (const RangeTombstone& t : new_range_tombstones_) {
+    PutVarint32(dst, kRangeTombstone);
+    PutLengthPrefixedSlice(dst, t.begin);
+    PutLengthPrefixedSlice(dst, t.end);
+    PutVarint64(dst, t.sequence);
+  }
+
+  for (SequenceNumber sequence : deleted_range_tombstones_) {
+    PutVarint32(dst, kDeletedRangeTombstone);
+    PutVarint64(dst, sequence);
   }
 }
 
@@ -113,9 +154,12 @@ Status VersionEdit::DecodeFrom(const Slice& src) {
   // Temporary storage for parsing
   int level;
   uint64_t number;
+  uint32_t count;
   FileMetaData f;
   Slice str;
   InternalKey key;
+  RangeTombstone tombstone;
+  Slice end;
 
   while (msg == nullptr && GetVarint32(&input, &tag)) {
     switch (tag) {
@@ -160,6 +204,14 @@ Status VersionEdit::DecodeFrom(const Slice& src) {
         }
         break;
 
+      case kRemixFile:
+        if (GetVarint64(&input, &remix_file_number_)) {
+          has_remix_file_number_ = true;
+        } else {
+          msg = "remix file number";
+        }
+        break;
+
       case kCompactPointer:
         if (GetLevel(&input, &level) && GetInternalKey(&input, &key)) {
           compact_pointers_.push_back(std::make_pair(level, key));
@@ -177,6 +229,9 @@ Status VersionEdit::DecodeFrom(const Slice& src) {
         break;
 
       case kNewFile:
+        f.smallest_sequence = 0;
+        f.largest_sequence = kMaxSequenceNumber;
+        f.blob_files.clear();
         if (GetLevel(&input, &level) && GetVarint64(&input, &f.number) &&
             GetVarint64(&input, &f.file_size) &&
             GetInternalKey(&input, &f.smallest) &&
@@ -187,6 +242,64 @@ Status VersionEdit::DecodeFrom(const Slice& src) {
         }
         break;
 
+      case kNewFileWithSequences:
+        f.blob_files.clear();
+        if (GetLevel(&input, &level) && GetVarint64(&input, &f.number) &&
+            GetVarint64(&input, &f.file_size) &&
+            GetInternalKey(&input, &f.smallest) &&
+            GetInternalKey(&input, &f.largest) &&
+            GetVarint64(&input, &f.smallest_sequence) &&
+            GetVarint64(&input, &f.largest_sequence)) {
+          new_files_.push_back(std::make_pair(level, f));
+        } else {
+          msg = "new-file entry";
+        }
+        break;
+
+      case kNewFileWithBlobs:
+        f.blob_files.clear();
+        if (GetLevel(&input, &level) && GetVarint64(&input, &f.number) &&
+            GetVarint64(&input, &f.file_size) &&
+            GetInternalKey(&input, &f.smallest) &&
+            GetInternalKey(&input, &f.largest) &&
+            GetVarint64(&input, &f.smallest_sequence) &&
+            GetVarint64(&input, &f.largest_sequence) &&
+            GetVarint32(&input, &count)) {
+          for (uint32_t i = 0; i < count && msg == nullptr; i++) {
+            if (GetVarint64(&input, &number)) {
+              f.blob_files.push_back(number);
+            } else {
+              msg = "new-file entry";
+            }
+          }
+          if (msg == nullptr) {
+            new_files_.push_back(std::make_pair(level, f));
+          }
+        } else {
+          msg = "new-file entry";
+        }
+        break;
+
+      case kRangeTombstone:
+        if (GetLengthPrefixedSlice(&input, &str) &&
+            GetLengthPrefixedSlice(&input, &end) &&
+            GetVarint64(&input, &tombstone.sequence)) {
+          tombstone.begin = str.ToString();
+          tombstone.end = end.ToString();
+          new_range_tombstones_.push_back(tombstone);
+        } else {
+          msg = "range tombstone";
+        }
+        break;
+
+      case kDeletedRangeTombstone:
+        if (GetVarint64(&input, &tombstone.sequence)) {
+          deleted_range_tombstones_.insert(tombstone.sequence);
+        } else {
+          msg = "deleted range tombstone";
+        }
+        break;
+
       default:
         msg = "unknown tag";
         break;
@@ -227,6 +340,10 @@ std::string VersionEdit::DebugString() const {
     r.append("\n  LastSeq: ");
     AppendNumberTo(&r, last_sequence_);
   }
+  if (has_remix_file_number_) {
+    r.append("\n  RemixFile: ");
+    AppendNumberTo(&r, remix_file_number_);
+  }
   for (size_t i = 0; i < compact_pointers_.size(); i++) {
     r.append("\n  CompactPointer: ");
     AppendNumberTo(&r, compact_pointers_[i].first);
@@ -251,6 +368,31 @@ std::string VersionEdit::DebugString() const {
     r.append(f.smallest.DebugString());
     r.append(" .. ");
     r.append(f.largest.DebugString());
+    if (f.smallest_sequence != 0 || f.largest_sequence != kMaxSequenceNumber) {
+      r.append(" seq ");
+      AppendNumberTo(&r, f.smallest_sequence);
+      r.append(" .. ");
+      AppendNumberTo(&r, f.largest_sequence);
+    }
+    if (!f.blob_files.empty()) {
+      r.append(" blobs");
+      for (uint64_t blob : f.blob_files) {
+        r.append(" ");
+        AppendNumberTo(&r, blob);
+      }
+    }
+  }
+  for (const RangeTombstone& t : new_range_tombstones_) {
+    r.append("\n  AddRangeTombstone: '");
+    r.append(EscapeString(t.begin));
+    r.append("' .. '");
+    r.append(EscapeString(t.end));
+    r.append("' @ ");
+    AppendNumberTo(&r, t.sequence);
+  }
+  for (SequenceNumber sequence : deleted_range_tombstones_) {
+    r.append("\n  RemoveRangeTombstone: ");
+    AppendNumberTo(&r, sequence);
   }
   r.append("\n}\n");
   return r;
@@ -10,6 +10,7 @@
 #include <vector>
 
 #include "db/dbformat.h"
+#include "db/range_tombstone.h"
 
 namespace leveldb {
 
@@ -17,7 +18,12 @@ class VersionSet;
 
 // 文件信息，维护了引用次数、允许的最大无效查询次数、文件序列号、文件大小（字节）、该文件中的最小键、该文件中的最大键
 struct FileMetaData {
-  FileMetaData() : refs(0), allowed_seeks(1 << 30), file_size(0) {}
+  FileMetaData()
+      : refs(0),
+        allowed_seeks(1 << 30),
+        file_size(0),
+        smallest_sequence(0),
+        largest_sequence(kMaxSequenceNumber) {}
 
   int refs;           // 引用次数
   int allowed_seeks;  // 允许的最大无效查询次数，超过这个次数，该文件就要被compact
@@ -25,6 +31,12 @@ struct FileMetaData {
   uint64_t file_size;    // 文件大小（字节）
   InternalKey smallest;  // 该文件中的最小键
   InternalKey largest;   // 该文件中的最大键
+  // Bounds of the sequence numbers of the entries in the file.  Files
+  // written before these were recorded keep the widest bounds.
+  SequenceNumber smallest_sequence;
+  SequenceNumber largest_sequence;
+  // Numbers of the blob files that entries of the file refer to.
+  std::vector<uint64_t> blob_files;
 };
 
 // 该结构用于存储生成新的version的中间结果，最终与Version N合并直接生成Version N+1
@@ -58,6 +70,12 @@ class VersionEdit {
     has_last_sequence_ = true;
     last_sequence_ = seq;
   }
+  // Record the file holding the persisted REMIX view of the resulting
+  // version.
+  void SetRemixFile(uint64_t num) {
+    has_remix_file_number_ = true;
+    remix_file_number_ = num;
+  }
   void SetCompactPointer(int level, const InternalKey& key) {
     compact_pointers_.push_back(std::make_pair(level, key));
   }
@@ -76,11 +94,35 @@ class VersionEdit {
     new_files_.push_back(std::make_pair(level, f));
   }
 
+  // Add the file described by "f" at the specified level, including the
+  // sequence number bounds of its entries and the blob files it refers to.
+  void AddFile(int level, const FileMetaData& f) {
+    FileMetaData copy;
+    copy.number = f.number;
+    copy.file_size = f.file_size;
+    copy.smallest = f.smallest;
+    copy.largest = f.largest;
+    copy.smallest_sequence = f.smallest_sequence;
+    copy.largest_sequence = f.largest_sequence;
+    copy.blob_files = f.blob_files;
+    new_files_.push_back(std::make_pair(level, copy));
+  }
+
   // Delete the specified "file" from the specified "level".
   // 给一个层级删除文件，将指定的文件序列号送入deleted_files_数组
   void RemoveFile(int level, uint64_t file) {
     deleted_files_.insert(std::make_pair(level, file));
   }
+
+  // Add a range tombstone that was flushed from a memtable.
+  void AddRangeTombstone(const RangeTombstone& tombstone) {
+    new_range_tombstones_.push_back(tombstone);
+  }
+
+  // Drop the range tombstone with the specified sequence number.
+  void RemoveRangeTombstone(SequenceNumber sequence) {
+    deleted_range_tombstones_.insert(sequence);
+  }
   // 编码
   void EncodeTo(std::string* dst) const;
   // 解码
@@ -98,15 +140,19 @@ class VersionEdit {
   uint64_t prev_log_number_;
   uint64_t next_file_number_; // 其他文件编号
   SequenceNumber last_sequence_;
+  uint64_t remix_file_number_;
   bool has_comparator_;
   bool has_log_number_;
   bool has_prev_log_number_;
   bool has_next_file_number_;
   bool has_last_sequence_;
+  bool has_remix_file_number_;
 
   std::vector<std::pair<int, InternalKey>> compact_pointers_;  // 每个level层的compact pointer
   DeletedFileSet deleted_files_;  // 要删除的SST
   std::vector<std::pair<int, FileMetaData>> new_files_; // 要添加的SST
+  std::vector<RangeTombstone> new_range_tombstones_;
+  std::set<SequenceNumber> deleted_range_tombstones_;
 };
 
 }  // namespace leveldb
@@ -35,7 +35,59 @@ TEST(VersionEditTest, EncodeDecode) {
   edit.SetLogNumber(kBig + 100);
   edit.SetNextFile(kBig + 200);
   edit.SetLastSequence(kBig + 1000);
+  edit.SetRemixFile(kBig + 300);
   TestEncodeDecode(edit);
 }
 
+TEST(VersionEditTest, EncodeDecodeRangeTombstones) {
+  static const uint64_t kBig = 1ull << 50;
+
+  VersionEdit edit;
+  FileMetaData f;
+  f.number = kBig + 1;
+  f.file_size = kBig + 2;
+  f.smallest = InternalKey("a", kBig + 3, kTypeValue);
+  f.largest = InternalKey("m", kBig + 4, kTypeValue);
+  f.smallest_sequence = kBig + 3;
+  f.largest_sequence = kBig + 5;
+  edit.AddFile(2, f);
+  edit.AddRangeTombstone(RangeTombstone("b", "k", kBig + 6));
+  edit.AddRangeTombstone(RangeTombstone(Slice("\0x", 2), "y", kBig + 7));
+  edit.RemoveRangeTombstone(kBig + 8);
+  TestEncodeDecode(edit);
+
+  std::string encoded;
+  edit.EncodeTo(&encoded);
+  VersionEdit parsed;
+  ASSERT_TRUE(parsed.DecodeFrom(encoded).ok());
+  ASSERT_EQ(edit.DebugString(), parsed.DebugString());
+}
+
+TEST(VersionEditTest, EncodeDecodeBlobFiles) {
+  static const uint64_t kBig = 1ull << 50;
+
+  VersionEdit edit;
+  FileMetaData f;
+  f.number = kBig + 1;
+  f.file_size = kBig + 2;
+  f.smallest = InternalKey("a", kBig + 3, kTypeBlobIndex);
+  f.largest = InternalKey("m", kBig + 4, kTypeValue);
+  f.smallest_sequence = kBig + 3;
+  f.largest_sequence = kBig + 5;
+  f.blob_files.push_back(kBig + 6);
+  f.blob_files.push_back(7);
+  edit.AddFile(1, f);
+  f.number = kBig + 8;
+  f.blob_files.clear();
+  edit.AddFile(1, f);
+  TestEncodeDecode(edit);
+
+  std::string encoded;
+  edit.EncodeTo(&encoded);
+  VersionEdit parsed;
+  ASSERT_TRUE(parsed.DecodeFrom(encoded).ok());
+  ASSERT_EQ(edit.DebugString(), parsed.DebugString());
+  ASSERT_NE(std::string::npos, parsed.DebugString().find(" blobs "));
+}
+
 }  // namespace leveldb
@@ -22,12 +22,12 @@
 #include "db/memtable.h"
 #include "db/table_cache.h"
 #include "leveldb/env.h"
+#include "leveldb/slice_transform.h"
 #include "leveldb/table_builder.h"
 #include "table/merger.h"
 #include "table/two_level_iterator.h"
 #include "util/coding.h"
 #include "util/logging.h"
-#include "leveldb/RemixHelper.h"
 
 namespace leveldb {
 
@@ -178,23 +178,47 @@ bool SomeFileOverlapsRange(const InternalKeyComparator& icmp,
 // 使用 EncodeFixed64 进行编码。
 class Version::LevelFileNumIterator : public Iterator {
  public:
+  // If "prefix_extractor" is non-null, Next() after a Seek() to a key in
+  // its domain stops at the file whose largest key is past the prefix of
+  // the key, since no later file can hold that prefix.
   LevelFileNumIterator(const InternalKeyComparator& icmp,
-                       const std::vector<FileMetaData*>* flist)
-      : icmp_(icmp), flist_(flist), index_(flist->size()) {  // Marks as invalid
-  }
+                       const std::vector<FileMetaData*>* flist,
+                       const SliceTransform* prefix_extractor = nullptr)
+      : icmp_(icmp),
+        flist_(flist),
+        prefix_extractor_(prefix_extractor),
+        index_(flist->size()),  // Marks as invalid
+        has_prefix_(false) {}
   bool Valid() const override { return index_ < flist_->size(); }
   void Seek(const Slice& target) override {
     index_ = FindFile(icmp_, *flist_, target);
+    const Slice user_key = ExtractUserKey(target);
+    has_prefix_ = (prefix_extractor_ != nullptr &&
+                   prefix_extractor_->InDomain(user_key));
+    if (has_prefix_) {
+      const Slice prefix = prefix_extractor_->Transform(user_key);
+      prefix_.assign(prefix.data(), prefix.size());
+    }
+  }
+  void SeekToFirst() override {
+    index_ = 0;
+    has_prefix_ = false;
   }
-  int SeekToFirst() override { index_ = 0; return 0;}
   void SeekToLast() override {
     index_ = flist_->empty() ? 0 : flist_->size() - 1;
+    has_prefix_ = false;
   }
-  int Next() override {
+  void Next() override {
     assert(Valid());
+    if (has_prefix_) {
+      const Slice largest = (*flist_)[index_]->largest.user_key();
+      if (!prefix_extractor_->InDomain(largest) ||
+          prefix_extractor_->Transform(largest) != prefix_) {
+        index_ = flist_->size();  // Marks as invalid
+        return;
+      }
+    }
     index_++;
-    return 0;
-    
   }
   void Prev() override {
     assert(Valid());
@@ -219,7 +243,10 @@ class Version::LevelFileNumIterator : public Iterator {
  private:
   const InternalKeyComparator icmp_;
   const std::vector<FileMetaData*>* const flist_; // 文件list，里边的元素为文件的元信息
+  const SliceTransform* const prefix_extractor_;
   uint32_t index_;  // flist_中的第index_个SSTable的元信息
+  bool has_prefix_;     // Does Next() stop past prefix_?
+  std::string prefix_;  // Prefix of the target of the last Seek()
 
   // Backing store for value().  Holds the file number and size.
   mutable char value_buf_[16];
@@ -253,9 +280,12 @@ static Iterator* GetFileIterator(void* arg, const ReadOptions& options,
  */
 Iterator* Version::NewConcatenatingIterator(const ReadOptions& options,
                                             int level) const {
+  const SliceTransform* prefix_extractor =
+      options.prefix_same_as_start ? vset_->options_->prefix_extractor
+                                   : nullptr;
   return NewTwoLevelIterator(
-      new LevelFileNumIterator(vset_->icmp_, &files_[level]), &GetFileIterator,
-      vset_->table_cache_, options);
+      new LevelFileNumIterator(vset_->icmp_, &files_[level], prefix_extractor),
+      &GetFileIterator, vset_->table_cache_, options);
 }
 
 void Version::AddIterators(const ReadOptions& options,
@@ -282,6 +312,24 @@ void Version::AddIterators(const ReadOptions& options,
   //std::cout << "there are " << len << "levels iters" << std::endl;
 }
 
+void Version::GetSortedRuns(std::vector<SortedRun>* runs) const {
+  runs->clear();
+  for (size_t i = 0; i < files_[0].size(); i++) {
+    SortedRun run;
+    run.level = 0;
+    run.files.push_back(files_[0][i]);
+    runs->push_back(run);
+  }
+  for (int level = 1; level < config::kNumLevels; level++) {
+    if (!files_[level].empty()) {
+      SortedRun run;
+      run.level = level;
+      run.files = files_[level];
+      runs->push_back(run);
+    }
+  }
+}
+
 // Callback from TableCache::Get()
 namespace {
 enum SaverState {
@@ -295,7 +343,17 @@ struct Saver {
   const Comparator* ucmp;
   Slice user_key;
   std::string* value;
+  SequenceNumber deleted_before;
+  bool blob;  // *value holds the BlobIndex of the value found
 };
+
+// Replace the BlobIndex in *value with the value it refers to.
+Status ResolveBlob(TableCache* table_cache, const ReadOptions& options,
+                   std::string* value) {
+  std::string index;
+  index.swap(*value);
+  return table_cache->GetBlob(options, index, value);
+}
 }  // namespace
 static void SaveValue(void* arg, const Slice& ikey, const Slice& v) {
   Saver* s = reinterpret_cast<Saver*>(arg);
@@ -304,14 +362,38 @@ static void SaveValue(void* arg, const Slice& ikey, const Slice& v) {
     s->state = kCorrupt;
   } else {
     if (s->ucmp->Compare(parsed_key.user_key, s->user_key) == 0) {
-      s->state = (parsed_key.type == kTypeValue) ? kFound : kDeleted;
+      s->state = ((parsed_key.type == kTypeValue ||
+                   parsed_key.type == kTypeBlobIndex) &&
+                  parsed_key.sequence >= s->deleted_before)
+                     ? kFound
+                     : kDeleted;
       if (s->state == kFound) {
         s->value->assign(v.data(), v.size());
+        s->blob = (parsed_key.type == kTypeBlobIndex);
       }
     }
   }
 }
 
+bool Version::HasBlobFiles() const {
+  for (int level = 0; level < config::kNumLevels; level++) {
+    for (const FileMetaData* f : files_[level]) {
+      if (!f->blob_files.empty()) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+void Version::AddBlobFiles(std::set<uint64_t>* blob_files) const {
+  for (int level = 0; level < config::kNumLevels; level++) {
+    for (const FileMetaData* f : files_[level]) {
+      blob_files->insert(f->blob_files.begin(), f->blob_files.end());
+    }
+  }
+}
+
 static bool NewestFirst(FileMetaData* a, FileMetaData* b) {
   return a->number > b->number;
 }
@@ -375,7 +457,8 @@ void Version::ForEachOverlapping(Slice user_key, Slice internal_key, void* arg,
  * @return {*}
  */
 Status Version::Get(const ReadOptions& options, const LookupKey& k,
-                    std::string* value, GetStats* stats) {
+                    std::string* value, GetStats* stats,
+                    SequenceNumber deleted_before) {
   stats->seek_file = nullptr;   // 初始化 stats seek_file为空 查找层级为-1
   stats->seek_file_level = -1;
 
@@ -416,6 +499,10 @@ Status Version::Get(const ReadOptions& options, const LookupKey& k,
           return true;  // Keep searching in other files
         case kFound:
           state->found = true;
+          if (state->saver.blob) {
+            state->s = ResolveBlob(state->vset->table_cache_, *state->options,
+                                   state->saver.value);
+          }
           return false;
         case kDeleted:
           return false;
@@ -446,12 +533,153 @@ Status Version::Get(const ReadOptions& options, const LookupKey& k,
   state.saver.ucmp = vset_->icmp_.user_comparator();
   state.saver.user_key = k.user_key();
   state.saver.value = value;
+  state.saver.deleted_before = deleted_before;
+  state.saver.blob = false;
   // 实际上是调用ForEachOverlapping来对SSTable进行查找
   ForEachOverlapping(state.saver.user_key, state.ikey, &state, &State::Match);
 
   return state.found ? state.s : Status::NotFound(Slice());
 }
 
+// Search "f" for the keys of "batch", which are sorted, and record the
+// outcome in the entries whose search is over.
+static void MultiGetFromFile(TableCache* table_cache,
+                             const Comparator* ucmp,
+                             const ReadOptions& options, int level,
+                             FileMetaData* f,
+                             const std::vector<Version::KeyLookup*>& batch) {
+  if (batch.empty()) {
+    return;
+  }
+  const int n = static_cast<int>(batch.size());
+  std::vector<Slice> keys(n);
+  std::vector<Saver> savers(n);
+  std::vector<void*> args(n);
+  for (int i = 0; i < n; i++) {
+    Version::KeyLookup* lookup = batch[i];
+    if (lookup->stats.seek_file == nullptr &&
+        lookup->last_file_read != nullptr) {
+      // We have had more than one seek for this read.  Charge the 1st file.
+      lookup->stats.seek_file = lookup->last_file_read;
+      lookup->stats.seek_file_level = lookup->last_file_read_level;
+    }
+    lookup->last_file_read = f;
+    lookup->last_file_read_level = level;
+
+    keys[i] = lookup->key->internal_key();
+    savers[i].state = kNotFound;
+    savers[i].ucmp = ucmp;
+    savers[i].user_key = lookup->key->user_key();
+    savers[i].value = lookup->value;
+    savers[i].deleted_before = lookup->deleted_before;
+    savers[i].blob = false;
+    args[i] = &savers[i];
+  }
+  Status s = table_cache->MultiGet(options, f->number, f->file_size, n,
+                                   keys.data(), args.data(), SaveValue);
+  for (int i = 0; i < n; i++) {
+    Version::KeyLookup* lookup = batch[i];
+    if (!s.ok()) {
+      lookup->status = s;
+      lookup->done = true;
+      continue;
+    }
+    switch (savers[i].state) {
+      case kNotFound:
+        break;  // Keep searching in other files
+      case kFound:
+        lookup->status = savers[i].blob
+                             ? ResolveBlob(table_cache, options, lookup->value)
+                             : Status::OK();
+        lookup->done = true;
+        break;
+      case kDeleted:
+        lookup->status = Status::NotFound(Slice());
+        lookup->done = true;
+        break;
+      case kCorrupt:
+        lookup->status =
+            Status::Corruption("corrupted key for ", savers[i].user_key);
+        lookup->done = true;
+        break;
+    }
+  }
+}
+
+static void RemoveDone(std::vector<Version::KeyLookup*>* lookups) {
+  lookups->erase(std::remove_if(lookups->begin(), lookups->end(),
+                                [](const Version::KeyLookup* lookup) {
+                                  return lookup->done;
+                                }),
+                 lookups->end());
+}
+
+void Version::MultiGet(const ReadOptions& options,
+                       const std::vector<KeyLookup*>& lookups) {
+  const Comparator* ucmp = vset_->icmp_.user_comparator();
+  std::vector<KeyLookup*> pending;
+  for (KeyLookup* lookup : lookups) {
+    lookup->stats.seek_file = nullptr;
+    lookup->stats.seek_file_level = -1;
+    lookup->last_file_read = nullptr;
+    lookup->last_file_read_level = -1;
+    if (!lookup->done) {
+      pending.push_back(lookup);
+    }
+  }
+
+  // Search level-0 in order from newest to oldest.
+  std::vector<FileMetaData*> level0(files_[0]);
+  std::sort(level0.begin(), level0.end(), NewestFirst);
+  std::vector<KeyLookup*> batch;
+  for (size_t i = 0; i < level0.size() && !pending.empty(); i++) {
+    FileMetaData* f = level0[i];
+    batch.clear();
+    for (KeyLookup* lookup : pending) {
+      const Slice user_key = lookup->key->user_key();
+      if (ucmp->Compare(user_key, f->smallest.user_key()) >= 0 &&
+          ucmp->Compare(user_key, f->largest.user_key()) <= 0) {
+        batch.push_back(lookup);
+      }
+    }
+    MultiGetFromFile(vset_->table_cache_, ucmp, options, 0, f, batch);
+    RemoveDone(&pending);
+  }
+
+  // Search other levels.  Since the keys are sorted, the keys that fall
+  // into one file are adjacent.
+  for (int level = 1; level < config::kNumLevels && !pending.empty();
+       level++) {
+    const std::vector<FileMetaData*>& files = files_[level];
+    size_t i = 0;
+    while (i < pending.size()) {
+      const uint32_t index =
+          FindFile(vset_->icmp_, files, pending[i]->key->internal_key());
+      if (index >= files.size()) {
+        break;  // All remaining keys are past the last file
+      }
+      FileMetaData* f = files[index];
+      batch.clear();
+      for (; i < pending.size() &&
+             vset_->icmp_.Compare(pending[i]->key->internal_key(),
+                                  f->largest.Encode()) <= 0;
+           i++) {
+        if (ucmp->Compare(pending[i]->key->user_key(),
+                          f->smallest.user_key()) >= 0) {
+          batch.push_back(pending[i]);
+        }
+      }
+      MultiGetFromFile(vset_->table_cache_, ucmp, options, level, f, batch);
+    }
+    RemoveDone(&pending);
+  }
+
+  for (KeyLookup* lookup : pending) {
+    lookup->status = Status::NotFound(Slice());
+    lookup->done = true;
+  }
+}
+
 bool Version::UpdateStats(const GetStats& stats) {
   FileMetaData* f = stats.seek_file;
   if (f != nullptr) {
@@ -547,6 +775,37 @@ int Version::PickLevelForMemTableOutput(const Slice& smallest_user_key,
   return level;
 }
 
+int Version::PickLevelForExternalFile(const Slice& smallest_user_key,
+                                      const Slice& largest_user_key,
+                                      const bool* busy_levels) {
+  int level = 0;
+  if (!OverlapInLevel(0, &smallest_user_key, &largest_user_key)) {
+    while (level + 1 < config::kNumLevels &&
+           (busy_levels == nullptr || !busy_levels[level + 1]) &&
+           !OverlapInLevel(level + 1, &smallest_user_key, &largest_user_key)) {
+      level++;
+    }
+  }
+  return level;
+}
+
+bool Version::OverlapInAnyLevel(const Slice& smallest_user_key,
+                                const Slice& largest_user_key) {
+  for (int level = 0; level < config::kNumLevels; level++) {
+    if (OverlapInLevel(level, &smallest_user_key, &largest_user_key)) {
+      return true;
+    }
+  }
+  const Comparator* ucmp = vset_->icmp_.user_comparator();
+  for (const RangeTombstone& t : range_tombstones_) {
+    if (ucmp->Compare(t.begin, largest_user_key) <= 0 &&
+        ucmp->Compare(t.end, smallest_user_key) > 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
 // Store in "*inputs" all files in "level" that overlap [begin,end]
 void Version::GetOverlappingInputs(int level, const InternalKey* begin,
                                    const InternalKey* end,
@@ -645,6 +904,8 @@ class VersionSet::Builder {
   VersionSet* vset_;
   Version* base_;
   LevelState levels_[config::kNumLevels];
+  std::vector<RangeTombstone> added_tombstones_;
+  std::set<SequenceNumber> deleted_tombstones_;
 
  public:
   // Initialize a builder with the files from *base and other info from *vset
@@ -730,6 +991,13 @@ class VersionSet::Builder {
       levels_[level].deleted_files.erase(f->number);
       levels_[level].added_files->insert(f);
     }
+
+    // Update range tombstones
+    added_tombstones_.insert(added_tombstones_.end(),
+                             edit->new_range_tombstones_.begin(),
+                             edit->new_range_tombstones_.end());
+    deleted_tombstones_.insert(edit->deleted_range_tombstones_.begin(),
+                               edit->deleted_range_tombstones_.end());
   }
 
   // Save the current state in *v.将合并之后的文件更新到新的Version中，同时对大于level-0层的文件进行排序，对于level-0层文件不管
@@ -776,6 +1044,17 @@ class VersionSet::Builder {
       }
 #endif
     }
+
+    for (const RangeTombstone& t : base_->range_tombstones_) {
+      if (deleted_tombstones_.count(t.sequence) == 0) {
+        v->range_tombstones_.push_back(t);
+      }
+    }
+    for (const RangeTombstone& t : added_tombstones_) {
+      if (deleted_tombstones_.count(t.sequence) == 0) {
+        v->range_tombstones_.push_back(t);
+      }
+    }
   }
 
   // 将f文件add进level层，如果f为删除文件，则什么也不做；否则add且（当非level-0时，保证没有范围覆盖）
@@ -808,6 +1087,7 @@ VersionSet::VersionSet(const std::string& dbname, const Options* options,
       last_sequence_(0),
       log_number_(0),
       prev_log_number_(0),
+      remix_file_number_(0),
       descriptor_file_(nullptr),
       descriptor_log_(nullptr),
       dummy_versions_(this),
@@ -913,6 +1193,9 @@ Status VersionSet::LogAndApply(VersionEdit* edit, port::Mutex* mu) {
     AppendVersion(v);
     log_number_ = edit->log_number_;
     prev_log_number_ = edit->prev_log_number_;
+    if (edit->has_remix_file_number_) {
+      remix_file_number_ = edit->remix_file_number_;
+    }
   } else {
     delete v;
     if (!new_manifest_file.empty()) {
@@ -966,6 +1249,7 @@ Status VersionSet::Recover(bool* save_manifest) {
   uint64_t last_sequence = 0;
   uint64_t log_number = 0;
   uint64_t prev_log_number = 0;
+  uint64_t remix_file_number = 0;
   Builder builder(this, current_);
   int read_records = 0;
 
@@ -1003,6 +1287,10 @@ Status VersionSet::Recover(bool* save_manifest) {
         have_prev_log_number = true;
       }
 
+      if (edit.has_remix_file_number_) {
+        remix_file_number = edit.remix_file_number_;
+      }
+
       if (edit.has_next_file_number_) {
         next_file = edit.next_file_number_;
         have_next_file = true;
@@ -1032,6 +1320,7 @@ Status VersionSet::Recover(bool* save_manifest) {
 
     MarkFileNumberUsed(prev_log_number);
     MarkFileNumberUsed(log_number);
+    MarkFileNumberUsed(remix_file_number);
   }
 
   if (s.ok()) {
@@ -1045,6 +1334,7 @@ Status VersionSet::Recover(bool* save_manifest) {
     last_sequence_ = last_sequence;
     log_number_ = log_number;
     prev_log_number_ = prev_log_number;
+    remix_file_number_ = remix_file_number;
 
     // See if we can reuse the existing MANIFEST file.
     if (ReuseManifest(dscname, current)) {
@@ -1102,6 +1392,7 @@ void VersionSet::Finalize(Version* v) {
   // Precomputed best level for next compaction
   int best_level = -1;
   double best_score = -1;
+  uint64_t pending_bytes = 0;
 
   for (int level = 0; level < config::kNumLevels - 1; level++) {
     double score;
@@ -1120,13 +1411,21 @@ void VersionSet::Finalize(Version* v) {
       // overwrites/deletions).
       score = v->files_[level].size() /
               static_cast<double>(config::kL0_CompactionTrigger);
+      if (score >= 1) {
+        pending_bytes += TotalFileSize(v->files_[level]);
+      }
     } else {
       // 其他level根据每层所有文件大小计算
       // Compute the ratio of current size to size limit.
       const uint64_t level_bytes = TotalFileSize(v->files_[level]);
       score =
           static_cast<double>(level_bytes) / MaxBytesForLevel(options_, level);
+      if (score > 1) {
+        pending_bytes +=
+            level_bytes - static_cast<uint64_t>(MaxBytesForLevel(options_, level));
+      }
     }
+    v->compaction_scores_[level] = score;
 
     if (score > best_score) {  // 找到score最大的level
       best_level = level;
@@ -1136,6 +1435,7 @@ void VersionSet::Finalize(Version* v) {
 
   v->compaction_level_ = best_level;
   v->compaction_score_ = best_score;
+  v->pending_compaction_bytes_ = pending_bytes;
 }
 
 Status VersionSet::WriteSnapshot(log::Writer* log) {
@@ -1158,16 +1458,84 @@ Status VersionSet::WriteSnapshot(log::Writer* log) {
   for (int level = 0; level < config::kNumLevels; level++) {
     const std::vector<FileMetaData*>& files = current_->files_[level];
     for (size_t i = 0; i < files.size(); i++) {
-      const FileMetaData* f = files[i];
-      edit.AddFile(level, f->number, f->file_size, f->smallest, f->largest);
+      edit.AddFile(level, *files[i]);
     }
   }
 
+  // Save range tombstones
+  for (const RangeTombstone& t : current_->range_tombstones_) {
+    edit.AddRangeTombstone(t);
+  }
+
+  // Save the persisted REMIX view
+  if (remix_file_number_ != 0) {
+    edit.SetRemixFile(remix_file_number_);
+  }
+
   std::string record;
   edit.EncodeTo(&record);
   return log->AddRecord(record);
 }
 
+bool VersionSet::PickRangeDeletions(SequenceNumber smallest_snapshot,
+                                    const bool* busy_levels,
+                                    VersionEdit* edit) const {
+  const Version* v = current_;
+  if (v->range_tombstones_.empty()) {
+    return false;
+  }
+  const Comparator* ucmp = icmp_.user_comparator();
+  bool found = false;
+
+  // Drop the files that lie inside a tombstone and only hold older entries.
+  std::set<uint64_t> dropped;
+  for (int level = 0; level < config::kNumLevels; level++) {
+    if (busy_levels != nullptr && busy_levels[level]) {
+      continue;
+    }
+    for (FileMetaData* f : v->files_[level]) {
+      for (const RangeTombstone& t : v->range_tombstones_) {
+        if (t.sequence <= smallest_snapshot &&
+            f->largest_sequence < t.sequence &&
+            ucmp->Compare(f->smallest.user_key(), t.begin) >= 0 &&
+            ucmp->Compare(f->largest.user_key(), t.end) < 0) {
+          found = true;
+          dropped.insert(f->number);
+          if (edit != nullptr) {
+            edit->RemoveFile(level, f->number);
+          }
+          break;
+        }
+      }
+    }
+  }
+
+  // Drop the tombstones that no remaining file holds older entries for.
+  // Newer memtables only hold newer entries, since a tombstone only gets
+  // here once its memtable and all older ones have been flushed.
+  for (const RangeTombstone& t : v->range_tombstones_) {
+    bool needed = false;
+    for (int level = 0; level < config::kNumLevels && !needed; level++) {
+      for (FileMetaData* f : v->files_[level]) {
+        if (f->smallest_sequence < t.sequence &&
+            dropped.count(f->number) == 0 &&
+            ucmp->Compare(f->smallest.user_key(), t.end) < 0 &&
+            ucmp->Compare(f->largest.user_key(), t.begin) >= 0) {
+          needed = true;
+          break;
+        }
+      }
+    }
+    if (!needed) {
+      found = true;
+      if (edit != nullptr) {
+        edit->RemoveRangeTombstone(t.sequence);
+      }
+    }
+  }
+  return found;
+}
+
 int VersionSet::NumLevelFiles(int level) const {
   assert(level >= 0);
   assert(level < config::kNumLevels);
@@ -1225,6 +1593,7 @@ void VersionSet::AddLiveFiles(std::set<uint64_t>* live) {
       const std::vector<FileMetaData*>& files = v->files_[level];
       for (size_t i = 0; i < files.size(); i++) {
         live->insert(files[i]->number);
+        live->insert(files[i]->blob_files.begin(), files[i]->blob_files.end());
       }
     }
   }
@@ -1326,18 +1695,46 @@ Iterator* VersionSet::MakeInputIterator(Compaction* c) {
  * @brief 选取需要compact的SSTable
  * @return {*}
  */
-Compaction* VersionSet::PickCompaction() {
+int VersionSet::SizeCompactionLevel(const bool* busy_levels) const {
+  if (busy_levels == nullptr) {
+    return (current_->compaction_score_ >= 1) ? current_->compaction_level_
+                                              : -1;
+  }
+  int best_level = -1;
+  double best_score = -1;
+  for (int level = 0; level < config::kNumLevels - 1; level++) {
+    const double score = current_->compaction_scores_[level];
+    if (score >= 1 && score > best_score && !busy_levels[level] &&
+        !busy_levels[level + 1]) {
+      best_level = level;
+      best_score = score;
+    }
+  }
+  return best_level;
+}
+
+bool VersionSet::SeekCompactionAllowed(const bool* busy_levels) const {
+  if (current_->file_to_compact_ == nullptr) {
+    return false;
+  }
+  const int level = current_->file_to_compact_level_;
+  return busy_levels == nullptr ||
+         (!busy_levels[level] && !busy_levels[level + 1]);
+}
+
+Compaction* VersionSet::PickCompaction(const bool* busy_levels) {
   Compaction* c;
   int level;
 
   // We prefer compactions triggered by too much data in a level over
   // the compactions triggered by seeks.
   // 每个level的总文件大小超过一定阈值，则会触发。
-  const bool size_compaction = (current_->compaction_score_ >= 1);
+  const int size_level = SizeCompactionLevel(busy_levels);
+  const bool size_compaction = (size_level >= 0);
   // 如果一个文件的 seek miss 次数超过阈值，则会触发
-  const bool seek_compaction = (current_->file_to_compact_ != nullptr);
+  const bool seek_compaction = SeekCompactionAllowed(busy_levels);
   if (size_compaction) {
-    level = current_->compaction_level_;
+    level = size_level;
     assert(level >= 0);
     assert(level + 1 < config::kNumLevels);
     c = new Compaction(options_, level);
@@ -1563,12 +1960,12 @@ Compaction* VersionSet::CompactRange(int level, const InternalKey* begin,
 Compaction::Compaction(const Options* options, int level)
     : level_(level),
       max_output_file_size_(MaxFileSizeForLevel(options, level)),
-      input_version_(nullptr),
-      grandparent_index_(0),
-      seen_key_(false),
-      overlapped_bytes_(0) {
+      input_version_(nullptr) {}
+
+Compaction::Cursor::Cursor()
+    : grandparent_index(0), seen_key(false), overlapped_bytes(0) {
   for (int i = 0; i < config::kNumLevels; i++) {
-    level_ptrs_[i] = 0;
+    level_ptrs[i] = 0;
   }
 }
 
@@ -1596,13 +1993,14 @@ void Compaction::AddInputDeletions(VersionEdit* edit) {
   }
 }
 
-bool Compaction::IsBaseLevelForKey(const Slice& user_key) {
+bool Compaction::IsBaseLevelForKey(const Slice& user_key,
+                                   Cursor* cursor) const {
   // Maybe use binary search to find right entry instead of linear search?
   const Comparator* user_cmp = input_version_->vset_->icmp_.user_comparator();
   for (int lvl = level_ + 2; lvl < config::kNumLevels; lvl++) {
     const std::vector<FileMetaData*>& files = input_version_->files_[lvl];
-    while (level_ptrs_[lvl] < files.size()) {
-      FileMetaData* f = files[level_ptrs_[lvl]];
+    while (cursor->level_ptrs[lvl] < files.size()) {
+      FileMetaData* f = files[cursor->level_ptrs[lvl]];
       if (user_cmp->Compare(user_key, f->largest.user_key()) <= 0) {
         // We've advanced far enough
         if (user_cmp->Compare(user_key, f->smallest.user_key()) >= 0) {
@@ -1611,36 +2009,74 @@ bool Compaction::IsBaseLevelForKey(const Slice& user_key) {
         }
         break;
       }
-      level_ptrs_[lvl]++;
+      cursor->level_ptrs[lvl]++;
     }
   }
   return true;
 }
 
-bool Compaction::ShouldStopBefore(const Slice& internal_key) {
+bool Compaction::ShouldStopBefore(const Slice& internal_key,
+                                  Cursor* cursor) const {
   const VersionSet* vset = input_version_->vset_;
   // Scan to find earliest grandparent file that contains key.
   const InternalKeyComparator* icmp = &vset->icmp_;
-  while (grandparent_index_ < grandparents_.size() &&
-         icmp->Compare(internal_key,
-                       grandparents_[grandparent_index_]->largest.Encode()) >
-             0) {
-    if (seen_key_) {
-      overlapped_bytes_ += grandparents_[grandparent_index_]->file_size;
+  while (cursor->grandparent_index < grandparents_.size() &&
+         icmp->Compare(
+             internal_key,
+             grandparents_[cursor->grandparent_index]->largest.Encode()) > 0) {
+    if (cursor->seen_key) {
+      cursor->overlapped_bytes +=
+          grandparents_[cursor->grandparent_index]->file_size;
     }
-    grandparent_index_++;
+    cursor->grandparent_index++;
   }
-  seen_key_ = true;
+  cursor->seen_key = true;
 
-  if (overlapped_bytes_ > MaxGrandParentOverlapBytes(vset->options_)) {
+  if (cursor->overlapped_bytes > MaxGrandParentOverlapBytes(vset->options_)) {
     // Too much overlap for current output; start new output
-    overlapped_bytes_ = 0;
+    cursor->overlapped_bytes = 0;
     return true;
   } else {
     return false;
   }
 }
 
+void Compaction::GetSubcompactionBoundaries(
+    int max_parts, std::vector<std::string>* boundaries) const {
+  boundaries->clear();
+  const Comparator* user_cmp = input_version_->vset_->icmp_.user_comparator();
+  // Candidate boundaries are the largest keys of the input files; the
+  // range ending at a candidate is weighed by the files that end there.
+  std::vector<std::pair<Slice, uint64_t>> ends;
+  uint64_t total_bytes = 0;
+  for (int which = 0; which < 2; which++) {
+    for (FileMetaData* f : inputs_[which]) {
+      ends.emplace_back(f->largest.user_key(), f->file_size);
+      total_bytes += f->file_size;
+    }
+  }
+  std::sort(ends.begin(), ends.end(),
+            [user_cmp](const std::pair<Slice, uint64_t>& a,
+                       const std::pair<Slice, uint64_t>& b) {
+              return user_cmp->Compare(a.first, b.first) < 0;
+            });
+
+  uint64_t bytes = 0;
+  for (size_t i = 0; i + 1 < ends.size(); i++) {
+    bytes += ends[i].second;
+    const uint64_t parts = boundaries->size() + 1;
+    if (parts >= static_cast<uint64_t>(max_parts)) {
+      break;
+    }
+    if (bytes * max_parts >= total_bytes * parts &&
+        user_cmp->Compare(ends[i].first, ends.back().first) < 0 &&
+        (boundaries->empty() ||
+         user_cmp->Compare(ends[i].first, boundaries->back()) > 0)) {
+      boundaries->push_back(ends[i].first.ToString());
+    }
+  }
+}
+
 void Compaction::ReleaseInputs() {
   if (input_version_ != nullptr) {
     input_version_->Unref();
@@ -57,6 +57,13 @@ bool SomeFileOverlapsRange(const InternalKeyComparator& icmp,
                            const Slice* smallest_user_key,
                            const Slice* largest_user_key);
 
+// A sorted run is a sequence of table files with disjoint key ranges in
+// key order: either a single level-0 file or all the files of a level > 0.
+struct SortedRun {
+  int level;
+  std::vector<FileMetaData*> files;
+};
+
 class Version {
  public:
   struct GetStats {
@@ -72,11 +79,38 @@ class Version {
   // 要求：此版本已保存(see VersionSet::SaveTo)
   void AddIterators(const ReadOptions&, std::vector<Iterator*>* iters);
 
+  // Store in "*runs" the sorted runs of this Version, in the same order as
+  // the iterators produced by AddIterators().  The FileMetaData pointers
+  // stay valid for as long as this Version is live.
+  void GetSortedRuns(std::vector<SortedRun>* runs) const;
+
   // Lookup the value for key.  If found, store it in *val and
-  // return OK.  Else return a non-OK status.  Fills *stats.
+  // return OK.  Else return a non-OK status.  Fills *stats.  Entries older
+  // than "deleted_before" are treated as deletions (see MemTable::Get()).
   // REQUIRES: lock is not held
   Status Get(const ReadOptions&, const LookupKey& key, std::string* val,
-             GetStats* stats);
+             GetStats* stats, SequenceNumber deleted_before);
+
+  // One key looked up by MultiGet()
+  struct KeyLookup {
+    const LookupKey* key;
+    std::string* value;
+    Status status;
+    bool done;  // The search for the key is over
+    GetStats stats;
+    SequenceNumber deleted_before;  // See Get()
+
+    // Last file searched for the key, used to fill "stats"
+    FileMetaData* last_file_read;
+    int last_file_read_level;
+  };
+
+  // Like Get() for every entry of "lookups" that is not done yet, storing
+  // the result in its value and status and marking it done.  The entries
+  // must be sorted by user key.  Each table file is searched once for all
+  // of the keys that may be in it.
+  // REQUIRES: lock is not held
+  void MultiGet(const ReadOptions&, const std::vector<KeyLookup*>& lookups);
 
   // Adds "stats" into the current state.  Returns true if a new
   // compaction may need to be triggered, false otherwise.
@@ -113,8 +147,34 @@ class Version {
   int PickLevelForMemTableOutput(const Slice& smallest_user_key,
                                  const Slice& largest_user_key);
 
+  // Return the deepest level at which a new file of entries newer than all
+  // others in [smallest_user_key,largest_user_key] may be placed: no
+  // shallower level overlaps the range, and no compaction writes into the
+  // level (see VersionSet::PickCompaction() for "busy_levels").
+  int PickLevelForExternalFile(const Slice& smallest_user_key,
+                               const Slice& largest_user_key,
+                               const bool* busy_levels);
+
+  // Returns true iff some file or range tombstone of this version overlaps
+  // some part of [smallest_user_key,largest_user_key].
+  bool OverlapInAnyLevel(const Slice& smallest_user_key,
+                         const Slice& largest_user_key);
+
   int NumFiles(int level) const { return files_[level].size(); }
 
+  // Returns true iff some table file of this version refers to a blob file.
+  bool HasBlobFiles() const;
+
+  // Add the numbers of the blob files that the table files of this version
+  // refer to to *blob_files.
+  void AddBlobFiles(std::set<uint64_t>* blob_files) const;
+
+  // Return the range tombstones flushed from memtables that may still
+  // cover entries in the table files of this version.
+  const std::vector<RangeTombstone>& range_tombstones() const {
+    return range_tombstones_;
+  }
+
   // Return a human readable string that describes this version's contents.
   std::string DebugString() const;
 
@@ -132,7 +192,12 @@ class Version {
         file_to_compact_(nullptr),
         file_to_compact_level_(-1),
         compaction_score_(-1),
-        compaction_level_(-1) {}
+        compaction_level_(-1),
+        pending_compaction_bytes_(0) {
+    for (int level = 0; level < config::kNumLevels - 1; level++) {
+      compaction_scores_[level] = -1;
+    }
+  }
 
   Version(const Version&) = delete;
   Version& operator=(const Version&) = delete;
@@ -157,6 +222,9 @@ class Version {
   // List of files per level
   std::vector<FileMetaData*> files_[config::kNumLevels];
 
+  // Range tombstones, in the order they were added
+  std::vector<RangeTombstone> range_tombstones_;
+
   // Next file to compact based on seek stats.
   FileMetaData* file_to_compact_; // 下次需要进行Compaction操作的文件
   int file_to_compact_level_; // 下次需要进行Compaction操作的文件所属层级
@@ -166,6 +234,13 @@ class Version {
   // are initialized by Finalize().
   double compaction_score_; // 如果大于1，则说明需要进行一次Compaction操作
   int compaction_level_;  // 需要进行Compaction操作的层级
+
+  // Compaction score of every level that has a next level
+  double compaction_scores_[config::kNumLevels - 1];
+
+  // Bytes by which the levels exceed their compaction triggers, as
+  // computed by Finalize()
+  uint64_t pending_compaction_bytes_;
 };
 
 class VersionSet {
@@ -231,11 +306,19 @@ class VersionSet {
   // being compacted, or zero if there is no such log file.
   uint64_t PrevLogNumber() const { return prev_log_number_; }
 
+  // Return the number of the persisted REMIX file, or zero if there is none.
+  uint64_t RemixFileNumber() const { return remix_file_number_; }
+
   // Pick level and inputs for a new compaction.
   // Returns nullptr if there is no compaction to be done.
   // Otherwise returns a pointer to a heap-allocated object that
   // describes the compaction.  Caller should delete the result.
-  Compaction* PickCompaction();
+  Compaction* PickCompaction() { return PickCompaction(nullptr); }
+
+  // Like PickCompaction(), but never picks a compaction that reads or
+  // writes a level for which busy_levels[level] is true.  A null
+  // "busy_levels" means that no level is busy.
+  Compaction* PickCompaction(const bool* busy_levels);
 
   // Return a compaction object for compacting the range [begin,end] in
   // the specified level.  Returns nullptr if there is nothing in that
@@ -258,6 +341,26 @@ class VersionSet {
     return (v->compaction_score_ >= 1) || (v->file_to_compact_ != nullptr);
   }
 
+  // Return an estimate of the bytes that compactions have to write to
+  // bring every level of the current version within its size limit.
+  uint64_t PendingCompactionBytes() const {
+    return current_->pending_compaction_bytes_;
+  }
+
+  // Add to *edit the removal of every table file outside the busy levels
+  // whose entries are all deleted by a range tombstone that every snapshot
+  // sees, and of every range tombstone that no longer covers an older
+  // entry in the remaining files.  Returns true iff there was anything to
+  // remove.  "edit" may be nullptr to only check.
+  bool PickRangeDeletions(SequenceNumber smallest_snapshot,
+                          const bool* busy_levels, VersionEdit* edit) const;
+
+  // Returns true iff PickCompaction(busy_levels) would pick a compaction.
+  bool NeedsCompaction(const bool* busy_levels) const {
+    return SizeCompactionLevel(busy_levels) >= 0 ||
+           SeekCompactionAllowed(busy_levels);
+  }
+
   // Add all files listed in any live version to *live.
   // May also mutate some internal state.
   void AddLiveFiles(std::set<uint64_t>* live);
@@ -283,6 +386,15 @@ class VersionSet {
 
   void Finalize(Version* v);
 
+  // Return the level with the highest compaction score >= 1 among those
+  // that are not busy and whose next level is not busy, or -1 if there is
+  // none.
+  int SizeCompactionLevel(const bool* busy_levels) const;
+
+  // Returns true iff current_ has a file to compact because of seeks, and
+  // neither its level nor the next one is busy.
+  bool SeekCompactionAllowed(const bool* busy_levels) const;
+
   void GetRange(const std::vector<FileMetaData*>& inputs, InternalKey* smallest,
                 InternalKey* largest);
 
@@ -307,6 +419,7 @@ class VersionSet {
   uint64_t last_sequence_;  // 当前最大的写入序列号
   uint64_t log_number_;  // Log文件的文件序列号
   uint64_t prev_log_number_;  // 0 or backing store for memtable being compacted
+  uint64_t remix_file_number_;  // 0 or the persisted REMIX sorted view
 
   // Opened lazily
   WritableFile* descriptor_file_;
@@ -322,6 +435,28 @@ class VersionSet {
 // A Compaction encapsulates information about a compaction.
 class Compaction {
  public:
+  // Position of a pass over the keys of the compaction in increasing
+  // order, as tracked by IsBaseLevelForKey() and ShouldStopBefore().
+  // Passes over disjoint key ranges each need their own cursor.
+  struct Cursor {
+    Cursor();
+
+    // State used to check for number of overlapping grandparent files
+    // (parent == level_ + 1, grandparent == level_ + 2)
+    size_t grandparent_index;  // Index in grandparents_
+    bool seen_key;             // Some output key has been seen
+    int64_t overlapped_bytes;  // Bytes of overlap between current output
+                               // and grandparent files
+
+    // State for implementing IsBaseLevelForKey
+
+    // level_ptrs holds indices into input_version_->levels_: our state
+    // is that we are positioned at one of the file ranges for each
+    // higher level than the ones involved in this compaction (i.e. for
+    // all L >= level_ + 2).
+    size_t level_ptrs[config::kNumLevels];
+  };
+
   ~Compaction();
 
   // Return the level that is being compacted.  Inputs from "level"
@@ -351,11 +486,23 @@ class Compaction {
   // Returns true if the information we have available guarantees that
   // the compaction is producing data in "level+1" for which no data exists
   // in levels greater than "level+1".
-  bool IsBaseLevelForKey(const Slice& user_key);
+  bool IsBaseLevelForKey(const Slice& user_key) {
+    return IsBaseLevelForKey(user_key, &cursor_);
+  }
+  bool IsBaseLevelForKey(const Slice& user_key, Cursor* cursor) const;
 
   // Returns true iff we should stop building the current output
   // before processing "internal_key".
-  bool ShouldStopBefore(const Slice& internal_key);
+  bool ShouldStopBefore(const Slice& internal_key) {
+    return ShouldStopBefore(internal_key, &cursor_);
+  }
+  bool ShouldStopBefore(const Slice& internal_key, Cursor* cursor) const;
+
+  // Store in *boundaries up to "max_parts - 1" user keys, in increasing
+  // order, that split the inputs at file boundaries into key ranges of
+  // about equal size.
+  void GetSubcompactionBoundaries(int max_parts,
+                                  std::vector<std::string>* boundaries) const;
 
   // Release the input version for the compaction, once the compaction
   // is successful.
@@ -375,21 +522,11 @@ class Compaction {
   // Each compaction reads inputs from "level_" and "level_+1"
   std::vector<FileMetaData*> inputs_[2];  // The two sets of inputs
 
-  // State used to check for number of overlapping grandparent files
-  // (parent == level_ + 1, grandparent == level_ + 2)
+  // Files of level_ + 2 that overlap the inputs
   std::vector<FileMetaData*> grandparents_;
-  size_t grandparent_index_;  // Index in grandparent_starts_
-  bool seen_key_;             // Some output key has been seen
-  int64_t overlapped_bytes_;  // Bytes of overlap between current output
-                              // and grandparent files
-
-  // State for implementing IsBaseLevelForKey
-
-  // level_ptrs_ holds indices into input_version_->levels_: our state
-  // is that we are positioned at one of the file ranges for each
-  // higher level than the ones involved in this compaction (i.e. for
-  // all L >= level_ + 2).
-  size_t level_ptrs_[config::kNumLevels];
+
+  // Cursor of a pass over all keys of the compaction
+  Cursor cursor_;
 };
 
 }  // namespace leveldb
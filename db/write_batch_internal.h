@@ -37,6 +37,11 @@ class WriteBatchInternal {
 
   static Status InsertInto(const WriteBatch* batch, MemTable* memtable);
 
+  // Like InsertInto(), but other threads may insert other batches into
+  // "memtable" at the same time with ConcurrentInsertInto().
+  static Status ConcurrentInsertInto(const WriteBatch* batch,
+                                     MemTable* memtable);
+
   static void Append(WriteBatch* dst, const WriteBatch* src);
 };
 
@@ -7,6 +7,8 @@
 
 #include <cstdint>
 #include <cstdio>
+#include <string>
+#include <vector>
 
 #include "leveldb/export.h"
 #include "leveldb/iterator.h"
@@ -18,6 +20,7 @@ namespace leveldb {
 static const int kMajorVersion = 1;
 static const int kMinorVersion = 23;
 
+struct IngestExternalFileOptions;
 struct Options;
 struct ReadOptions;
 struct WriteOptions;
@@ -72,11 +75,31 @@ class LEVELDB_EXPORT DB {
   // Note: consider setting options.sync = true.
   virtual Status Delete(const WriteOptions& options, const Slice& key) = 0;
 
+  // Remove the database entries (if any) for all keys in ["begin", "end").
+  // Returns OK on success, and a non-OK status on error.  This writes a
+  // single range tombstone, so it costs the same for any number of keys;
+  // the deleted entries are dropped by later compactions, which delete
+  // table files that only hold deleted entries as a whole.
+  // Note: consider setting options.sync = true.
+  virtual Status DeleteRange(const WriteOptions& options, const Slice& begin,
+                             const Slice& end);
+
   // Apply the specified updates to the database.
   // Returns OK on success, non-OK on failure.
   // Note: consider setting options.sync = true.
   virtual Status Write(const WriteOptions& options, WriteBatch* updates) = 0;
 
+  // Add the entries of the table file "fname", written by an SstFileWriter
+  // with the options of this database, as if by one Write() that is newer
+  // than all earlier writes.  The file is placed at the deepest level
+  // whose key range it can join, so its entries are not compacted again
+  // and again.  If the database holds no entry and no snapshot its entries
+  // must be newer than, the file is copied or moved into the database as
+  // is; otherwise it is rewritten with a new sequence number, and
+  // memtables that overlap it are flushed first.  Writes wait meanwhile.
+  virtual Status IngestExternalFile(const IngestExternalFileOptions& options,
+                                    const std::string& fname);
+
   // If the database contains an entry for "key" store the
   // corresponding value in *value and return OK.
   //
@@ -87,6 +110,16 @@ class LEVELDB_EXPORT DB {
   virtual Status Get(const ReadOptions& options, const Slice& key,
                      std::string* value) = 0;
 
+  // Look up every key of "keys" as Get() does, all in the same snapshot,
+  // and return one status per key.  values->size() is set to keys.size(),
+  // and (*values)[i] holds the value of keys[i] if the i-th status is OK.
+  //
+  // This is faster than calling Get() for each key, since every table file
+  // is opened and its index searched once for all of the keys in it.
+  virtual std::vector<Status> MultiGet(const ReadOptions& options,
+                                       const std::vector<Slice>& keys,
+                                       std::vector<std::string>* values);
+
   // Return a heap-allocated iterator over the contents of the database.
   // The result of NewIterator() is initially invalid (caller must
   // call one of the Seek methods on the iterator before using it).
@@ -121,6 +154,14 @@ class LEVELDB_EXPORT DB {
   //     of the sstables that make up the db contents.
   //  "leveldb.approximate-memory-usage" - returns the approximate number of
   //     bytes of memory in use by the DB.
+  //  "leveldb.num-immutable-memtables" - returns the number of full
+  //     memtables waiting to be written to disk.
+  //  "leveldb.remix-memory-usage" - returns the approximate number of bytes
+  //     of memory held by the REMIX view of the DB, or 0 if it has none.
+  //  "leveldb.rate-limiter-bytes-per-second" - returns the rate currently
+  //     enforced by Options::rate_limiter.
+  //  "leveldb.rate-limiter-throttled-bytes" - returns the number of bytes
+  //     whose write had to wait for Options::rate_limiter.
   virtual bool GetProperty(const Slice& property, std::string* value) = 0;
 
   // For each i in [0,n-1], store in "sizes[i]", the approximate
@@ -16,6 +16,8 @@ class Comparator;
 class Env;
 class FilterPolicy;
 class Logger;
+class RateLimiter;
+class SliceTransform;
 class Snapshot;
 
 // DB contents are stored in a set of blocks, each of which holds a
@@ -81,6 +83,28 @@ struct LEVELDB_EXPORT Options {
   // the next time the database is opened.
   size_t write_buffer_size = 4 * 1024 * 1024;
 
+  // Number of full write buffers that may wait to be written to disk.
+  // Writes only stall once this many are waiting, so a larger value
+  // absorbs longer write bursts, at the cost of memory and of longer
+  // recovery.  A flush writes all waiting buffers into one level-0 file.
+  int max_immutable_memtables = 1;
+
+  // Number of compactions that may run at the same time.  Compactions
+  // only run concurrently if they read and write disjoint levels.  Full
+  // write buffers are flushed on a thread of their own, so flushes never
+  // wait for a compaction to finish.
+  int max_background_compactions = 1;
+
+  // Number of threads that may share the work of one compaction.  Larger
+  // compactions are split into key ranges at input file boundaries, and
+  // every range is merged into its own output files on its own thread.
+  int max_subcompactions = 1;
+
+  // If non-null, the writes of memtable flushes and compactions to table
+  // files are throttled by this limiter, and the writes to the log are
+  // accounted to it (see leveldb/rate_limiter.h).
+  RateLimiter* rate_limiter = nullptr;
+
   // Number of open files that can be used by the DB.  You may need to
   // increase this if your database has a large working set (budget
   // one open file per 2MB of working set).
@@ -136,10 +160,64 @@ struct LEVELDB_EXPORT Options {
   // Default: currently false, but may become true later.
   bool reuse_logs = false;
 
+  // If true, the writers whose batches are committed together by one log
+  // write each insert their own batch into the memtable, in parallel,
+  // instead of leaving every insert to the first writer of the group.  This
+  // lets write throughput grow with the number of writing threads.
+  bool allow_concurrent_memtable_write = false;
+
+  // If true, a write group is inserted into the memtable while the next
+  // group already appends to the log, instead of holding the log until the
+  // insert is done.  Writes still become visible in sequence order.  This
+  // lowers the latency of small writes, in particular synchronous ones.
+  bool enable_pipelined_write = false;
+
   // If non-null, use the specified filter policy to reduce disk reads.
   // Many applications will benefit from passing the result of
   // NewBloomFilterPolicy() here.
   const FilterPolicy* filter_policy = nullptr;
+
+  // If non-null and filter_policy is non-null, the filters also hold the
+  // prefixes of the keys, as extracted by this transform, so that
+  // iterators with ReadOptions::prefix_same_as_start can skip the table
+  // files and blocks without keys of the prefix they seek.  The filters
+  // of tables written with another transform, or none, are not used.
+  const SliceTransform* prefix_extractor = nullptr;
+
+  // If true, the DB keeps a REMIX sorted view over its table files and
+  // serves NewIterator() from it, merging in only the memtables, which
+  // avoids comparing keys across files during seeks and scans.  While the
+  // view has not caught up with a flush or compaction, iterators use the
+  // regular merging path.  The view is loaded or built when the DB is
+  // opened and maintained by the background compactions.
+  bool use_remix = false;
+
+  // Number of entries per segment of the REMIX view.  Smaller segments
+  // make seeks faster and the view larger.
+  int remix_segment_size = 32;
+
+  // Number of threads that build a REMIX view from scratch, each merging
+  // the key range between some table file boundaries.  Incremental updates
+  // after flushes and compactions always run on the background thread.
+  int remix_build_threads = 1;
+
+  // Approximate number of bytes the REMIX view may use.  If non-zero, the
+  // segments rebuilt after flushes and compactions are sized per key range
+  // from the seeks sampled on the view: ranges with many seeks and short
+  // scans get short segments, the others long ones, so that the view fits
+  // in the budget.  Zero keeps every segment at remix_segment_size entries.
+  size_t remix_memory_budget = 0;
+
+  // If non-zero, values of at least this many bytes are moved out of the
+  // table files into blob files when memtables are flushed, so that
+  // compactions only rewrite a small reference to them.  Reading such a
+  // value costs one more file read.  Zero keeps all values in the tables.
+  size_t blob_value_threshold = 0;
+
+  // Fraction of the blob files, oldest first, whose values compactions
+  // move to new blob files, which lets the space of overwritten and
+  // deleted values be reclaimed once no table refers to the old files.
+  double blob_gc_age_cutoff = 0.25;
 };
 
 // Options that control read operations
@@ -157,6 +235,21 @@ struct LEVELDB_EXPORT ReadOptions {
   // not have been released).  If "snapshot" is null, use an implicit
   // snapshot of the state at the beginning of this read operation.
   const Snapshot* snapshot = nullptr;
+
+  // If true and Options::prefix_extractor is set, an iterator that is
+  // positioned by Seek() on a key with a prefix only yields the keys with
+  // the same prefix, and skips the table files and blocks that the
+  // filters show to hold none.  Prev() and SeekToLast() are not
+  // supported: they leave the iterator invalid with a non-ok status.
+  bool prefix_same_as_start = false;
+};
+
+// Options that control DB::IngestExternalFile()
+struct LEVELDB_EXPORT IngestExternalFileOptions {
+  // If true, a file whose entries need no new sequence numbers is moved
+  // into the database instead of being copied.  Files that are rewritten
+  // with new sequence numbers are left in place either way.
+  bool move_files = false;
 };
 
 // Options that control write operations
@@ -0,0 +1,65 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+//
+// A RateLimiter bounds the rate at which a DB writes table files, so that
+// memtable flushes and compactions do not take all of the device's write
+// bandwidth from foreground reads and writes.  Set Options::rate_limiter to
+// use one; a single limiter may be shared by several DBs to bound their
+// combined rate.
+//
+// Most people will want to use the builtin token bucket (see
+// NewRateLimiter() below).
+
+#ifndef STORAGE_LEVELDB_INCLUDE_RATE_LIMITER_H_
+#define STORAGE_LEVELDB_INCLUDE_RATE_LIMITER_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "leveldb/export.h"
+
+namespace leveldb {
+
+class LEVELDB_EXPORT RateLimiter {
+ public:
+  virtual ~RateLimiter();
+
+  // Block until "bytes" more bytes may be written.  Flushes and compactions
+  // call this before writing every block of a table file.
+  virtual void Request(size_t bytes) = 0;
+
+  // Account for "bytes" written by a caller that must not wait, such as a
+  // write to the log.  Later Request() calls wait for them instead.
+  virtual void Charge(size_t bytes) = 0;
+
+  // Tell the limiter how many bytes compactions still have to write to
+  // bring every level within its size limit.  The DB calls this whenever
+  // its tables change; auto-tuned limiters derive their rate from it.
+  virtual void SetPendingCompactionBytes(uint64_t bytes) = 0;
+
+  // Return the rate that is currently enforced.
+  virtual int64_t GetBytesPerSecond() const = 0;
+
+  // Return the number of bytes passed to Request() and Charge().
+  virtual uint64_t GetTotalBytesThrough() const = 0;
+
+  // Return the number of bytes passed to Request() calls that had to wait.
+  virtual uint64_t GetTotalBytesThrottled() const = 0;
+};
+
+// Return a new rate limiter that lets up to "bytes_per_second" bytes
+// through every second, with bursts of up to a tenth of a second's worth.
+//
+// If "auto_tuned" is true, "bytes_per_second" is only the upper bound: the
+// rate drops to a twentieth of it while compactions keep up, and rises
+// with the pending compaction bytes to the full rate once they would take
+// ten seconds to write at that rate.
+//
+// Callers must delete the result after every DB that uses it is closed.
+LEVELDB_EXPORT RateLimiter* NewRateLimiter(int64_t bytes_per_second,
+                                           bool auto_tuned = false);
+
+}  // namespace leveldb
+
+#endif  // STORAGE_LEVELDB_INCLUDE_RATE_LIMITER_H_
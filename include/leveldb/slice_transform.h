@@ -0,0 +1,51 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+//
+// A SliceTransform extracts the prefix of a key.  A database configured
+// with Options::prefix_extractor adds the prefixes of its keys to the
+// filters of its table files, which lets iterators that only want keys
+// of one prefix (see ReadOptions::prefix_same_as_start) skip the tables
+// and blocks that hold none.
+
+#ifndef STORAGE_LEVELDB_INCLUDE_SLICE_TRANSFORM_H_
+#define STORAGE_LEVELDB_INCLUDE_SLICE_TRANSFORM_H_
+
+#include <cstddef>
+
+#include "leveldb/export.h"
+#include "leveldb/slice.h"
+
+namespace leveldb {
+
+class LEVELDB_EXPORT SliceTransform {
+ public:
+  virtual ~SliceTransform();
+
+  // Return the name of this transform.  The name is recorded along with
+  // the filters of table files, so it must change whenever the prefixes
+  // returned by Transform() change.
+  virtual const char* Name() const = 0;
+
+  // Return the prefix of "key", which must point into "key".
+  // REQUIRES: InDomain(key)
+  virtual Slice Transform(const Slice& key) const = 0;
+
+  // Returns true iff "key" has a prefix.
+  virtual bool InDomain(const Slice& key) const = 0;
+};
+
+// Return a new transform whose prefix of a key is its first "prefix_len"
+// bytes.  Keys that are shorter have no prefix.
+//
+// The keys that share a prefix must be adjacent in the order of the
+// comparator, as they are for BytewiseComparator() and this transform.
+//
+// Callers must delete the result after any database that is using the
+// result has been closed.
+LEVELDB_EXPORT const SliceTransform* NewFixedPrefixTransform(
+    size_t prefix_len);
+
+}  // namespace leveldb
+
+#endif  // STORAGE_LEVELDB_INCLUDE_SLICE_TRANSFORM_H_
@@ -0,0 +1,79 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+//
+// SstFileWriter writes a table file that DB::IngestExternalFile() can add
+// to a database, which bypasses the log, the memtable and the compactions
+// that loading the same entries through DB::Write() would go through.
+//
+// Multiple threads can invoke const methods on an SstFileWriter without
+// external synchronization, but if any of the threads may call a
+// non-const method, all threads accessing the same SstFileWriter must use
+// external synchronization.
+
+#ifndef STORAGE_LEVELDB_INCLUDE_SST_FILE_WRITER_H_
+#define STORAGE_LEVELDB_INCLUDE_SST_FILE_WRITER_H_
+
+#include <cstdint>
+#include <string>
+
+#include "leveldb/export.h"
+#include "leveldb/options.h"
+#include "leveldb/slice.h"
+#include "leveldb/status.h"
+
+namespace leveldb {
+
+class LEVELDB_EXPORT SstFileWriter {
+ public:
+  // Create a writer for files that will be ingested into a database
+  // opened with "options".  The comparator, the filter policy, the prefix
+  // extractor and the table format options must match those of the
+  // database.
+  explicit SstFileWriter(const Options& options);
+
+  SstFileWriter(const SstFileWriter&) = delete;
+  SstFileWriter& operator=(const SstFileWriter&) = delete;
+
+  // Abandons the file being written, if any.
+  ~SstFileWriter();
+
+  // Start writing a new file named "fname", replacing any existing file.
+  // REQUIRES: No file is being written
+  Status Open(const std::string& fname);
+
+  // Add "key" with "value" to the file.  Returns a non-OK status if "key"
+  // does not come after all previously added keys, in the order of the
+  // comparator.
+  // REQUIRES: Open() has succeeded and Finish() has not been called
+  Status Put(const Slice& key, const Slice& value);
+
+  // Add a deletion of "key" to the file, which hides the entry for "key"
+  // that the database holds when the file is ingested.  The same ordering
+  // rule as for Put() applies.
+  // REQUIRES: Open() has succeeded and Finish() has not been called
+  Status Delete(const Slice& key);
+
+  // Finish writing the file and sync it.  A finished writer may Open()
+  // another file.
+  // REQUIRES: Open() has succeeded and Finish() has not been called
+  Status Finish();
+
+  // Number of entries added to the current file.
+  uint64_t NumEntries() const;
+
+  // Size of the file written so far, which is its final size once
+  // Finish() has returned.
+  uint64_t FileSize() const;
+
+ private:
+  struct Rep;
+
+  Status Add(const Slice& key, const Slice& value, bool deletion);
+
+  Rep* rep_;
+};
+
+}  // namespace leveldb
+
+#endif  // STORAGE_LEVELDB_INCLUDE_SST_FILE_WRITER_H_
@@ -71,12 +71,23 @@ class LEVELDB_EXPORT Table {
   // be close to the file length.
   uint64_t ApproximateOffsetOf(const Slice& key) const;
 
+  // Returns false if the filter shows that no entry matching "filter_key"
+  // is in the data blocks where an iterator Seek(target) can stop: the
+  // block that the index names for "target" and the block after it.
+  // "target" and "filter_key" are keys of the table's comparator.
+  bool SeekMayMatch(const Slice& target, const Slice& filter_key) const;
+
  private:
   friend class TableCache;
+  friend class RunCursor;
   struct Rep;
 
   static Iterator* BlockReader(void*, const ReadOptions&, const Slice&);
 
+  // Returns a new iterator over the index block.  Each value is the
+  // encoded BlockHandle of a data block.
+  Iterator* NewIndexIterator() const;
+
   explicit Table(Rep* rep) : rep_(rep) {}
 
   // Calls (*handle_result)(arg, ...) with the entry found after a call
@@ -86,6 +97,14 @@ class LEVELDB_EXPORT Table {
                      void (*handle_result)(void* arg, const Slice& k,
                                            const Slice& v));
 
+  // Like InternalGet() for each of the "n" sorted "keys", calling
+  // (*handle_result)(args[i], ...) for keys[i].  Keys that fall into the
+  // same data block share one read of the block.
+  Status InternalMultiGet(const ReadOptions&, int n, const Slice* keys,
+                          void* const* args,
+                          void (*handle_result)(void* arg, const Slice& k,
+                                                const Slice& v));
+
   void ReadMeta(const Footer& footer);
   void ReadFilter(const Slice& filter_handle_value);
 
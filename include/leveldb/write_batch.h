@@ -37,6 +37,9 @@ class LEVELDB_EXPORT WriteBatch {
     virtual ~Handler();
     virtual void Put(const Slice& key, const Slice& value) = 0;
     virtual void Delete(const Slice& key) = 0;
+    // The default implementation ignores range deletions, so that handlers
+    // written before DeleteRange() existed still compile.
+    virtual void DeleteRange(const Slice& begin, const Slice& end);
   };
 
   WriteBatch();
@@ -53,6 +56,11 @@ class LEVELDB_EXPORT WriteBatch {
   // If the database contains a mapping for "key", erase it.  Else do nothing.
   void Delete(const Slice& key);
 
+  // Erase the mappings of all keys in ["begin", "end") that the database
+  // holds at the time the batch is written.  Does nothing if "begin" is
+  // not before "end".
+  void DeleteRange(const Slice& begin, const Slice& end);
+
   // Clear all updates buffered in this batch.
   void Clear();
 
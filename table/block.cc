@@ -22,7 +22,6 @@
 #include "table/format.h"
 #include "util/coding.h"
 #include "util/logging.h"
-#include "leveldb/RemixHelper.h"
 
 namespace leveldb {
 
@@ -83,7 +82,7 @@ static inline const char* DecodeEntry(const char* p, const char* limit,
   return p;
 }
 
-class Block::Iter : public Iterator, public Remix_Helper {
+class Block::Iter : public Iterator {
  private:
   const Comparator* const comparator_;
   const char* const data_;       // 块得内容
@@ -158,10 +157,9 @@ class Block::Iter : public Iterator, public Remix_Helper {
     return value_;
   }
 
-  int Next() override {
+  void Next() override {
     assert(Valid());
     ParseNextKey();
-    return 0;
   }
   
   /**
@@ -272,10 +270,9 @@ class Block::Iter : public Iterator, public Remix_Helper {
     }
   }
 
-  int SeekToFirst() override {
+  void SeekToFirst() override {
     SeekToRestartPoint(0);
     ParseNextKey();
-    return 0;
   }
 /*
 +----------------------------+ <--------+last restart
@@ -11,43 +11,12 @@
 // found in the LICENSE file. See the AUTHORS file for names of contributors.
 
 #include "leveldb/iterator.h"
-#include "leveldb/RemixHelper.h"
-#include "iostream"
-#include "leveldb/Remix.h"
-using namespace std;
-namespace leveldb {
-
-int Iterator::get_index_of_runs(){  // !!!
-  return index_of_runs;
-}
 
-void Iterator::set_index_of_runs(int index){ // !!!
-  assert(index >= 0);
-  index_of_runs = index;
-}
-
-int Iterator::get_runs_num(){  // !!!
-  return runs_num;
-}
-void Iterator::set_runs_num(int num){   // !!!
-    runs_num = num;
-}
-const Comparator * Iterator::get_comparator(){ // ###
-    return cmp_;
-  }
-void Iterator::set_comparator(const Comparator * cmp){ // ###
-    cmp_ = cmp;
-  }
-
-Slice Iterator::KEY(){return Slice();}
-
-void Iterator::Next(Remix* my_sorted_view,size_t &index_anchor_key, size_t &segment_index){};
-  
+namespace leveldb {
 
 Iterator::Iterator() {
   cleanup_head_.function = nullptr;
   cleanup_head_.next = nullptr;
-  set_index_of_runs(0);
 }
 
 Iterator::~Iterator() {
@@ -93,9 +62,9 @@ class EmptyIterator : public Iterator {
 
   bool Valid() const override { return false; }
   void Seek(const Slice& target) override {}
-  int SeekToFirst() override { return 0;}
+  void SeekToFirst() override {}
   void SeekToLast() override {}
-  int Next() override { assert(false); return 0;}
+  void Next() override { assert(false); }
   void Prev() override { assert(false); }
   Slice key() const override {
     assert(false);
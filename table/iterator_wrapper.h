@@ -13,7 +13,6 @@
 #ifndef STORAGE_LEVELDB_TABLE_ITERATOR_WRAPPER_H_
 #define STORAGE_LEVELDB_TABLE_ITERATOR_WRAPPER_H_
 
-#include <iostream>
 #include "leveldb/iterator.h"
 #include "leveldb/slice.h"
 
@@ -64,11 +63,10 @@ class IteratorWrapper {
     assert(iter_);
     return iter_->status();
   }
-  int Next() {
+  void Next() {
     assert(iter_);
     iter_->Next();
     Update();
-    return 0;
   }
   void Prev() {
     assert(iter_);
@@ -80,27 +78,17 @@ class IteratorWrapper {
     iter_->Seek(k);
     Update();
   }
-  int SeekToFirst() { // !!!
+  void SeekToFirst() {
     assert(iter_);
-    set_run_index(iter_->SeekToFirst());
+    iter_->SeekToFirst();
     Update();
-    return get_run_index();
   }
-  void SeekToLast() {  // !!!
+  void SeekToLast() {
     assert(iter_);
     iter_->SeekToLast();
     Update();
   }
 
-  inline void set_run_index (int index) { // !!!
-    assert(index >= 0);
-    run_index = index;
-  }
-
-  inline int get_run_index(){ // !!!
-    return run_index;
-  }
-
  private:
   void Update() {
     valid_ = iter_->Valid();
@@ -113,7 +101,6 @@ class IteratorWrapper {
   Iterator* iter_;
   bool valid_;
   Slice key_;
-  int run_index; // !!!
 };
 
 }  // namespace leveldb
@@ -7,14 +7,12 @@
 #include "leveldb/comparator.h"
 #include "leveldb/iterator.h"
 #include "table/iterator_wrapper.h"
-#include "leveldb/RemixHelper.h"
-#include "leveldb/Remix.h"
 
 namespace leveldb {
 
 namespace {
 
-class MergingIterator : public Iterator, public Remix_Helper {
+class MergingIterator : public Iterator {
  public:
   MergingIterator(const Comparator* comparator, Iterator** children, int n)
       : comparator_(comparator),
@@ -31,13 +29,12 @@ class MergingIterator : public Iterator, public Remix_Helper {
 
   bool Valid() const override { return (current_ != nullptr); }
 
-  int SeekToFirst() override {
+  void SeekToFirst() override {
     for (int i = 0; i < n_; i++) {
       children_[i].SeekToFirst();
     }
-    set_run_index(FindSmallest());
+    FindSmallest();
     direction_ = kForward;
-    return get_run_index();
   }
 
   void SeekToLast() override {
@@ -56,7 +53,7 @@ class MergingIterator : public Iterator, public Remix_Helper {
     direction_ = kForward;
   }
   // 注意：next（）永远找的>key（）的下一个位置，调用后方向一定为kForward
-  int Next() override {
+  void Next() override {
     assert(Valid());
 
     // Ensure that all children are positioned after key().
@@ -84,23 +81,9 @@ class MergingIterator : public Iterator, public Remix_Helper {
     }
 
     current_->Next();
-    set_run_index(FindSmallest());
-    return get_run_index();
+    FindSmallest();
   }
 
-  //##################
-  void Next(Remix *my_sorted_view, size_t &index_anchor_key, size_t &segment_index)  override{
-    assert(Valid());
-
-    current_->Next();
-    int index = FindSmallest(my_sorted_view,index_anchor_key,segment_index);
-    if(index < 0){
-      current_ = nullptr;
-    }
-    else{
-      current_ = &children_[index];
-    }
-  }
   // 注意：next（）永远找的都是<key（）的下一个位置,逻辑与next()类似，且调用了Prev()后，方向一定为kReverse
   void Prev() override {
     assert(Valid());
@@ -157,21 +140,11 @@ class MergingIterator : public Iterator, public Remix_Helper {
     return status;
   }
 
-  void set_run_index(int index) { // !!!
-    assert(index>=0);
-    run_index = index;
-  }
-
-  int get_run_index() {  // !!!
-    return run_index;
-  }
-
  private:
   // Which direction is the iterator moving?
   enum Direction { kForward, kReverse };
 
-  int FindSmallest();
-  int FindSmallest(Remix *my_sorted_view, size_t &index_anchor_key, size_t &segment_index); // ##########
+  void FindSmallest();
   void FindLargest();
 
   // We might want to use a heap in case there are lots of children.
@@ -183,7 +156,6 @@ class MergingIterator : public Iterator, public Remix_Helper {
   int n_;
   IteratorWrapper* current_;
   Direction direction_;
-  int run_index; // !!!
 };
 
 
@@ -191,44 +163,19 @@ class MergingIterator : public Iterator, public Remix_Helper {
  * @brief 遍历整个children_迭代器，找出最小的一个节点，设置为current_
  * @return {*}
  */
-int MergingIterator::FindSmallest() {
+void MergingIterator::FindSmallest() {
   IteratorWrapper* smallest = nullptr;
-  int index = 0;
   for (int i = 0; i < n_; i++) {
     IteratorWrapper* child = &children_[i];
     if (child->Valid()) {
       if (smallest == nullptr) {
         smallest = child;
-        index = i;
       } else if (comparator_->Compare(child->key(), smallest->key()) < 0) {
         smallest = child;
-        index = i;
       }
     }
   }
   current_ = smallest;
-  return index;
-}
-
-// ##############
-int MergingIterator::FindSmallest(Remix *my_sorted_view, size_t &index_anchor_key, size_t &segment_index) {
-  //IteratorWrapper* smallest = nullptr;
-  Segment *seg = &my_sorted_view->segments[index_anchor_key];
-  int index;
-  if(segment_index+1 < seg->size){
-    index = seg->Run_Selectors[segment_index+1];
-    segment_index++;
-  }
-  else if(index_anchor_key + 1 < my_sorted_view->segment_size){
-    index = my_sorted_view->segments[index_anchor_key+1].Run_Selectors[0];
-    index_anchor_key++;
-  }
-  else{
-    index = -1;
-  }
-  
-  //current_ = smallest;
-  return index;
 }
 
 /**
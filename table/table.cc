@@ -239,6 +239,34 @@ Iterator* Table::NewIterator(const ReadOptions& options) const {
       &Table::BlockReader, const_cast<Table*>(this), options);
 }
 
+Iterator* Table::NewIndexIterator() const {
+  return rep_->index_block->NewIterator(rep_->options.comparator);
+}
+
+bool Table::SeekMayMatch(const Slice& target, const Slice& filter_key) const {
+  FilterBlockReader* filter = rep_->filter;
+  if (filter == nullptr) {
+    return true;
+  }
+  Iterator* iiter = rep_->index_block->NewIterator(rep_->options.comparator);
+  iiter->Seek(target);
+  // The entries at or after "target" start in the block found, or in the
+  // next one if all entries of the block found are before "target".
+  bool may_match = false;
+  for (int i = 0; i < 2 && iiter->Valid() && !may_match; i++) {
+    Slice handle_value = iiter->value();
+    BlockHandle handle;
+    may_match = !handle.DecodeFrom(&handle_value).ok() ||
+                filter->KeyMayMatch(handle.offset(), filter_key);
+    iiter->Next();
+  }
+  if (!iiter->status().ok()) {
+    may_match = true;  // Let the iterator report the error
+  }
+  delete iiter;
+  return may_match;
+}
+
 Status Table::InternalGet(const ReadOptions& options, const Slice& k, void* arg,
                           void (*handle_result)(void*, const Slice&,
                                                 const Slice&)) {
@@ -269,6 +297,53 @@ Status Table::InternalGet(const ReadOptions& options, const Slice& k, void* arg,
   return s;
 }
 
+Status Table::InternalMultiGet(const ReadOptions& options, int n,
+                               const Slice* keys, void* const* args,
+                               void (*handle_result)(void*, const Slice&,
+                                                     const Slice&)) {
+  Status s;
+  Iterator* iiter = rep_->index_block->NewIterator(rep_->options.comparator);
+  Iterator* block_iter = nullptr;
+  std::string block_handle;  // Encoded handle of the block of block_iter
+  for (int i = 0; i < n && s.ok(); i++) {
+    iiter->Seek(keys[i]);
+    if (!iiter->Valid()) {
+      // This key and all later ones are past the last block
+      break;
+    }
+    Slice handle_value = iiter->value();
+    FilterBlockReader* filter = rep_->filter;
+    BlockHandle handle;
+    if (filter != nullptr && handle.DecodeFrom(&handle_value).ok() &&
+        !filter->KeyMayMatch(handle.offset(), keys[i])) {
+      continue;  // Not found
+    }
+    if (block_iter == nullptr || iiter->value() != Slice(block_handle)) {
+      if (block_iter != nullptr) {
+        s = block_iter->status();
+        delete block_iter;
+      }
+      block_iter = BlockReader(this, options, iiter->value());
+      block_handle.assign(iiter->value().data(), iiter->value().size());
+    }
+    block_iter->Seek(keys[i]);
+    if (block_iter->Valid()) {
+      (*handle_result)(args[i], block_iter->key(), block_iter->value());
+    }
+  }
+  if (block_iter != nullptr) {
+    if (s.ok()) {
+      s = block_iter->status();
+    }
+    delete block_iter;
+  }
+  if (s.ok()) {
+    s = iiter->status();
+  }
+  delete iiter;
+  return s;
+}
+
 uint64_t Table::ApproximateOffsetOf(const Slice& key) const {
   Iterator* index_iter =
       rep_->index_block->NewIterator(rep_->options.comparator);
@@ -8,7 +8,6 @@
 #include "table/block.h"
 #include "table/format.h"
 #include "table/iterator_wrapper.h"
-#include "leveldb/RemixHelper.h"
 
 namespace leveldb {
 
@@ -31,11 +30,11 @@ class TwoLevelIterator : public Iterator {
   // 以下三个函数都是针对一级迭代器的函数
   // 这里就是seek到index block对应元素位置
   void Seek(const Slice& target) override;
-  int SeekToFirst() override;
+  void SeekToFirst() override;
   void SeekToLast() override;
   // 以下函数都是针对二级迭代器的函数
   // DataBlock中的下一个Entry
-  int Next() override;
+  void Next() override;
   // DataBlock中的前一个Entry
   void Prev() override;
   //指向DataBlock的迭代器是否有效
@@ -87,7 +86,6 @@ class TwoLevelIterator : public Iterator {
   // "index_value" passed to block_function_ to create the data_iter_.
   //对于SSTable来说,保存index block中的offset+size。
   std::string data_block_handle_;
-  int run_index; // !!!
 };
 
 TwoLevelIterator::TwoLevelIterator(Iterator* index_iter,
@@ -111,12 +109,11 @@ void TwoLevelIterator::Seek(const Slice& target) {
   SkipEmptyDataBlocksForward();
 }
 
-int TwoLevelIterator::SeekToFirst() {
+void TwoLevelIterator::SeekToFirst() {
   index_iter_.SeekToFirst();
   InitDataBlock();
   if (data_iter_.iter() != nullptr) data_iter_.SeekToFirst();
   SkipEmptyDataBlocksForward();
-  return 0;
 }
 
 void TwoLevelIterator::SeekToLast() {
@@ -126,11 +123,10 @@ void TwoLevelIterator::SeekToLast() {
   SkipEmptyDataBlocksBackward();
 }
 
-int TwoLevelIterator::Next() {
+void TwoLevelIterator::Next() {
   assert(Valid());
   data_iter_.Next();
   SkipEmptyDataBlocksForward();
-  return 0;
 }
 
 void TwoLevelIterator::Prev() {
@@ -4,12 +4,27 @@
 
 #include "util/arena.h"
 
+#include <new>
+
+#include "util/mutexlock.h"
+
 namespace leveldb {
 
 static const int kBlockSize = 4096;
+static const size_t kAlign = (sizeof(void*) > 8) ? sizeof(void*) : 8;
+
+// Header at the start of a block used by AllocateConcurrently()
+struct Arena::SharedBlock {
+  std::atomic<size_t> used;  // May exceed size after failed allocations
+  size_t size;
+  char* data;
+};
 
 Arena::Arena()
-    : alloc_ptr_(nullptr), alloc_bytes_remaining_(0), memory_usage_(0) {}
+    : alloc_ptr_(nullptr),
+      alloc_bytes_remaining_(0),
+      memory_usage_(0),
+      shared_block_(nullptr) {}
 
 Arena::~Arena() {
   for (size_t i = 0; i < blocks_.size(); i++) {
@@ -55,12 +70,59 @@ char* Arena::AllocateAligned(size_t bytes) {
   return result;
 }
 
+char* Arena::AllocateConcurrently(size_t bytes) {
+  assert(bytes > 0);
+  bytes = (bytes + kAlign - 1) & ~(kAlign - 1);
+  if (bytes > kBlockSize / 4) {
+    // Like AllocateFallback(), give large objects a block of their own
+    return AllocateNewBlock(bytes);
+  }
+
+  const size_t header_size = (sizeof(SharedBlock) + kAlign - 1) & ~(kAlign - 1);
+  SharedBlock* block = shared_block_.load(std::memory_order_acquire);
+  while (true) {
+    if (block != nullptr) {
+      const size_t offset =
+          block->used.fetch_add(bytes, std::memory_order_relaxed);
+      if (offset + bytes <= block->size) {
+        return block->data + offset;
+      }
+    }
+
+    // The block is used up.  Install a new one, unless another thread was
+    // faster, in which case the new block is freed and the allocation is
+    // retried in the block of that thread.  Only installed blocks count
+    // towards MemoryUsage().
+    char* memory = new char[kBlockSize];
+    SharedBlock* next = new (memory) SharedBlock;
+    next->used.store(0, std::memory_order_relaxed);
+    next->size = kBlockSize - header_size;
+    next->data = memory + header_size;
+    if (shared_block_.compare_exchange_strong(block, next,
+                                              std::memory_order_acq_rel,
+                                              std::memory_order_acquire)) {
+      AddBlock(memory, kBlockSize);
+      block = next;
+    } else {
+      next->~SharedBlock();
+      delete[] memory;
+    }
+  }
+}
+
 char* Arena::AllocateNewBlock(size_t block_bytes) {
   char* result = new char[block_bytes];
-  blocks_.push_back(result);
+  AddBlock(result, block_bytes);
+  return result;
+}
+
+void Arena::AddBlock(char* block, size_t block_bytes) {
+  {
+    MutexLock l(&mu_);
+    blocks_.push_back(block);
+  }
   memory_usage_.fetch_add(block_bytes + sizeof(char*),
                           std::memory_order_relaxed);
-  return result;
 }
 
 }  // namespace leveldb
@@ -19,6 +19,8 @@
 #include <cstdint>
 #include <vector>
 
+#include "port/port.h"
+
 namespace leveldb {
 
 class Arena {
@@ -38,6 +40,12 @@ class Arena {
   // 分配一个大小为bytes的内存，返回指向该内存的指针，且满足内存首地址满足对齐规则
   char* AllocateAligned(size_t bytes);
 
+  // Like AllocateAligned(), but may be called by several threads at once,
+  // also while another thread calls Allocate() or AllocateAligned().
+  // Threads claim memory from a shared block with an atomic add and only
+  // synchronize when that block is used up.
+  char* AllocateConcurrently(size_t bytes);
+
   // Returns an estimate of the total memory usage of data allocated
   // by the arena.
   // 返回内存池分配的总体内存空间大小
@@ -48,6 +56,10 @@ class Arena {
  private:
   char* AllocateFallback(size_t bytes);
   char* AllocateNewBlock(size_t block_bytes);
+  // Take ownership of "block" of "block_bytes" bytes.
+  void AddBlock(char* block, size_t block_bytes);
+
+  struct SharedBlock;
 
   // Allocation state
   char* alloc_ptr_;  // 指向当前最新Block的空闲部分的起始位置
@@ -62,6 +74,12 @@ class Arena {
   // TODO(costan): This member is accessed via atomics, but the others are
   //               accessed without any locking. Is this OK?
   std::atomic<size_t> memory_usage_;
+
+  // Block that AllocateConcurrently() currently allocates from
+  std::atomic<SharedBlock*> shared_block_;
+
+  // Protects blocks_
+  port::Mutex mu_;
 };
 
 inline char* Arena::Allocate(size_t bytes) {
@@ -4,6 +4,10 @@
 
 #include "util/arena.h"
 
+#include <cstring>
+#include <thread>
+#include <vector>
+
 #include "gtest/gtest.h"
 #include "util/random.h"
 
@@ -58,4 +62,63 @@ TEST(ArenaTest, Simple) {
   }
 }
 
+TEST(ArenaTest, Concurrent) {
+  static const int kThreads = 4;
+  static const int N = 20000;
+  Arena arena;
+  std::vector<std::pair<size_t, char*>> allocated[kThreads];
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; t++) {
+    threads.emplace_back([&arena, &allocated, t]() {
+      Random rnd(301 + t);
+      for (int i = 0; i < N; i++) {
+        const size_t s = rnd.OneIn(1000) ? 1 + rnd.Uniform(6000)
+                                         : 1 + rnd.Uniform(100);
+        char* r = arena.AllocateConcurrently(s);
+        // Also allocate from the unshared block on one thread
+        if (t == 0) arena.Allocate(1 + rnd.Uniform(20));
+        std::memset(r, t, s);
+        allocated[t].emplace_back(s, r);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  size_t bytes = 0;
+  for (int t = 0; t < kThreads; t++) {
+    for (const auto& allocation : allocated[t]) {
+      ASSERT_EQ(0, reinterpret_cast<uintptr_t>(allocation.second) & 7);
+      for (size_t b = 0; b < allocation.first; b++) {
+        ASSERT_EQ(t, allocation.second[b]);
+      }
+      bytes += allocation.first;
+    }
+  }
+  ASSERT_GE(arena.MemoryUsage(), bytes);
+}
+
+TEST(ArenaTest, ConcurrentMemoryUsage) {
+  static const int kThreads = 8;
+  static const int N = 100000;
+  Arena arena;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; t++) {
+    threads.emplace_back([&arena]() {
+      for (int i = 0; i < N; i++) {
+        arena.AllocateConcurrently(16);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  // Threads that lose the race to install a new block do not add theirs
+  const size_t bytes = kThreads * N * 16;
+  ASSERT_GE(arena.MemoryUsage(), bytes);
+  ASSERT_LE(arena.MemoryUsage(), bytes + bytes / 20);
+}
+
 }  // namespace leveldb
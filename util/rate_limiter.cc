@@ -0,0 +1,130 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "leveldb/rate_limiter.h"
+
+#include <algorithm>
+
+#include "leveldb/env.h"
+#include "port/port.h"
+#include "port/thread_annotations.h"
+#include "util/mutexlock.h"
+
+namespace leveldb {
+
+RateLimiter::~RateLimiter() {}
+
+namespace {
+
+// Tokens accrue at the current rate, up to a tenth of a second's worth.  A
+// request that finds too few tokens takes them anyway and sleeps until the
+// bucket is refilled to zero, so every later request also waits for the
+// debt of the earlier ones and requests are served in arrival order.
+class TokenBucketRateLimiter : public RateLimiter {
+ public:
+  TokenBucketRateLimiter(Env* env, int64_t bytes_per_second, bool auto_tuned)
+      : env_(env),
+        max_rate_(std::max<int64_t>(bytes_per_second, 1)),
+        auto_tuned_(auto_tuned),
+        rate_(auto_tuned ? MinRate() : max_rate_),
+        tokens_(0),
+        last_refill_micros_(env->NowMicros()),
+        bytes_through_(0),
+        bytes_throttled_(0) {}
+
+  void Request(size_t bytes) override {
+    uint64_t wait_micros = 0;
+    {
+      MutexLock l(&mu_);
+      Refill();
+      bytes_through_ += bytes;
+      tokens_ -= bytes;
+      if (tokens_ < 0) {
+        bytes_throttled_ += bytes;
+        wait_micros = static_cast<uint64_t>(-tokens_ * 1e6 / rate_);
+      }
+    }
+    if (wait_micros > 0) {
+      env_->SleepForMicroseconds(static_cast<int>(
+          std::min(wait_micros, static_cast<uint64_t>(kMaxWaitMicros))));
+    }
+  }
+
+  void Charge(size_t bytes) override {
+    MutexLock l(&mu_);
+    Refill();
+    bytes_through_ += bytes;
+    // Bound the debt so that a burst of log writes delays compactions by
+    // at most a second.
+    tokens_ = std::max<double>(tokens_ - bytes, -static_cast<double>(rate_));
+  }
+
+  void SetPendingCompactionBytes(uint64_t bytes) override {
+    if (!auto_tuned_) {
+      return;
+    }
+    MutexLock l(&mu_);
+    Refill();
+    const double full_rate_bytes =
+        static_cast<double>(max_rate_) * kFullRateDebtSeconds;
+    const double fraction = std::min(1.0, bytes / full_rate_bytes);
+    rate_ = MinRate() + static_cast<int64_t>((max_rate_ - MinRate()) *
+                                             fraction);
+  }
+
+  int64_t GetBytesPerSecond() const override {
+    MutexLock l(&mu_);
+    return rate_;
+  }
+
+  uint64_t GetTotalBytesThrough() const override {
+    MutexLock l(&mu_);
+    return bytes_through_;
+  }
+
+  uint64_t GetTotalBytesThrottled() const override {
+    MutexLock l(&mu_);
+    return bytes_throttled_;
+  }
+
+ private:
+  // Auto-tuned limiters reach max_rate_ once the pending compaction bytes
+  // would take this long to write at max_rate_.
+  static constexpr double kFullRateDebtSeconds = 10;
+
+  // Upper bound on one sleep, which keeps Env::SleepForMicroseconds() in
+  // range even if the rate is lowered while a large debt is outstanding.
+  static constexpr uint64_t kMaxWaitMicros = 10 * 1000 * 1000;
+
+  int64_t MinRate() const { return std::max<int64_t>(max_rate_ / 20, 1); }
+
+  void Refill() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    const uint64_t now = env_->NowMicros();
+    if (now > last_refill_micros_) {
+      tokens_ += (now - last_refill_micros_) * 1e-6 * rate_;
+      tokens_ = std::min<double>(tokens_, rate_ / 10.0);
+    }
+    last_refill_micros_ = now;
+  }
+
+  Env* const env_;
+  const int64_t max_rate_;
+  const bool auto_tuned_;
+
+  mutable port::Mutex mu_;
+  int64_t rate_ GUARDED_BY(mu_);
+  double tokens_ GUARDED_BY(mu_);  // Negative while requests wait
+  uint64_t last_refill_micros_ GUARDED_BY(mu_);
+  uint64_t bytes_through_ GUARDED_BY(mu_);
+  uint64_t bytes_throttled_ GUARDED_BY(mu_);
+};
+
+}  // namespace
+
+RateLimiter* NewRateLimiter(int64_t bytes_per_second, bool auto_tuned) {
+  return new TokenBucketRateLimiter(Env::Default(), bytes_per_second,
+                                    auto_tuned);
+}
+
+}  // namespace leveldb
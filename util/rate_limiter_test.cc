@@ -0,0 +1,63 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "leveldb/rate_limiter.h"
+
+#include <memory>
+
+#include "gtest/gtest.h"
+#include "leveldb/env.h"
+
+namespace leveldb {
+
+TEST(RateLimiterTest, Throttles) {
+  std::unique_ptr<RateLimiter> limiter(NewRateLimiter(1 << 20));
+  ASSERT_EQ(1 << 20, limiter->GetBytesPerSecond());
+
+  // The bucket starts empty, so a quarter of a megabyte takes about a
+  // quarter of a second.
+  Env* env = Env::Default();
+  const uint64_t start = env->NowMicros();
+  for (int i = 0; i < 64; i++) {
+    limiter->Request(4096);
+  }
+  const uint64_t elapsed = env->NowMicros() - start;
+  ASSERT_GE(elapsed, 200000);
+  ASSERT_LE(elapsed, 5000000);
+  ASSERT_EQ(64 * 4096, limiter->GetTotalBytesThrough());
+  ASSERT_GT(limiter->GetTotalBytesThrottled(), 0);
+}
+
+TEST(RateLimiterTest, ChargeDelaysRequests) {
+  std::unique_ptr<RateLimiter> limiter(NewRateLimiter(1 << 20));
+  limiter->Charge(256 << 10);
+  ASSERT_EQ(0, limiter->GetTotalBytesThrottled());
+
+  Env* env = Env::Default();
+  const uint64_t start = env->NowMicros();
+  limiter->Request(1);
+  ASSERT_GE(env->NowMicros() - start, 150000);
+  ASSERT_EQ((256 << 10) + 1, limiter->GetTotalBytesThrough());
+  ASSERT_EQ(1, limiter->GetTotalBytesThrottled());
+}
+
+TEST(RateLimiterTest, AutoTuned) {
+  std::unique_ptr<RateLimiter> limiter(NewRateLimiter(20 << 20, true));
+  ASSERT_EQ(1 << 20, limiter->GetBytesPerSecond());
+  limiter->SetPendingCompactionBytes(100 << 20);
+  const int64_t half = limiter->GetBytesPerSecond();
+  ASSERT_GT(half, 1 << 20);
+  ASSERT_LT(half, 20 << 20);
+  limiter->SetPendingCompactionBytes(1ull << 40);
+  ASSERT_EQ(20 << 20, limiter->GetBytesPerSecond());
+  limiter->SetPendingCompactionBytes(0);
+  ASSERT_EQ(1 << 20, limiter->GetBytesPerSecond());
+
+  // Limiters that are not auto-tuned ignore the pending bytes.
+  limiter.reset(NewRateLimiter(20 << 20));
+  limiter->SetPendingCompactionBytes(0);
+  ASSERT_EQ(20 << 20, limiter->GetBytesPerSecond());
+}
+
+}  // namespace leveldb
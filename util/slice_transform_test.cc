@@ -0,0 +1,24 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "leveldb/slice_transform.h"
+
+#include <memory>
+
+#include "gtest/gtest.h"
+
+namespace leveldb {
+
+TEST(SliceTransformTest, FixedPrefix) {
+  std::unique_ptr<const SliceTransform> transform(NewFixedPrefixTransform(3));
+  ASSERT_EQ(std::string("leveldb.FixedPrefix.3"), transform->Name());
+  ASSERT_FALSE(transform->InDomain(""));
+  ASSERT_FALSE(transform->InDomain("ab"));
+  ASSERT_TRUE(transform->InDomain("abc"));
+  ASSERT_TRUE(transform->InDomain("abcd"));
+  ASSERT_EQ("abc", transform->Transform("abc").ToString());
+  ASSERT_EQ("abc", transform->Transform("abcd").ToString());
+}
+
+}  // namespace leveldb